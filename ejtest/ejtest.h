@@ -1,11 +1,16 @@
 #ifndef EJ_TEST_H
 #define EJ_TEST_H
 
-#define EJ_TEST_VERSION 1.0.1
+#define EJ_TEST_VERSION 1.1.0
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 #define ejtest_expect_bool(p, a, b) ejtest_expect_bool_file_line((p), (a), (b), #a, #b, __FILE__, __LINE__)
 #define ejtest_expect_int(p, a, b) ejtest_expect_int_file_line((p), (a), (b), #a, #b,__FILE__, __LINE__)
@@ -23,8 +28,13 @@
 #define EJTEST_CRESET "\e[0m"
 //==============================================
 
+// Set when a test reports a failure, the runner uses it to know how the
+// test it just ran went
+static bool ejtest_case_failed = false;
+
 void ejtest_print_result(const char * name, bool result)
 {
+    if (!result) ejtest_case_failed = true;
     const char * colour = (result) ? EJTEST_GRN : EJTEST_RED;
     printf("%s== ", colour);
     printf("%-30s", name);
@@ -115,4 +125,320 @@ bool ejtest_expect_struct_file_line(
    *p = false;
    return *p;
 };
+//==============================================
+// Runner
+//
+// Tests are listed once in a table and handed to ejtest_main:
+//     static const EjtestCase tests[] = { EJTEST_CASE(testBools), ... };
+//     int main(int argc, char * argv[])
+//     { return ejtest_main(argc, argv, tests, EJTEST_ARRAY_SIZE(tests)); }
+//
+// Options:
+//  -l              list the tests and exit
+//  -f name         only run tests whose name contains name, can repeat
+//  -j jobs         run tests in this many processes at once (default 1,
+//                  which runs them in this process one after another)
+//  -o report       write a report, .json for JSON, anything else is CSV
+//  -b baseline     CSV report of an earlier run, flags tests that got slower
+//  -t percent      how much slower counts as a regression (default 50)
+//
+// Returns from ejtest_main: 0 when every test that ran passed
+//==============================================
+typedef void ejtest_func_t(void);
+
+typedef struct {
+    const char * name;
+    ejtest_func_t * func;
+} EjtestCase;
+
+typedef struct {
+    bool ran;
+    bool passed;
+    bool crashed;
+    bool regressed;
+    double ms;
+    double baseline_ms; // < 0: not in the baseline
+} EjtestResult;
+
+typedef struct {
+    const char * filters[32];
+    int filters_count;
+    int jobs;
+    const char * report_file;
+    const char * baseline_file;
+    double threshold;
+    bool list;
+} EjtestOptions;
+
+#define EJTEST_CASE(f) { #f, f }
+#define EJTEST_ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+// Tests faster than this are too noisy to call regressed
+#define EJTEST_REGRESSION_MIN_MS 0.5
+
+double ejtest_now_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000.0 + t.tv_nsec/1000000.0;
+}
+
+bool ejtest_parse_options(int argc, char * argv[], EjtestOptions * o)
+{
+    *o = (EjtestOptions){ .jobs = 1, .threshold = 50 };
+    for (int i = 1; i < argc; i++)
+    {
+        const char * arg = argv[i];
+        if (strcmp(arg, "-l") == 0) { o->list = true; continue; }
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i+1 >= argc) return false;
+
+        const char * value = argv[++i];
+        switch (arg[1]) {
+        case 'f':
+            if (o->filters_count >= (int) EJTEST_ARRAY_SIZE(o->filters)) return false;
+            o->filters[o->filters_count++] = value;
+            break;
+        case 'j': o->jobs = atoi(value); break;
+        case 'o': o->report_file = value; break;
+        case 'b': o->baseline_file = value; break;
+        case 't': o->threshold = atof(value); break;
+        default: return false;
+        }
+    }
+    if (o->jobs < 1) o->jobs = 1;
+    return o->threshold >= 0;
+}
+
+bool ejtest_selected(const EjtestOptions * o, const char * name)
+{
+    if (o->filters_count == 0) return true;
+    for (int i = 0; i < o->filters_count; i++)
+    {
+        if (strstr(name, o->filters[i]) != NULL) return true;
+    }
+    return false;
+}
+
+void ejtest_run_case(const EjtestCase * test, EjtestResult * result)
+{
+    ejtest_case_failed = false;
+    double start = ejtest_now_ms();
+    test->func();
+    result->ms = ejtest_now_ms() - start;
+    result->passed = !ejtest_case_failed;
+    result->ran = true;
+}
+
+// Every test gets its own process, its output is held back until it is done
+// so tests running at the same time do not mix their lines
+void ejtest_run_parallel(const EjtestCase * tests, int count, const bool * selected,
+        EjtestResult * results, int jobs)
+{
+    // Shared with the children, they fill in their own result
+    EjtestResult * shared = mmap(NULL, count*sizeof(EjtestResult), PROT_READ|PROT_WRITE,
+            MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        printf("Could not share results between processes, running one test at a time\n");
+        for (int i = 0; i < count; i++) if (selected[i]) ejtest_run_case(&tests[i], &results[i]);
+        return;
+    }
+    memcpy(shared, results, count*sizeof(EjtestResult));
+
+    typedef struct { pid_t pid; int index; FILE * output; } Running;
+    Running running[64];
+    if (jobs > (int) EJTEST_ARRAY_SIZE(running)) jobs = EJTEST_ARRAY_SIZE(running);
+    int running_count = 0;
+    int next = 0;
+
+    while (next < count || running_count > 0)
+    {
+        while (next < count && !selected[next]) next++;
+        if (next < count && running_count < jobs)
+        {
+            // Whatever is still buffered would be written again by the child
+            fflush(stdout);
+            FILE * output = tmpfile();
+            pid_t pid = (output != NULL) ? fork() : -1;
+            if (pid == 0)
+            {
+                dup2(fileno(output), STDOUT_FILENO);
+                ejtest_run_case(&tests[next], &shared[next]);
+                fflush(stdout);
+                _exit(0);
+            }
+            if (pid < 0)
+            {
+                // Run it here instead
+                if (output != NULL) fclose(output);
+                ejtest_run_case(&tests[next], &shared[next]);
+            } else
+            {
+                running[running_count++] = (Running){ pid, next, output };
+            }
+            next++;
+            continue;
+        }
+
+        int status = 0;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        for (int r = 0; r < running_count; r++)
+        {
+            if (running[r].pid != pid) continue;
+            EjtestResult * result = &shared[running[r].index];
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                result->ran = true;
+                result->passed = false;
+                result->crashed = true;
+            }
+
+            char buffer[4096];
+            size_t n;
+            rewind(running[r].output);
+            while ((n = fread(buffer, 1, sizeof(buffer), running[r].output)) > 0) fwrite(buffer, 1, n, stdout);
+            fclose(running[r].output);
+            if (result->crashed) ejtest_print_result(tests[running[r].index].name, false);
+
+            running[r] = running[--running_count];
+            break;
+        }
+    }
+
+    memcpy(results, shared, count*sizeof(EjtestResult));
+    munmap(shared, count*sizeof(EjtestResult));
+}
+
+// Baseline is a CSV report: name,passed,ms
+void ejtest_read_baseline(const EjtestOptions * o, const EjtestCase * tests, int count, EjtestResult * results)
+{
+    for (int i = 0; i < count; i++) results[i].baseline_ms = -1;
+    if (o->baseline_file == NULL) return;
+
+    FILE * file = fopen(o->baseline_file, "r");
+    if (file == NULL)
+    {
+        printf("Could not read baseline %s\n", o->baseline_file);
+        return;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char * comma = strchr(line, ',');
+        if (comma == NULL) continue;
+        *comma = '\0';
+        char * ms = strchr(comma+1, ',');
+        if (ms == NULL) continue;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(tests[i].name, line) == 0) results[i].baseline_ms = atof(ms+1);
+        }
+    }
+    fclose(file);
+}
+
+void ejtest_write_report(const EjtestOptions * o, const EjtestCase * tests, int count, const EjtestResult * results)
+{
+    if (o->report_file == NULL) return;
+    FILE * file = fopen(o->report_file, "w");
+    if (file == NULL)
+    {
+        printf("Could not write report %s\n", o->report_file);
+        return;
+    }
+
+    const char * ext = strrchr(o->report_file, '.');
+    bool json = ext != NULL && strcmp(ext, ".json") == 0;
+    if (json) fprintf(file, "{\n  \"tests\": [");
+    else fprintf(file, "name,passed,ms,baseline_ms,regressed\n");
+
+    bool first = true;
+    for (int i = 0; i < count; i++)
+    {
+        const EjtestResult * r = &results[i];
+        if (!r->ran) continue;
+        if (json)
+        {
+            fprintf(file, "%s\n    { \"name\": \"%s\", \"passed\": %s, \"crashed\": %s, \"ms\": %.6f, ",
+                    first ? "" : ",", tests[i].name, r->passed ? "true" : "false",
+                    r->crashed ? "true" : "false", r->ms);
+            if (r->baseline_ms >= 0) fprintf(file, "\"baseline_ms\": %.6f, ", r->baseline_ms);
+            else fprintf(file, "\"baseline_ms\": null, ");
+            fprintf(file, "\"regressed\": %s }", r->regressed ? "true" : "false");
+        } else
+        {
+            fprintf(file, "%s,%d,%.6f,%.6f,%d\n", tests[i].name, r->passed, r->ms, r->baseline_ms, r->regressed);
+        }
+        first = false;
+    }
+    if (json) fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+}
+
+int ejtest_main(int argc, char * argv[], const EjtestCase * tests, int count)
+{
+    EjtestOptions o;
+    if (!ejtest_parse_options(argc, argv, &o))
+    {
+        printf("Usage: %s [-l] [-f name]... [-j jobs] [-o report.json|report.csv] "
+               "[-b baseline.csv] [-t percent]\n", argv[0]);
+        return 2;
+    }
+
+    bool * selected = calloc(count, sizeof(bool));
+    EjtestResult * results = calloc(count, sizeof(EjtestResult));
+    if (selected == NULL || results == NULL) return 2;
+
+    int selected_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        selected[i] = ejtest_selected(&o, tests[i].name);
+        selected_count += selected[i];
+        if (o.list && selected[i]) printf("%s\n", tests[i].name);
+    }
+    if (o.list || selected_count == 0)
+    {
+        if (selected_count == 0) printf("No tests match the filters\n");
+        free(selected);
+        free(results);
+        return o.list ? 0 : 1;
+    }
+    ejtest_read_baseline(&o, tests, count, results);
+
+    double start = ejtest_now_ms();
+    if (o.jobs == 1)
+    {
+        for (int i = 0; i < count; i++) if (selected[i]) ejtest_run_case(&tests[i], &results[i]);
+    } else
+    {
+        ejtest_run_parallel(tests, count, selected, results, o.jobs);
+    }
+    double total_ms = ejtest_now_ms() - start;
+
+    int failed = 0, regressed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        EjtestResult * r = &results[i];
+        if (!r->ran) continue;
+        if (!r->passed) failed++;
+        if (r->baseline_ms < 0) continue;
+
+        r->regressed = r->ms - r->baseline_ms > EJTEST_REGRESSION_MIN_MS
+            && r->ms > r->baseline_ms * (1 + o.threshold/100);
+        if (!r->regressed) continue;
+        regressed++;
+        printf(EJTEST_YEL"== %-30s: slower, %.3fms (baseline %.3fms) =="EJTEST_CRESET"\n",
+                tests[i].name, r->ms, r->baseline_ms);
+    }
+
+    const char * colour = (failed == 0) ? EJTEST_GRN : EJTEST_RED;
+    printf("%s== %d tests: %d passed, %d failed, %d slower in %.3fms =="EJTEST_CRESET"\n",
+            colour, selected_count, selected_count - failed, failed, regressed, total_ms);
+    ejtest_write_report(&o, tests, count, results);
+
+    free(selected);
+    free(results);
+    return (failed == 0) ? 0 : 1;
+}
 #endif // EJ_TEST_H
@@ -1,79 +1,589 @@
 #define ELNOB_IMPLEMENTATION
 #include "elnob/elnob.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
 #include <sys/stat.h>
 #include <stdbool.h>
 
 //TODO: update this to latest version
 
-bool build_cli()
+// Usage: ./elnob.out [target] [profile]
+//  targets:  gui (default), module, test, diff, cli, lib, daemon, batch, bench, all
+//  profiles: debug (default), release, native, pgo
+// Everything a profile builds goes to build/<profile>/ so they can sit side
+// by side. Outputs newer than their sources (and the headers these include)
+// are skipped, independent compiles run at the same time
+
+typedef struct {
+    const char * name;
+    const char * flags[6]; // NULL terminated
+} BuildProfile;
+
+static const BuildProfile profiles[] = {
+    { "debug",   { "-ggdb", NULL } },
+    { "release", { "-O3", "-flto", "-DNDEBUG", NULL } },
+    { "native",  { "-O3", "-flto", "-march=native", "-DNDEBUG", NULL } },
+    // Same as release, plus the profile flags of the current PGO stage
+    { "pgo",     { "-O3", "-flto", "-DNDEBUG", NULL } },
+};
+static const BuildProfile * profile = &profiles[0];
+
+// A pgo build compiles every target twice: instrumented, then (after the
+// target's training run) with the recorded profile
+typedef enum {
+    PGO_OFF,
+    PGO_GENERATE,
+    PGO_USE,
+} PgoStage;
+static PgoStage pgo_stage = PGO_OFF;
+
+#define BUILD_DIR "build"
+#define PGO_DATA_DIR BUILD_DIR"/pgo/profile"
+#define CORPUS_DIR "./tests"
+
+static char out_dir[256];
+
+// build/<profile>/<file>, the strings are never freed, elnob exits soon
+const char * out_path(const char * file)
 {
-    const char * output = "./somp.out";
-    const char * compile[] = { "gcc", "-ggdb", "-o", output, "somp_cli.c","-lm", NULL }; 
-    if (!run_command_sync(ELNOB_ARRAY_SIZE(compile), compile)) return false;
-    const char * run[] = { output, NULL };
-    if (!run_command_sync(ELNOB_ARRAY_SIZE(run), run)) return false;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", out_dir, file);
+    return strdup(path);
+}
+
+bool select_profile(const char * name)
+{
+    for (size_t i = 0; i < ELNOB_ARRAY_SIZE(profiles); i++)
+    {
+        if (strcmp(profiles[i].name, name) != 0) continue;
+        profile = &profiles[i];
+        return true;
+    }
+    printf("Unknown profile %s, expected one of:", name);
+    for (size_t i = 0; i < ELNOB_ARRAY_SIZE(profiles); i++) printf(" %s", profiles[i].name);
+    printf("\n");
+    return false;
+}
+
+bool make_out_dir()
+{
+    snprintf(out_dir, sizeof(out_dir), "%s/%s", BUILD_DIR, profile->name);
+    mkdir(BUILD_DIR, 0755);
+    mkdir(out_dir, 0755);
+    if (strcmp(profile->name, "pgo") == 0) mkdir(PGO_DATA_DIR, 0755);
+
+    struct stat st;
+    if (stat(out_dir, &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        printf("Could not make %s\n", out_dir);
+        return false;
+    }
     return true;
 }
 
-bool build_tests()
+void append_profile_flags(Command * cmd)
+{
+    elnob_cmd_append_many(cmd, "-Wall", "-Wextra");
+    for (int i = 0; profile->flags[i] != NULL; i++) elnob_cmd_append(cmd, (char *) profile->flags[i]);
+
+    switch (pgo_stage) {
+    case PGO_OFF: break;
+    case PGO_GENERATE:
+        // The tests run on several threads
+        elnob_cmd_append_many(cmd, "-fprofile-generate="PGO_DATA_DIR, "-fprofile-update=atomic");
+        break;
+    case PGO_USE:
+        elnob_cmd_append_many(cmd, "-fprofile-use="PGO_DATA_DIR, "-fprofile-correction", "-Wno-missing-profile");
+        break;
+    }
+}
+
+void append_sdl_flags(Command * cmd)
+{
+    elnob_cmd_append_many(cmd, "-L./SDL/build/", "-I./SDL/include");
+    elnob_cmd_append_many(cmd, "-L./SDL3_ttf-3.2.2/build/", "-I./SDL3_ttf-3.2.2/include/");
+    elnob_cmd_append_many(cmd, "-Wl,-rpath,./SDL/build:./SDL3_ttf-3.2.2/build/");
+    elnob_cmd_append_many(cmd, "-lSDL3", "-lSDL3_ttf", "-lm");
+    elnob_cmd_append_many(cmd, "-DSDL_MAIN_HANDLED");
+}
+
+// ====================== JOBS ==========================================
+// Compiles run in the background, at most one per core. Anything that has
+// to wait for a compile (training, running the tests) calls wait_jobs first
+typedef struct {
+    pid_t pid;
+    const char * output;
+} Job;
+
+#define MAX_JOBS 64
+static Job jobs[MAX_JOBS];
+static int jobs_count = 0;
+static bool jobs_failed = false;
+
+int max_jobs()
 {
-    const char * compile[] = { "gcc","-Wall","-Wextra","-ggdb","-o","tester.out","somp_tester.c","-lm", NULL };
-    if (!run_command_sync(ELNOB_ARRAY_SIZE(compile), compile)) return false;
-    const char * run[] = { "./tester.out", NULL };
-    if (!run_command_sync(ELNOB_ARRAY_SIZE(run), run)) return false;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return 1;
+    return (cores > MAX_JOBS) ? MAX_JOBS : cores;
+}
 
+// Waits for one job to finish. A failed job loses its output so the next
+// run does not think it is up to date
+// Returns: false if the job failed
+bool wait_job(Job * done)
+{
+    *done = (Job){ -1, "" };
+    int status = 0;
+    pid_t pid = wait(&status);
+    if (pid < 0)
+    {
+        jobs_count = 0;
+        return false;
+    }
+
+    for (int i = 0; i < jobs_count; i++)
+    {
+        if (jobs[i].pid != pid) continue;
+        *done = jobs[i];
+        jobs[i] = jobs[--jobs_count];
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return true;
+
+        printf("ERROR: failed to build %s\n", done->output);
+        unlink(done->output);
+        jobs_failed = true;
+        return false;
+    }
     return true;
 }
 
-bool build_gui(Command cmd)
+// Returns: false if any job failed
+bool wait_jobs()
+{
+    Job done;
+    while (jobs_count > 0) wait_job(&done);
+    return !jobs_failed;
+}
+
+// Waits until the job building output is done, other jobs keep running
+// Returns: false if that job failed
+bool wait_output(const char * output)
+{
+    bool ok = true;
+    for (;;)
+    {
+        bool running = false;
+        for (int i = 0; i < jobs_count; i++) running |= strcmp(jobs[i].output, output) == 0;
+        if (!running) return ok;
+
+        Job done;
+        bool done_ok = wait_job(&done);
+        if (strcmp(done.output, output) == 0) ok = done_ok;
+    }
+}
+
+// Starts cmd in the background, it builds output
+bool start_cmd(Command * cmd, const char * output)
+{
+    Job done;
+    while (jobs_count >= max_jobs()) wait_job(&done);
+
+    // execvp needs the NULL at the end, it is kept out of the count so the
+    // command can still be printed
+    elnob_cmd_append(cmd, NULL);
+    cmd->count--;
+    printf("++ "); elnob_print_command(*cmd);
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0)
+    {
+        execvp(cmd->items[0], (char * const *) cmd->items);
+        printf("Failure: "); elnob_print_command(*cmd);
+        exit(69);
+    }
+    jobs[jobs_count++] = (Job){ pid, output };
+    return true;
+}
+// ======================================================================
+// ====================== DEPENDENCIES ==================================
+typedef struct {
+    char ** items;
+    int count;
+    int capacity;
+} Paths;
+
+static const char * elnob_exe = "./elnob.out";
+
+// Nanoseconds, a header saved in the same second as the last build still
+// counts as newer
+typedef long long mtime_ns_t;
+
+mtime_ns_t mtime_ns(const struct stat * st)
+{
+    return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+bool path_seen(Paths * seen, const char * path)
+{
+    for (int i = 0; i < seen->count; i++)
+    {
+        if (strcmp(seen->items[i], path) == 0) return true;
+    }
+    elnob_da_append(seen, strdup(path));
+    return false;
+}
+
+// Newest modification time of file and every header it includes with
+// quotes, include paths are relative to the including file. Missing files
+// are skipped, they are system headers or the compiler will complain
+mtime_ns_t newest_dependency(const char * file, Paths * seen)
+{
+    if (path_seen(seen, file)) return 0;
+
+    struct stat st;
+    if (stat(file, &st) != 0) return 0;
+    mtime_ns_t newest = mtime_ns(&st);
+
+    FILE * f = fopen(file, "r");
+    if (f == NULL) return newest;
+
+    const char * slash = strrchr(file, '/');
+    int dir_len = (slash == NULL) ? 0 : (slash - file) + 1;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char * c = line;
+        while (*c == ' ' || *c == '\t') c++;
+        if (*c++ != '#') continue;
+        while (*c == ' ' || *c == '\t') c++;
+        if (strncmp(c, "include", 7) != 0) continue;
+        c += 7;
+        while (*c == ' ' || *c == '\t') c++;
+        if (*c++ != '"') continue;
+        char * end = strchr(c, '"');
+        if (end == NULL) continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%.*s%.*s", dir_len, file, (int)(end - c), c);
+        mtime_ns_t t = newest_dependency(path, seen);
+        if (t > newest) newest = t;
+    }
+    fclose(f);
+    return newest;
+}
+
+// elnob itself counts as a dependency, the flags live in it
+bool up_to_date(const char * output, const char * source)
+{
+    struct stat out_stat, exe_stat;
+    if (stat(output, &out_stat) != 0) return false;
+    if (stat(elnob_exe, &exe_stat) == 0 && mtime_ns(&exe_stat) > mtime_ns(&out_stat)) return false;
+
+    Paths seen = {0};
+    mtime_ns_t newest = newest_dependency(source, &seen);
+    for (int i = 0; i < seen.count; i++) free(seen.items[i]);
+    free(seen.items);
+
+    return newest != 0 && newest <= mtime_ns(&out_stat);
+}
+// ======================================================================
+
+// Runs argv with stdin read from input, like `argv < input`, or with the
+// normal stdin when input is NULL. Waits only for its own process so the
+// background compiles are left alone
+bool run_with_stdin(const char * argv[], const char * input)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0)
+    {
+        if (input != NULL)
+        {
+            int fd = open(input, O_RDONLY);
+            if (fd < 0 || dup2(fd, STDIN_FILENO) < 0) exit(69);
+            close(fd);
+        }
+        execvp(argv[0], (char * const *) argv);
+        exit(69);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) return false;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return true;
+    printf("ERROR: failed to run %s\n", argv[0]);
+    return false;
+}
+
+typedef bool compile_func_t(Command cmd);
+typedef bool train_func_t(void);
+// ====================== CORPUS ========================================
+typedef bool corpus_func_t(const char * case_file);
+
+// Calls func for every .txt case in the corpus
+bool for_each_corpus_case(corpus_func_t * func)
+{
+    DIR * dir = opendir(CORPUS_DIR);
+    if (dir == NULL) return false;
+
+    bool ok = true;
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        size_t len = strlen(entry->d_name);
+        if (len < 4 || strcmp(entry->d_name + len - 4, ".txt") != 0) continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", CORPUS_DIR, entry->d_name);
+        if (!func(path)) ok = false;
+    }
+    closedir(dir);
+    return ok;
+}
+// ======================================================================
+// ====================== CLI ===========================================
+bool compile_cli(Command cmd)
+{
+    cmd.count = 0;
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path("somp.out"), "somp_cli.c", "-lm");
+    return start_cmd(&cmd, out_path("somp.out"));
+}
+bool train_cli_case(const char * case_file)
+{
+    const char * run[] = { out_path("somp.out"), NULL };
+    return run_with_stdin(run, case_file);
+}
+bool train_cli()
+{
+    return for_each_corpus_case(train_cli_case);
+}
+bool run_cli()
+{
+    const char * run[] = { out_path("somp.out"), NULL };
+    return run_with_stdin(run, NULL);
+}
+// ======================================================================
+// ====================== LIBRARY =======================================
+// libsomp.so, only the functions in libsomp.h are exported
+bool compile_lib(Command cmd)
+{
+    cmd.count = 0;
+    elnob_cmd_append_many(&cmd, "gcc", "-fPIC", "-shared", "-fvisibility=hidden");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path("libsomp.so"), "somp_lib.c", "-lm");
+    return start_cmd(&cmd, out_path("libsomp.so"));
+}
+// ======================================================================
+// ====================== DAEMON ========================================
+bool compile_daemon(Command cmd)
+{
+    cmd.count = 0;
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-pthread", "-o", (char *) out_path("somp_daemon.out"), "somp_daemon.c", "-lm");
+    return start_cmd(&cmd, out_path("somp_daemon.out"));
+}
+// ======================================================================
+// ====================== TESTS =========================================
+bool compile_tests(Command cmd)
+{
+    cmd.count = 0;
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-pthread", "-o", (char *) out_path("tester.out"), "somp_tester.c", "-lm");
+    return start_cmd(&cmd, out_path("tester.out"));
+}
+bool run_tests()
+{
+    const char * run[] = { out_path("tester.out"), NULL };
+    return run_with_stdin(run, NULL);
+}
+// Differential test of the solver against the long double reference
+bool compile_diff(Command cmd)
+{
+    cmd.count = 0;
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path("somp_diff.out"), "somp_diff.c", "-lm");
+    return start_cmd(&cmd, out_path("somp_diff.out"));
+}
+bool run_diff()
+{
+    const char * run[] = { out_path("somp_diff.out"), NULL };
+    return run_with_stdin(run, NULL);
+}
+bool train_diff()
+{
+    const char * run[] = { out_path("somp_diff.out"), "-n", "100000", NULL };
+    return run_with_stdin(run, NULL);
+}
+// ======================================================================
+// ====================== GUI ===========================================
+// Only the hot reloadable part of the gui, somp_hot runs this in the
+// background whenever a source file changes
+bool compile_gui_module(Command cmd)
 {
     cmd.count = 0;
-#define SOMP_HOTRELOAD
-#ifndef SOMP_HOTRELOAD
-    elnob_cmd_append_many(&cmd, "gcc","-Wall","-Wextra","-ggdb");
-    elnob_cmd_append_many(&cmd, "-o","somp_gui.out","somp_gui.c");
-    elnob_cmd_append_many(&cmd, "-L./SDL/build/", "-I./SDL/include");
-    elnob_cmd_append_many(&cmd, "-L./SDL3_ttf-3.2.2/build/", "-I./SDL3_ttf-3.2.2/include/");
-    elnob_cmd_append_many(&cmd, "-Wl,-rpath,./SDL/build,./SDL3_ttf-3.2.2/build/");
-    elnob_cmd_append_many(&cmd, "-lSDL3", "-lm");
-    if (!elnob_run_command_sync(cmd)) return false;
-#else
-    elnob_cmd_append_many(&cmd, "gcc", "-fPIC", "-shared", "-Wall","-Wextra","-ggdb");
-    elnob_cmd_append_many(&cmd, "-o","somp_gui.so","somp_gui.c");
-    elnob_cmd_append_many(&cmd, "-L./SDL/build/", "-I./SDL/include");
-    elnob_cmd_append_many(&cmd, "-L./SDL3_ttf-3.2.2/build/", "-I./SDL3_ttf-3.2.2/include/");
-    elnob_cmd_append_many(&cmd, "-Wl,-rpath,./SDL/build:./SDL3_ttf-3.2.2/build/");
-    elnob_cmd_append_many(&cmd, "-lSDL3", "-lSDL3_ttf", "-lm");
-    elnob_cmd_append_many(&cmd, "-DSDL_MAIN_HANDLED");
-    if (!elnob_run_command_sync(cmd)) return false;
+    elnob_cmd_append_many(&cmd, "gcc", "-fPIC", "-shared");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path("somp_gui.so"), "somp_gui.c");
+    append_sdl_flags(&cmd);
+    return start_cmd(&cmd, out_path("somp_gui.so"));
+}
+
+bool compile_gui_host(Command cmd)
+{
+    // The host rebuilds and loads the module of its own profile
+    char module_define[512], build_define[512];
+    snprintf(module_define, sizeof(module_define), "-DSOMP_MODULE_PATH=\"%s\"", out_path("somp_gui.so"));
+    snprintf(build_define, sizeof(build_define), "-DSOMP_BUILD_COMMAND=\"./elnob.out module %s\"", profile->name);
 
     cmd.count = 0;
-    elnob_cmd_append_many(&cmd, "gcc", "-Wall","-Wextra","-ggdb");
-    elnob_cmd_append_many(&cmd, "-o","somp.out","somp_hot.c");
-    elnob_cmd_append_many(&cmd, "-Wl,-rpath,.", "-ldl");
-    if (!elnob_run_command_sync(cmd)) return false;
-#endif
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path("somp_hot.out"), "somp_hot.c");
+    elnob_cmd_append_many(&cmd, strdup(module_define), strdup(build_define));
+    elnob_cmd_append_many(&cmd, "-Wl,-rpath,.", "-ldl", "-pthread");
+    return start_cmd(&cmd, out_path("somp_hot.out"));
+}
+// ======================================================================
+// ====================== HEADLESS TOOLS ================================
+// Tools that include somp_gui.c but draw without a window (somp_batch.c,
+// somp_bench.c)
+bool compile_headless_tool(Command cmd, const char * output, const char * source)
+{
+    cmd.count = 0;
+    elnob_cmd_append(&cmd, "gcc");
+    append_profile_flags(&cmd);
+    elnob_cmd_append_many(&cmd, "-o", (char *) out_path(output), (char *) source);
+    append_sdl_flags(&cmd);
+    return start_cmd(&cmd, out_path(output));
+}
+bool compile_batch(Command cmd) { return compile_headless_tool(cmd, "somp_batch.out", "somp_batch.c"); }
+bool compile_bench(Command cmd) { return compile_headless_tool(cmd, "somp_bench.out", "somp_bench.c"); }
 
-    return true;
+bool train_batch()
+{
+    const char * images = out_path("training_images");
+    mkdir(images, 0755);
+    const char * run[] = { out_path("somp_batch.out"), "-o", images,
+        CORPUS_DIR"/example_6_2.txt", CORPUS_DIR"/example_6_7.txt",
+        CORPUS_DIR"/example_a.txt", CORPUS_DIR"/example_c.txt", NULL };
+    return run_with_stdin(run, NULL);
 }
+bool train_bench()
+{
+    const char * run[] = { out_path("somp_bench.out"), "-n", "200", "-p", "50", "-d", "20", NULL };
+    return run_with_stdin(run, NULL);
+}
+// ======================================================================
+// ====================== TARGETS =======================================
+typedef struct {
+    const char * name;
+    const char * output; // in build/<profile>/
+    const char * source;
+    compile_func_t * compile;
+    train_func_t * train; // NULL: pgo builds it without a profile
+} Target;
+
+static const Target targets[] = {
+    { "test",   "tester.out",      "somp_tester.c", compile_tests,      run_tests   },
+    { "diff",   "somp_diff.out",   "somp_diff.c",   compile_diff,       train_diff  },
+    { "cli",    "somp.out",        "somp_cli.c",    compile_cli,        train_cli   },
+    { "lib",    "libsomp.so",      "somp_lib.c",    compile_lib,        NULL        },
+    { "daemon", "somp_daemon.out", "somp_daemon.c", compile_daemon,     NULL        },
+    { "module", "somp_gui.so",     "somp_gui.c",    compile_gui_module, NULL        },
+    { "gui",    "somp_hot.out",    "somp_hot.c",    compile_gui_host,   NULL        },
+    { "batch",  "somp_batch.out",  "somp_batch.c",  compile_batch,      train_batch },
+    { "bench",  "somp_bench.out",  "somp_bench.c",  compile_bench,      train_bench },
+};
+
+const Target * find_target(const char * name)
+{
+    for (size_t i = 0; i < ELNOB_ARRAY_SIZE(targets); i++)
+    {
+        if (strcmp(targets[i].name, name) == 0) return &targets[i];
+    }
+    return NULL;
+}
+
+// Starts the compile of target unless it is up to date. For pgo: compile
+// instrumented, train, then compile again into the same output (gcc finds
+// the profile data by output name), so only that target waits for itself
+bool build_target(const Target * target, Command cmd)
+{
+    const char * output = out_path(target->output);
+    if (up_to_date(output, target->source))
+    {
+        printf("%s is up to date\n", output);
+        return true;
+    }
+
+    if (strcmp(profile->name, "pgo") != 0) return target->compile(cmd);
+    if (target->train == NULL)
+    {
+        printf("No training run for %s, building it without a profile\n", target->name);
+        pgo_stage = PGO_OFF;
+        return target->compile(cmd);
+    }
+
+    pgo_stage = PGO_GENERATE;
+    bool ok = target->compile(cmd) && wait_output(output);
+    pgo_stage = PGO_OFF;
+    if (ok && !target->train()) printf("Training run failed, using whatever profile it left behind\n");
+
+    pgo_stage = PGO_USE;
+    if (ok) ok = target->compile(cmd);
+    pgo_stage = PGO_OFF;
+    return ok;
+}
+// ======================================================================
 
 int main(int argc, const char * argv[])
 {
     elnob_rebuild_elnob(argc, argv);
+    elnob_exe = argv[0];
 
     elnob_run_msg();
     Command cmd = {0};
 
-    if (argc > 1)
+    const char * name = (argc > 1) ? argv[1] : "gui";
+    if (argc > 2 && !select_profile(argv[2])) return 1;
+
+    bool all = strcmp(name, "all") == 0;
+    const Target * target = find_target(name);
+    if (target == NULL && !all)
     {
-        if(strcmp(argv[1], "test") == 0 && !build_tests()) return 1;
-        else if(strcmp(argv[1], "gui") == 0 && !build_gui(cmd)) return 1;
-        else if(strcmp(argv[1], "cli") == 0 && !build_cli()) return 1;
+        printf("Unknown target %s, expected one of: all", name);
+        for (size_t i = 0; i < ELNOB_ARRAY_SIZE(targets); i++) printf(" %s", targets[i].name);
+        printf("\n");
+        return 1;
+    }
+    if (!make_out_dir()) return 1;
+
+    bool ok = true;
+    if (all)
+    {
+        for (size_t i = 0; i < ELNOB_ARRAY_SIZE(targets); i++) ok &= build_target(&targets[i], cmd);
     } else
     {
-        if (!build_gui(cmd)) return 1;
+        // The gui host is useless without its module
+        if (strcmp(name, "gui") == 0) ok &= build_target(find_target("module"), cmd);
+        ok &= build_target(target, cmd);
     }
+    ok &= wait_jobs();
+    if (!ok) return 1;
+
+    if (all) return 0;
+    if (strcmp(name, "test") == 0) return run_tests() ? 0 : 1;
+    if (strcmp(name, "diff") == 0) return run_diff() ? 0 : 1;
+    if (strcmp(name, "cli") == 0) return run_cli() ? 0 : 1;
     return 0;
 }
@@ -83,8 +83,8 @@ int elnob_rebuild_elnob(int argc, const char * argv[])
         const char * compile[] = {"cc", "-g", "-o", exec_name, "elnob.c", NULL};
         if (!run_command_sync(ELNOB_ARRAY_SIZE(compile), compile)) return 0;
 
-        const char * rerun[] = { exec_name ,NULL};
-        if (!run_command_sync(ELNOB_ARRAY_SIZE(rerun), rerun)) return 0;
+        // Rerun with the same arguments, argv[argc] is always NULL
+        if (!run_command_sync(argc+1, argv)) return 0;
         exit(0);
     }
     return 1;
@@ -141,6 +141,7 @@ int run_command_sync(int argc, const char * argv[])
 		printf("Command %s must be terminated by NULL\n", argv[0]);
 		return 0;
 	}
+	fflush(stdout);
 	pid_t pid = fork();
 
 	if (pid == 0)
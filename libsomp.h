@@ -0,0 +1,131 @@
+#ifndef LIBSOMP_H
+#define LIBSOMP_H
+
+/*
+* Filename:	libsomp.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Public interface of libsomp, the beam solver as a shared library.
+* Everything a solve needs lives in a LibsompSolver, there are no globals,
+* so every thread can solve at the same time as long as each one has its
+* own solver
+*
+* The layout of the structs below does not change within a major version
+*
+* Example:
+*     LibsompSolver * solver = libsomp_solver_new();
+*     LibsompPointForce pf = { 1.0, 10.0 };
+*     if (libsomp_solve(solver, 2.0, &pf, 1, NULL, 0) == LIBSOMP_OK)
+*         printf("%f\n", libsomp_moment_at(solver, 0.5));
+*     libsomp_solver_free(solver);
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define LIBSOMP_API __attribute__((visibility("default")))
+#else
+#define LIBSOMP_API
+#endif
+
+#define LIBSOMP_VERSION_MAJOR 1
+#define LIBSOMP_VERSION_MINOR 2
+#define LIBSOMP_MAX_POLYNOMIAL_DEGREE 4
+
+typedef struct LibsompSolver LibsompSolver;
+
+typedef struct {
+	float distance;
+	float force;
+} LibsompPointForce;
+
+// polynomial[k] is the coefficient of x^k, x measured from the wall
+typedef struct {
+	float start;
+	float end;
+	float polynomial[LIBSOMP_MAX_POLYNOMIAL_DEGREE];
+} LibsompDistributedForce;
+
+typedef struct {
+	float start;
+	float end;
+	float point_force;
+	float polynomial[LIBSOMP_MAX_POLYNOMIAL_DEGREE];
+} LibsompSection;
+
+typedef enum {
+	LIBSOMP_OK = 0,
+	LIBSOMP_ERROR_ARGUMENT,          // NULL solver, negative counts...
+	LIBSOMP_ERROR_TOO_MANY_SECTIONS, // forces split the beam too often
+	LIBSOMP_ERROR_MEMORY,
+	LIBSOMP_ERROR_NOT_SOLVED,        // no successful solve yet
+} LibsompStatus;
+
+// Since 1.1. A new solver is a cantilever: fixed at x = 0, free at the end
+typedef enum {
+	LIBSOMP_SUPPORT_DEFAULT = 0,
+	LIBSOMP_SUPPORT_FREE,
+	LIBSOMP_SUPPORT_PIN,
+	LIBSOMP_SUPPORT_ROLLER,
+	LIBSOMP_SUPPORT_FIXED,
+} LibsompSupport;
+
+typedef enum {
+	LIBSOMP_SECTIONS_LOAD,
+	LIBSOMP_SECTIONS_SHEAR,
+	LIBSOMP_SECTIONS_MOMENT,
+} LibsompSectionKind;
+
+// Returns: LIBSOMP_VERSION_MAJOR*1000 + LIBSOMP_VERSION_MINOR of the library
+// that is loaded, which may be newer than the header
+LIBSOMP_API int libsomp_version(void);
+LIBSOMP_API const char * libsomp_status_string(LibsompStatus status);
+
+// Returns: NULL when out of memory
+LIBSOMP_API LibsompSolver * libsomp_solver_new(void);
+LIBSOMP_API void libsomp_solver_free(LibsompSolver * solver);
+
+// Solves a beam of the given length on the supports of the solver (by
+// default a cantilever fixed at x = 0). The forces are only read, the
+// result stays in the solver until the next solve
+LIBSOMP_API LibsompStatus libsomp_solve(LibsompSolver * solver, float length,
+		const LibsompPointForce * point_forces, int point_forces_count,
+		const LibsompDistributedForce * distributed_forces, int distributed_forces_count);
+
+// Since 1.1. Supports for the next solves, the reactions are at x = 0 (wall)
+// and x = length (end)
+// Returns: LIBSOMP_ERROR_ARGUMENT when they do not hold the beam in place
+LIBSOMP_API LibsompStatus libsomp_set_supports(LibsompSolver * solver, LibsompSupport left, LibsompSupport right);
+
+// Results of the last successful solve, 0 when there was none
+LIBSOMP_API float libsomp_wall_reaction_force(const LibsompSolver * solver);
+LIBSOMP_API float libsomp_wall_reaction_moment(const LibsompSolver * solver);
+LIBSOMP_API float libsomp_end_reaction_force(const LibsompSolver * solver);
+LIBSOMP_API float libsomp_end_reaction_moment(const LibsompSolver * solver);
+LIBSOMP_API float libsomp_shear_at(const LibsompSolver * solver, float x);
+LIBSOMP_API float libsomp_moment_at(const LibsompSolver * solver, float x);
+LIBSOMP_API int libsomp_sections_count(const LibsompSolver * solver);
+
+// Copies up to capacity sections into dest
+// Returns: LIBSOMP_ERROR_ARGUMENT when capacity is less than
+// libsomp_sections_count
+LIBSOMP_API LibsompStatus libsomp_get_sections(const LibsompSolver * solver,
+		LibsompSectionKind kind, LibsompSection * dest, int capacity);
+
+// Since 1.2. The shear or moment at count stations xs, in linear time when
+// they are sorted from small to big (any order works). right gets the value
+// just right of x, left (can be NULL) the value just left of it: the two
+// differ where a point force or moment is applied. xs, left and right can
+// not overlap
+// Returns: LIBSOMP_ERROR_ARGUMENT for LIBSOMP_SECTIONS_LOAD
+LIBSOMP_API LibsompStatus libsomp_sample(const LibsompSolver * solver,
+		LibsompSectionKind kind, const float * xs, int count, float * left, float * right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBSOMP_H
@@ -0,0 +1,211 @@
+/*
+* Filename:	somp_batch.c
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Headless rendering of beams and their diagrams to image files, for
+* reports. Uses the software renderer on a plain surface so no window or
+* display server is needed, load cases are split between worker processes
+*
+* Usage: somp_batch.out [-j jobs] [-o dir] [-s WxH] [-f font.ttf] case.txt...
+* Every case file uses the same format as the cli (see read_case_cli) and
+* is written to dir/<case name>.bmp
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "somp_gui.c"
+#include "somp_headless.h"
+
+#define SOMP_IO_IMPLEMENTATION
+#include "somp_io.h"
+
+#define DEFAULT_IMAGE_WIDTH 1200
+#define DEFAULT_IMAGE_HEIGHT 900
+#define DEFAULT_FONT_FILE LIBERATION_SERIF_FILE
+
+typedef struct {
+    int jobs;
+    const char * out_dir;
+    const char * font_file;
+    int width;
+    int height;
+    char ** cases;
+    int cases_count;
+} BatchOptions;
+
+static void usage(const char * program)
+{
+    fprintf(stderr, "Usage: %s [-j jobs] [-o dir] [-s WxH] [-f font.ttf] case.txt...\n", program);
+}
+
+static bool parse_options(int argc, char * argv[], BatchOptions * options)
+{
+    *options = (BatchOptions){
+        .jobs = sysconf(_SC_NPROCESSORS_ONLN),
+        .out_dir = ".",
+        .font_file = DEFAULT_FONT_FILE,
+        .width = DEFAULT_IMAGE_WIDTH,
+        .height = DEFAULT_IMAGE_HEIGHT,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:o:s:f:")) != -1)
+    {
+        switch (opt) {
+        case 'j': options->jobs = atoi(optarg); break;
+        case 'o': options->out_dir = optarg; break;
+        case 'f': options->font_file = optarg; break;
+        case 's':
+            if (sscanf(optarg, "%dx%d", &options->width, &options->height) != 2) return false;
+            break;
+        default: return false;
+        }
+    }
+    if (options->jobs < 1) options->jobs = 1;
+    if (options->width < 16 || options->height < 16) return false;
+
+    options->cases = &argv[optind];
+    options->cases_count = argc - optind;
+    return options->cases_count > 0;
+}
+
+// dir/<file name without directories and extension>.bmp
+static void image_path(char * dest, size_t size, const char * out_dir, const char * case_file)
+{
+    const char * name = strrchr(case_file, '/');
+    name = (name == NULL) ? case_file : name+1;
+    int name_len = strcspn(name, ".");
+    snprintf(dest, size, "%s/%.*s.bmp", out_dir, name_len, name);
+}
+
+static bool render_case(HeadlessRenderer * hr, const BatchOptions * options, const char * case_file)
+{
+    FILE * file = fopen(case_file, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: could not open\n", case_file);
+        return false;
+    }
+
+    Beam beam = {0};
+    PointForces pfs = {0};
+    DistributedForces dfs = {0};
+    somp_section_solve_t * S = &somp_state->solve;
+    DynamicArrayClear(&S->point_moments);
+    DynamicArrayClear(&S->distr_moments);
+    // The diagrams only show bending, axial forces and torques are read so
+    // every cli case file renders and then dropped
+    PointForces pas = {0};
+    DistributedForces das = {0};
+    PointMoments pts = {0};
+    DistributedMoments dts = {0};
+    CaseArrays arrays = { &pfs, &dfs, &S->point_moments, &S->distr_moments, &pas, &das, &pts, &dts };
+    bool ok = read_case_cli(file, &beam, &arrays);
+    fclose(file);
+    free(pas.items);
+    free(das.items);
+    free(pts.items);
+    free(dts.items);
+
+    sorted_pf_clear(&S->point_forces);
+    sorted_df_clear(&S->distr_forces);
+    for (int i = 0; ok && i < pfs.count; i++) ok = sorted_pf_insert(&S->point_forces, pfs.items[i]) != NO_FORCE_HANDLE;
+    for (int i = 0; ok && i < dfs.count; i++) ok = sorted_df_insert(&S->distr_forces, dfs.items[i]) != NO_FORCE_HANDLE;
+    free(pfs.items);
+    free(dfs.items);
+
+    S->beam = beam;
+    if (ok) ok = solve_state_beam(S);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: could not read or solve the beam\n", case_file);
+        return false;
+    }
+
+    // Beam on top, shear and moment diagrams below it
+    const float w = options->width, h = options->height;
+    SompBoundary boundary_solve = { 0, 0,       w, 0.5*h  };
+    SompBoundary boundary_2     = { 0, 0.5*h,   w, 0.25*h };
+    SompBoundary boundary_3     = { 0, 0.75*h,  w, 0.25*h };
+
+    SDL_SetRenderDrawColor(hr->renderer, COLOR_HIBB_BACKGROUND);
+    SDL_RenderClear(hr->renderer);
+    render_solve_scene(boundary_solve);
+    somp_section_2(boundary_2);
+    somp_section_3(boundary_3);
+    SDL_RenderPresent(hr->renderer);
+    gui_reset(&gui);
+
+    char path[4096];
+    image_path(path, sizeof(path), options->out_dir, case_file);
+    if (!SDL_SaveBMP(hr->surface, path))
+    {
+        fprintf(stderr, "%s: %s\n", path, SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// Worker k renders cases k, k+jobs, k+2*jobs...
+// Returns: number of cases that failed
+static int run_worker(const BatchOptions * options, int worker)
+{
+    HeadlessRenderer hr;
+    if (!headless_init(&hr, options->width, options->height, options->font_file))
+    {
+        fprintf(stderr, "Worker %d: could not set up the renderer: %s\n", worker, SDL_GetError());
+        headless_free(&hr);
+        return options->cases_count;
+    }
+
+    int failed = 0;
+    for (int i = worker; i < options->cases_count; i += options->jobs)
+    {
+        if (!render_case(&hr, options, options->cases[i])) failed++;
+    }
+
+    headless_free(&hr);
+    return failed;
+}
+
+int main(int argc, char * argv[])
+{
+    BatchOptions options;
+    if (!parse_options(argc, argv, &options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.jobs > options.cases_count) options.jobs = options.cases_count;
+
+    if (options.jobs == 1) return (run_worker(&options, 0) == 0) ? 0 : 1;
+
+    // Separate processes so each worker owns its SDL and font state
+    int started = 0;
+    bool ok = true;
+    for (int k = 0; k < options.jobs; k++)
+    {
+        pid_t pid = fork();
+        if (pid == 0) exit((run_worker(&options, k) == 0) ? 0 : 1);
+        if (pid < 0)
+        {
+            fprintf(stderr, "Could not start worker %d\n", k);
+            ok = false;
+            break;
+        }
+        started++;
+    }
+
+    for (int k = 0; k < started; k++)
+    {
+        int status = 0;
+        if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
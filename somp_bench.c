@@ -0,0 +1,275 @@
+/*
+* Filename:	somp_bench.c
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Headless frame benchmark of the gui. Replays events recorded with
+* SOMP_RECORD=<file> (or a mouse sweep over the beam when there is no
+* recording) one frame at a time without waiting between frames, and
+* reports how long every frame took
+*
+* A recording is replayed on its own frames: every frame it went through is
+* rendered, also the ones without events. The surface takes the window size
+* the recording starts with unless -s is given, window events are not
+* replayed since the surface never changes size
+*
+* Usage: somp_bench.out [-r recording] [-n frames] [-p point forces]
+*                       [-d distributed forces] [-s WxH] [-f font.ttf] [-c frames.csv]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "somp_gui.c"
+#include "somp_headless.h"
+
+#define DEFAULT_FRAMES 300
+
+typedef struct {
+    const char * recording;
+    const char * font_file;
+    const char * csv_file;
+    int frames;
+    int point_forces;
+    int distr_forces;
+    int width;
+    int height;
+    bool size_given;
+} BenchOptions;
+
+typedef struct {
+    SompRecordedEvent * items;
+    int count;
+    int capacity;
+} RecordedEvents;
+
+typedef struct {
+    double * items;
+    int count;
+    int capacity;
+} FrameTimes;
+
+static void usage(const char * program)
+{
+    fprintf(stderr, "Usage: %s [-r recording] [-n frames] [-p point forces] "
+            "[-d distributed forces] [-s WxH] [-f font.ttf] [-c frames.csv]\n", program);
+}
+
+static bool parse_options(int argc, char * argv[], BenchOptions * options)
+{
+    *options = (BenchOptions){
+        .font_file = LIBERATION_SERIF_FILE,
+        .frames = DEFAULT_FRAMES,
+        .width = 1200,
+        .height = 900,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:n:p:d:s:f:c:")) != -1)
+    {
+        switch (opt) {
+        case 'r': options->recording = optarg; break;
+        case 'n': options->frames = atoi(optarg); break;
+        case 'p': options->point_forces = atoi(optarg); break;
+        case 'd': options->distr_forces = atoi(optarg); break;
+        case 'f': options->font_file = optarg; break;
+        case 'c': options->csv_file = optarg; break;
+        case 's':
+            if (sscanf(optarg, "%dx%d", &options->width, &options->height) != 2) return false;
+            options->size_given = true;
+            break;
+        default: return false;
+        }
+    }
+    return optind == argc && options->frames > 0
+        && options->point_forces >= 0 && options->distr_forces >= 0
+        && options->width >= 16 && options->height >= 16;
+}
+
+static bool read_recording(const char * path, RecordedEvents * events)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    char magic[8];
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, SOMP_RECORD_MAGIC, 8) == 0;
+
+    SompRecordedEvent record;
+    while (ok && fread(&record, sizeof(record), 1, file) == 1)
+    {
+        ok = DynamicArrayTryAppend(events, record);
+    }
+    fclose(file);
+    return ok;
+}
+
+static bool is_window_event(SDL_Event e)
+{
+    return e.type == SDL_EVENT_WINDOW_SHOWN || e.type == SDL_EVENT_WINDOW_RESIZED;
+}
+
+// Spreads the forces over the whole beam so every part of the scene has
+// something to draw and hit test
+static void populate_scene(int point_forces, int distr_forces)
+{
+    somp_section_solve_t * S = &somp_state->solve;
+    const float length = S->beam.length;
+
+    for (int i = 0; i < point_forces; i++)
+    {
+        float force = ((i % 2) ? -1 : 1) * (50 + i % 50);
+        sorted_pf_insert(&S->point_forces, (SompPointForce){ length*(i+1)/(point_forces+1), force });
+    }
+    for (int i = 0; i < distr_forces; i++)
+    {
+        SompDistrForce df = {
+            .start = length*i/distr_forces,
+            .end   = length*(i+0.8)/distr_forces,
+            .polynomial = { 20 + i % 30, 0 },
+        };
+        sorted_df_insert(&S->distr_forces, df);
+    }
+}
+
+// Without a recording the mouse goes back and forth over the beam, so every
+// frame has to look up the hovered force
+static SDL_Event sweep_event(int frame, int frames, int width, int height)
+{
+    float t = (frames > 1) ? (float) frame / (frames-1) : 0;
+    if (t > 0.5) t = 1 - t;
+    SDL_Event e = { .motion = {
+        .type = SDL_EVENT_MOUSE_MOTION,
+        .x = lerp(0.1*width, 0.9*width, 2*t),
+        .y = 0.3*height,
+    } };
+    return e;
+}
+
+static double time_frame()
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    somp_frame();
+    Uint64 end = SDL_GetPerformanceCounter();
+    return 1000.0 * (end - start) / SDL_GetPerformanceFrequency();
+}
+
+static int comp_doubles(const void * a, const void * b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    if (da < db) return -1;
+    else if (da > db) return 1;
+
+    return 0;
+}
+
+static void report(const BenchOptions * options, const FrameTimes * times)
+{
+    if (times->count == 0)
+    {
+        printf("No frames were rendered\n");
+        return;
+    }
+
+    double * sorted = malloc(times->count * sizeof(double));
+    if (sorted == NULL) return;
+    memcpy(sorted, times->items, times->count * sizeof(double));
+    qsort(sorted, times->count, sizeof(double), comp_doubles);
+
+    double total = 0;
+    for (int i = 0; i < times->count; i++) total += sorted[i];
+
+    printf("Scene: %d point forces, %d distributed forces, %dx%d\n",
+            options->point_forces, options->distr_forces, options->width, options->height);
+    printf("Frames: %d  total: %.3fms\n", times->count, total);
+    printf("Frame time (ms): mean %.4f  median %.4f  p95 %.4f  p99 %.4f  max %.4f\n",
+            total / times->count,
+            sorted[times->count/2],
+            sorted[(int)(0.95*(times->count-1))],
+            sorted[(int)(0.99*(times->count-1))],
+            sorted[times->count-1]);
+    free(sorted);
+
+    if (options->csv_file == NULL) return;
+    FILE * csv = fopen(options->csv_file, "w");
+    if (csv == NULL)
+    {
+        fprintf(stderr, "Could not write %s\n", options->csv_file);
+        return;
+    }
+    fprintf(csv, "frame,ms\n");
+    for (int i = 0; i < times->count; i++) fprintf(csv, "%d,%f\n", i, times->items[i]);
+    fclose(csv);
+}
+
+int main(int argc, char * argv[])
+{
+    BenchOptions options;
+    if (!parse_options(argc, argv, &options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RecordedEvents events = {0};
+    if (options.recording != NULL && !read_recording(options.recording, &events))
+    {
+        fprintf(stderr, "Could not read recording %s\n", options.recording);
+        return 1;
+    }
+    // start_recording writes the window size first
+    if (!options.size_given && events.count > 0 && events.items[0].event.type == SDL_EVENT_WINDOW_RESIZED
+            && events.items[0].event.window.data1 >= 16 && events.items[0].event.window.data2 >= 16)
+    {
+        options.width = events.items[0].event.window.data1;
+        options.height = events.items[0].event.window.data2;
+    }
+
+    HeadlessRenderer hr;
+    if (!headless_init(&hr, options.width, options.height, options.font_file))
+    {
+        fprintf(stderr, "Could not set up the renderer: %s\n", SDL_GetError());
+        headless_free(&hr);
+        return 1;
+    }
+    populate_scene(options.point_forces, options.distr_forces);
+
+    FrameTimes times = {0};
+    bool running = true;
+    if (options.recording != NULL)
+    {
+        // Every frame from 0 to the last one with events is rendered, with
+        // the events handled in it. A reload restarts the frame count, the
+        // frames after it are rendered from 0 again
+        int i = 0;
+        while (running && i < events.count)
+        {
+            for (uint64_t frame = 0; running; frame++)
+            {
+                for (; running && i < events.count && events.items[i].frame == frame; i++)
+                {
+                    if (is_window_event(events.items[i].event)) continue;
+                    running = somp_handle_event(events.items[i].event);
+                }
+                if (running && !DynamicArrayTryAppend(&times, time_frame())) running = false;
+                if (i >= events.count || events.items[i].frame <= frame) break;
+            }
+        }
+    } else
+    {
+        for (int f = 0; running && f < options.frames; f++)
+        {
+            running = somp_handle_event(sweep_event(f, options.frames, options.width, options.height));
+            if (running && !DynamicArrayTryAppend(&times, time_frame())) running = false;
+        }
+    }
+
+    report(&options, &times);
+
+    free(times.items);
+    free(events.items);
+    headless_free(&hr);
+    return 0;
+}
@@ -0,0 +1,366 @@
+#ifndef SOMP_BIAXIAL_H
+#define SOMP_BIAXIAL_H
+
+/*
+* Filename:	somp_biaxial.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Biaxial bending. Every force has a component in the y plane and one in the
+* z plane, both planes are solved together: the sections are built once over
+* the union of the load events, and every section stores the two planes side
+* by side (polynomial[k][lane]) so integrating is one pass with the y and z
+* lanes next to each other, which the compiler turns into paired SIMD
+*
+* Each plane follows the conventions of the uniaxial solver: forces positive
+* pushing towards -y (or -z), moments positive when sagging. The stress at a
+* point (y, z) of the cross section is then
+*     sigma = -(My_plane*y/Izz + Mz_plane*z/Iyy)
+* tension positive. Loads outside [0, length] are dropped, distributed ones
+* cut at the ends of the beam
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+#define BIAXIAL_LANES 2
+enum { LANE_Y, LANE_Z };
+
+typedef struct {
+	float distance;
+	float force[BIAXIAL_LANES];
+} BiaxialPointForce;
+
+typedef struct {
+	float start;
+	float end;
+	float polynomial[MAX_POLYNOMIAL_DEGREE][BIAXIAL_LANES];
+} BiaxialDistributedForce;
+
+// A Section with a lane per plane, pointForce at the start of the section
+typedef struct {
+	float start;
+	float end;
+	float pointForce[BIAXIAL_LANES];
+	float polynomial[MAX_POLYNOMIAL_DEGREE][BIAXIAL_LANES];
+} BiaxialSection;
+
+typedef struct {
+	float length;
+	BeamSupports supports; // the same supports hold both planes, 0 is a cantilever
+	int sectionsCount;
+	// Per plane, in the same sense as the Beam fields
+	float wallReactionForce[BIAXIAL_LANES];
+	float wallReactionMoment[BIAXIAL_LANES];
+	float endReactionForce[BIAXIAL_LANES];
+	float endReactionMoment[BIAXIAL_LANES];
+	BiaxialSection raws[MAX_SECTIONS];
+	BiaxialSection shears[MAX_SECTIONS];
+	BiaxialSection moments[MAX_SECTIONS];
+} BiaxialBeam;
+
+// A doubly symmetric cross section, the corners are at (+-halfDepth, +-halfWidth)
+typedef struct {
+	float halfDepth; // along y
+	float halfWidth; // along z
+	float Izz;       // resists bending in the y plane
+	float Iyy;       // resists bending in the z plane
+} BiaxialCrossSection;
+
+// Corners in the order (y, z) = (+, +), (+, -), (-, -), (-, +)
+#define BIAXIAL_CORNERS 4
+
+bool buildBiaxialSections(SolverContext * ctx, float beamLength,
+		const BiaxialPointForce pForces[], int pfCount,
+		const BiaxialDistributedForce dForces[], int dfCount,
+		BiaxialSection sections[], int * sectionsCount);
+void biaxialIntegrate(BiaxialSection dest[], const BiaxialSection src[], int count,
+		float scale, const float initial[BIAXIAL_LANES]);
+bool solveBiaxialBeam(SolverContext * ctx, BiaxialBeam * beam,
+		const BiaxialPointForce pForces[], int pfCount,
+		const BiaxialDistributedForce dForces[], int dfCount);
+void biaxialMomentsAt(const BiaxialBeam * beam, float x, float moments[BIAXIAL_LANES]);
+
+BiaxialCrossSection rectangularCrossSection(float width, float depth);
+void cornerStresses(const BiaxialCrossSection * cs, const float moments[BIAXIAL_LANES],
+		float stresses[BIAXIAL_CORNERS]);
+float biaxialPeakStress(const BiaxialBeam * beam, const BiaxialCrossSection * cs,
+		int samples, float * where);
+
+#ifdef SOMP_BIAXIAL_IMPLEMENTATION
+
+#ifndef SOMP_LOGIC_IMPLEMENTATION
+#error "somp_biaxial.h sorts with DEFINE_FORCE_SORT, include the somp_logic.h implementation first"
+#endif
+
+#include <math.h>
+
+static inline float breakpointKey(const float * x) { return *x; }
+DEFINE_FORCE_SORT(sortBreakpoints, float, breakpointKey)
+
+// Returns: index of the breakpoint x was merged into
+static int breakpointIndex(const float grid[], int count, float x)
+{
+	int low = 0, high = count;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (grid[mid] > x - EPSILON) high = mid;
+		else low = mid + 1;
+	}
+	return low;
+}
+
+// out[lane] = p(x) for both lanes
+static inline void biaxialEval(const float p[MAX_POLYNOMIAL_DEGREE][BIAXIAL_LANES], float x, float out[BIAXIAL_LANES])
+{
+	for (int lane = 0; lane < BIAXIAL_LANES; lane++) out[lane] = p[MAX_POLYNOMIAL_DEGREE-1][lane];
+	for (int k = MAX_POLYNOMIAL_DEGREE-2; k >= 0; k--)
+		for (int lane = 0; lane < BIAXIAL_LANES; lane++) out[lane] = out[lane]*x + p[k][lane];
+}
+
+/*
+ * Splits the loads of both planes into sections with one sweep. The
+ * breakpoints are all load events sorted and merged; a distributed force is
+ * added where it starts and taken off where it ends, so a running sum over
+ * the sections gives the load on each of them
+ *
+ * Parameters:
+ *  [in,out]sectionsCount: room in sections, then the number filled in
+ *
+ * Return:
+ *  bool: false when out of memory or there are more than *sectionsCount
+ *      sections
+ */
+bool buildBiaxialSections(SolverContext * ctx, float beamLength,
+		const BiaxialPointForce pForces[], int pfCount,
+		const BiaxialDistributedForce dForces[], int dfCount,
+		BiaxialSection sections[], int * sectionsCount)
+{
+	const float L = beamLength;
+	const int capacity = *sectionsCount;
+	const size_t eventsSize = arena_align((1 + pfCount + 2*dfCount) * sizeof(float));
+	arena_reset(&ctx->scratch);
+	pool_reset(&ctx->nodes);
+	if (!arena_reserve(&ctx->scratch, 2*eventsSize)) return false;
+	float * grid = arena_alloc(&ctx->scratch, eventsSize);
+	float * temp = arena_alloc(&ctx->scratch, eventsSize);
+
+	int n = 0;
+	bool pointAtEnd = false;
+	grid[n++] = 0;
+	for (int i = 0; i < pfCount; i++)
+	{
+		const float d = pForces[i].distance;
+		if (!(d >= 0 && d <= L)) continue;
+		grid[n++] = d;
+		pointAtEnd |= nearly_equal(d, L);
+	}
+	for (int i = 0; i < dfCount; i++)
+	{
+		const float start = fmaxf(dForces[i].start, 0), end = fminf(dForces[i].end, L);
+		if (!(end > start)) continue;
+		grid[n++] = start;
+		grid[n++] = end;
+	}
+	sortBreakpoints(grid, n, temp);
+
+	int count = 1;
+	for (int i = 1; i < n; i++)
+		if (!nearly_equal(grid[i], grid[count-1])) grid[count++] = grid[i];
+	// Only a point force at the very end needs a section there
+	if (count > 1 && nearly_equal(grid[count-1], L) && !pointAtEnd) count--;
+	if (count > capacity) return false;
+
+	for (int i = 0; i < count; i++)
+	{
+		sections[i] = (BiaxialSection){ .start = grid[i] };
+		sections[i].end = (i < count-1) ? grid[i+1] : fmaxf(L, grid[i]);
+	}
+	for (int i = 0; i < pfCount; i++)
+	{
+		const float d = pForces[i].distance;
+		if (!(d >= 0 && d <= L)) continue;
+		BiaxialSection * s = &sections[breakpointIndex(grid, count, d)];
+		for (int lane = 0; lane < BIAXIAL_LANES; lane++) s->pointForce[lane] += pForces[i].force[lane];
+	}
+	// Difference pass, then the running sum. A force that ends at the end of
+	// the beam has nothing to take off
+	for (int i = 0; i < dfCount; i++)
+	{
+		const float start = fmaxf(dForces[i].start, 0), end = fminf(dForces[i].end, L);
+		if (!(end > start)) continue;
+		const int first = breakpointIndex(grid, count, start), last = breakpointIndex(grid, count, end);
+		for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+			for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+			{
+				sections[first].polynomial[k][lane] += dForces[i].polynomial[k][lane];
+				if (last < count) sections[last].polynomial[k][lane] -= dForces[i].polynomial[k][lane];
+			}
+	}
+	for (int i = 1; i < count; i++)
+		for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+			for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+				sections[i].polynomial[k][lane] += sections[i-1].polynomial[k][lane];
+	// The section at the end carries only its point force
+	if (count > 1 && !(sections[count-1].end > sections[count-1].start))
+		for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+			for (int lane = 0; lane < BIAXIAL_LANES; lane++) sections[count-1].polynomial[k][lane] = 0;
+
+	*sectionsCount = count;
+	return true;
+}
+
+// pw_integrate for both lanes at once, dest can be src
+void biaxialIntegrate(BiaxialSection dest[], const BiaxialSection src[], int count,
+		float scale, const float initial[BIAXIAL_LANES])
+{
+	float value[BIAXIAL_LANES], at[BIAXIAL_LANES];
+	for (int lane = 0; lane < BIAXIAL_LANES; lane++) value[lane] = initial[lane];
+	for (int i = 0; i < count; i++)
+	{
+		float point[BIAXIAL_LANES];
+		for (int lane = 0; lane < BIAXIAL_LANES; lane++) point[lane] = src[i].pointForce[lane];
+		dest[i].start = src[i].start;
+		dest[i].end = src[i].end;
+		// Highest term first so it also works in place, the top one is dropped
+		for (int k = MAX_POLYNOMIAL_DEGREE-1; k >= 1; k--)
+			for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+				dest[i].polynomial[k][lane] = scale*src[i].polynomial[k-1][lane]/(float)k;
+		for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+		{
+			dest[i].pointForce[lane] = 0;
+			dest[i].polynomial[0][lane] = 0;
+		}
+
+		if (i > 0) biaxialEval(dest[i-1].polynomial, dest[i-1].end, value);
+		biaxialEval(dest[i].polynomial, dest[i].start, at);
+		for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+		{
+			value[lane] += scale*point[lane];
+			dest[i].polynomial[0][lane] = value[lane] - at[lane];
+		}
+	}
+}
+
+/*
+ * Solve both planes of a beam, beam->length and beam->supports have to be
+ * set
+ *
+ * Return:
+ *  bool: false when out of memory, too many sections or the supports do not
+ *      hold the beam
+ */
+bool solveBiaxialBeam(SolverContext * ctx, BiaxialBeam * beam,
+		const BiaxialPointForce pForces[], int pfCount,
+		const BiaxialDistributedForce dForces[], int dfCount)
+{
+	int count = MAX_SECTIONS;
+	if (!buildBiaxialSections(ctx, beam->length, pForces, pfCount, dForces, dfCount, beam->raws, &count)) return false;
+	beam->sectionsCount = count;
+
+	for (int lane = 0; lane < BIAXIAL_LANES; lane++)
+	{
+		double I[4] = {0};
+		for (int i = 0; i < count; i++)
+		{
+			const BiaxialSection * s = &beam->raws[i];
+			float p[MAX_POLYNOMIAL_DEGREE];
+			for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++) p[k] = s->polynomial[k][lane];
+			double power = 1;
+			for (int k = 0; k < 4; k++)
+			{
+				I[k] += s->pointForce[lane] * power;
+				if (s->end > s->start) I[k] += poly_integral_weighted(p, k, s->start, s->end);
+				power *= s->start;
+			}
+		}
+		double reactions[4];
+		if (!supportReactions(beam->supports, beam->length, I, reactions)) return false;
+		beam->wallReactionForce[lane] = reactions[0];
+		beam->wallReactionMoment[lane] = reactions[1];
+		beam->endReactionForce[lane] = reactions[2];
+		beam->endReactionMoment[lane] = reactions[3];
+	}
+
+	biaxialIntegrate(beam->shears, beam->raws, count, -1, beam->wallReactionForce);
+	biaxialIntegrate(beam->moments, beam->shears, count, 1, beam->wallReactionMoment);
+	return true;
+}
+
+// Returns: index of the section x is in, same rule as pw_find
+static int biaxialFind(const BiaxialSection pieces[], int count, float x)
+{
+	int low = 0, high = count - 1;
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+		if (pieces[mid].start <= x || pw_on_breakpoint(pieces[mid].start, x)) low = mid;
+		else high = mid - 1;
+	}
+	return low;
+}
+
+void biaxialMomentsAt(const BiaxialBeam * beam, float x, float moments[BIAXIAL_LANES])
+{
+	biaxialEval(beam->moments[biaxialFind(beam->moments, beam->sectionsCount, x)].polynomial, x, moments);
+}
+
+BiaxialCrossSection rectangularCrossSection(float width, float depth)
+{
+	return (BiaxialCrossSection){
+		.halfDepth = depth/2,
+		.halfWidth = width/2,
+		.Izz = width*depth*depth*depth/12,
+		.Iyy = depth*width*width*width/12,
+	};
+}
+
+void cornerStresses(const BiaxialCrossSection * cs, const float moments[BIAXIAL_LANES],
+		float stresses[BIAXIAL_CORNERS])
+{
+	// Bending in either plane alone gives +-these at the corners
+	const float y = moments[LANE_Y]*cs->halfDepth/cs->Izz;
+	const float z = moments[LANE_Z]*cs->halfWidth/cs->Iyy;
+	stresses[0] = -y - z;
+	stresses[1] = -y + z;
+	stresses[2] =  y + z;
+	stresses[3] =  y - z;
+}
+
+/*
+ * Largest corner stress (by size) over samples evenly spaced points of the
+ * beam, ends included
+ *
+ * Parameters:
+ *  [out]where: x of the peak, can be NULL
+ *
+ * Return:
+ *  float: the stress with its sign
+ */
+float biaxialPeakStress(const BiaxialBeam * beam, const BiaxialCrossSection * cs,
+		int samples, float * where)
+{
+	const float step = (samples > 1) ? beam->length/(samples - 1) : 0;
+	float peak = 0, peakX = 0;
+	int piece = 0;
+	for (int i = 0; i < samples; i++)
+	{
+		const float x = i*step;
+		while (piece < beam->sectionsCount-1 && x > beam->moments[piece].end) piece++;
+		float moments[BIAXIAL_LANES], stresses[BIAXIAL_CORNERS];
+		biaxialEval(beam->moments[piece].polynomial, x, moments);
+		cornerStresses(cs, moments, stresses);
+		for (int c = 0; c < BIAXIAL_CORNERS; c++)
+			if (fabsf(stresses[c]) > fabsf(peak))
+			{
+				peak = stresses[c];
+				peakX = x;
+			}
+	}
+	if (where != NULL) *where = peakX;
+	return peak;
+}
+
+#endif // SOMP_BIAXIAL_IMPLEMENTATION
+#endif // SOMP_BIAXIAL_H
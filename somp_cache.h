@@ -0,0 +1,315 @@
+#ifndef SOMP_CACHE_H
+#define SOMP_CACHE_H
+
+/*
+* Filename:	somp_cache.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Memoization in front of solveBeam. Inputs are put in a canonical order
+* (sorted forces) and hashed, a hit copies the stored beam back so it is
+* exactly what the first solve produced
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "somp_logic.h"
+
+typedef struct {
+	uint64_t hash;
+	int keySize;
+	unsigned char * key;
+	Beam beam;
+
+	int prev;       // more recently used entry
+	int next;       // less recently used entry
+	int bucketNext; // next entry in the same hash bucket
+} BeamCacheEntry;
+
+typedef struct {
+	int capacity;
+	int count;
+	size_t maxKeyBytes;
+	size_t keyBytes;
+	BeamCacheEntry * entries;
+
+	int bucketsCount;
+	int * buckets;
+
+	int head; // most recently used
+	int tail; // least recently used
+
+	// Scratch used to build keys, grows to the biggest input seen
+	unsigned char * scratch;
+	size_t scratchSize;
+
+	long hits;
+	long misses;
+	long evictions;
+} BeamCache;
+
+bool initBeamCache(BeamCache * cache, int capacity, size_t maxKeyBytes);
+void freeBeamCache(BeamCache * cache);
+void clearBeamCache(BeamCache * cache);
+bool cachedSolveBeam(BeamCache * cache, Beam * beam,
+		PointForce pointForces[], int pfCount,
+		DistributedForce distributedForces[], int dfCount);
+
+#ifdef SOMP_CACHE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_NONE (-1)
+
+static uint64_t hashBytes(const unsigned char * bytes, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// -0 and 0 solve the same so they should hash the same
+static float canonicalFloat(float f)
+{
+	return (f == 0) ? 0 : f;
+}
+
+static int compPointForcesFull(const void * a, const void * b)
+{
+	int c = compPointDists(a, b);
+	if (c != 0) return c;
+	return memcmp(a, b, sizeof(PointForce));
+}
+
+static int compDistributedForcesFull(const void * a, const void * b)
+{
+	int c = compDistributedStarts(a, b);
+	if (c == 0) c = compDistributedEnds(a, b);
+	if (c != 0) return c;
+	return memcmp(a, b, sizeof(DistributedForce));
+}
+
+bool initBeamCache(BeamCache * cache, int capacity, size_t maxKeyBytes)
+{
+	*cache = (BeamCache){0};
+	if (capacity < 1) return false;
+
+	cache->capacity = capacity;
+	cache->maxKeyBytes = maxKeyBytes;
+	cache->bucketsCount = capacity * 2;
+	cache->entries = calloc(capacity, sizeof(BeamCacheEntry));
+	cache->buckets = malloc(cache->bucketsCount * sizeof(int));
+	if (cache->entries == NULL || cache->buckets == NULL)
+	{
+		freeBeamCache(cache);
+		return false;
+	}
+	clearBeamCache(cache);
+	return true;
+}
+
+void clearBeamCache(BeamCache * cache)
+{
+	for (int i = 0; i < cache->count; i++) free(cache->entries[i].key);
+	for (int i = 0; i < cache->bucketsCount; i++) cache->buckets[i] = CACHE_NONE;
+	cache->count = 0;
+	cache->keyBytes = 0;
+	cache->head = CACHE_NONE;
+	cache->tail = CACHE_NONE;
+}
+
+void freeBeamCache(BeamCache * cache)
+{
+	if (cache->entries != NULL && cache->buckets != NULL) clearBeamCache(cache);
+	free(cache->entries);
+	free(cache->buckets);
+	free(cache->scratch);
+	*cache = (BeamCache){0};
+}
+
+static void cacheUnlink(BeamCache * cache, int i)
+{
+	BeamCacheEntry * e = &cache->entries[i];
+	if (e->prev != CACHE_NONE) cache->entries[e->prev].next = e->next;
+	else cache->head = e->next;
+	if (e->next != CACHE_NONE) cache->entries[e->next].prev = e->prev;
+	else cache->tail = e->prev;
+}
+
+static void cachePushFront(BeamCache * cache, int i)
+{
+	BeamCacheEntry * e = &cache->entries[i];
+	e->prev = CACHE_NONE;
+	e->next = cache->head;
+	if (cache->head != CACHE_NONE) cache->entries[cache->head].prev = i;
+	cache->head = i;
+	if (cache->tail == CACHE_NONE) cache->tail = i;
+}
+
+static void cacheRemoveFromBucket(BeamCache * cache, int i)
+{
+	int * link = &cache->buckets[cache->entries[i].hash % cache->bucketsCount];
+	while (*link != i) link = &cache->entries[*link].bucketNext;
+	*link = cache->entries[i].bucketNext;
+}
+
+// Drops the least recently used entry, the last slot is moved into its place
+// so the used entries stay packed at the front of the array
+static void cacheEvict(BeamCache * cache)
+{
+	int victim = cache->tail;
+	cacheUnlink(cache, victim);
+	cacheRemoveFromBucket(cache, victim);
+	cache->keyBytes -= cache->entries[victim].keySize;
+	free(cache->entries[victim].key);
+
+	int last = cache->count-1;
+	if (victim != last)
+	{
+		// Fix every link that pointed at the last slot
+		BeamCacheEntry * moved = &cache->entries[last];
+		if (moved->prev != CACHE_NONE) cache->entries[moved->prev].next = victim;
+		else cache->head = victim;
+		if (moved->next != CACHE_NONE) cache->entries[moved->next].prev = victim;
+		else cache->tail = victim;
+
+		int * link = &cache->buckets[moved->hash % cache->bucketsCount];
+		while (*link != last) link = &cache->entries[*link].bucketNext;
+		*link = victim;
+
+		cache->entries[victim] = *moved;
+	}
+	cache->count--;
+	cache->evictions++;
+}
+
+/*
+ * Write the canonical form of the inputs into the cache scratch:
+ *  length, supports, pfCount, dfCount, sorted point forces, sorted
+ *  distributed forces
+ */
+#define CACHE_KEY_HEADER (sizeof(float) + sizeof(BeamSupports) + 2*sizeof(int))
+static int buildCacheKey(BeamCache * cache, float length, BeamSupports supports,
+		const PointForce pointForces[], int pfCount,
+		const DistributedForce distributedForces[], int dfCount)
+{
+	size_t size = CACHE_KEY_HEADER
+		+ pfCount*sizeof(PointForce) + dfCount*sizeof(DistributedForce);
+	if (size > cache->scratchSize)
+	{
+		unsigned char * scratch = realloc(cache->scratch, size);
+		if (scratch == NULL) return -1;
+		cache->scratch = scratch;
+		cache->scratchSize = size;
+	}
+
+	unsigned char * p = cache->scratch;
+	length = canonicalFloat(length);
+	memcpy(p, &length, sizeof(float)); p += sizeof(float);
+	// The default and what it stands for solve the same
+	supports = effectiveSupports(supports);
+	memcpy(p, &supports, sizeof(BeamSupports)); p += sizeof(BeamSupports);
+	memcpy(p, &pfCount, sizeof(int));  p += sizeof(int);
+	memcpy(p, &dfCount, sizeof(int));  p += sizeof(int);
+
+	PointForce * pfs = (PointForce *) p;
+	for (int i = 0; i < pfCount; i++)
+	{
+		pfs[i].distance = canonicalFloat(pointForces[i].distance);
+		pfs[i].force = canonicalFloat(pointForces[i].force);
+	}
+	qsort(pfs, pfCount, sizeof(PointForce), compPointForcesFull);
+	p += pfCount*sizeof(PointForce);
+
+	DistributedForce * dfs = (DistributedForce *) p;
+	for (int i = 0; i < dfCount; i++)
+	{
+		dfs[i].start = canonicalFloat(distributedForces[i].start);
+		dfs[i].end = canonicalFloat(distributedForces[i].end);
+		for (int j = 0; j < MAX_POLYNOMIAL_DEGREE; j++)
+		{
+			dfs[i].polynomial[j] = canonicalFloat(distributedForces[i].polynomial[j]);
+		}
+	}
+	qsort(dfs, dfCount, sizeof(DistributedForce), compDistributedForcesFull);
+
+	return (int) size;
+}
+
+/*
+ * Same as solveBeam but answers from the cache when the same inputs (in any
+ * order) were solved before
+ *
+ * Parameters:
+ *  [in,out]cache: cache made with initBeamCache
+ *  [in,out]beam: only length and supports are read, same as solveBeam
+ *  the force arrays are not modified
+ *
+ * Return:
+ *  bool: false when the solve fails or the key could not be built, failed
+ *      solves are not cached
+ */
+bool cachedSolveBeam(BeamCache * cache, Beam * beam,
+		PointForce pointForces[], int pfCount,
+		DistributedForce distributedForces[], int dfCount)
+{
+	int keySize = buildCacheKey(cache, beam->length, beam->supports, pointForces, pfCount, distributedForces, dfCount);
+	if (keySize < 0) return false;
+	uint64_t hash = hashBytes(cache->scratch, keySize);
+
+	for (int i = cache->buckets[hash % cache->bucketsCount]; i != CACHE_NONE; i = cache->entries[i].bucketNext)
+	{
+		BeamCacheEntry * e = &cache->entries[i];
+		if (e->hash != hash || e->keySize != keySize) continue;
+		if (memcmp(e->key, cache->scratch, keySize) != 0) continue;
+
+		*beam = e->beam;
+		cacheUnlink(cache, i);
+		cachePushFront(cache, i);
+		cache->hits++;
+		return true;
+	}
+	cache->misses++;
+
+	// Solve from the canonical forces in the scratch, solveBeam works on
+	// its own copy so the scratch is still the key afterwards
+	PointForce * pfs = (PointForce *) (cache->scratch + CACHE_KEY_HEADER);
+	DistributedForce * dfs = (DistributedForce *) (pfs + pfCount);
+	if (!solveBeam(beam, pfs, pfCount, dfs, dfCount)) return false;
+
+	// Inputs bigger than the whole budget are solved but never stored, same
+	// when there is no memory left for the key
+	if ((size_t) keySize > cache->maxKeyBytes) return true;
+	unsigned char * key = malloc(keySize);
+	if (key == NULL) return true;
+	memcpy(key, cache->scratch, keySize);
+	while (cache->count > 0
+			&& (cache->count >= cache->capacity || cache->keyBytes + keySize > cache->maxKeyBytes))
+	{
+		cacheEvict(cache);
+	}
+
+	int i = cache->count++;
+	BeamCacheEntry * e = &cache->entries[i];
+	e->hash = hash;
+	e->keySize = keySize;
+	e->key = key;
+	e->beam = *beam;
+	cache->keyBytes += keySize;
+
+	int * bucket = &cache->buckets[hash % cache->bucketsCount];
+	e->bucketNext = *bucket;
+	*bucket = i;
+	cachePushFront(cache, i);
+
+	return true;
+}
+
+#endif // SOMP_CACHE_IMPLEMENTATION
+#endif // SOMP_CACHE_H
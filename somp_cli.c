@@ -10,9 +10,9 @@
 * will support:
 * - point forces
 * - distributed forces in the form of polynomials of x^n where n >= 0
-* will NOT support:
 * - point moments
-* - distributed moments? (if that is even physically possible???)
+* - distributed moments, also polynomials
+* - axial forces and torques, point and distributed
 *
 */
 
@@ -54,25 +54,77 @@ int main(int argc, char * argv[])
     printf("\t0.25 0.75 [2 0]\n");
     printf("\t0.75 1.0 [3 0]\n");
     printf("\t0.65 0.95 [4 0]\n");
+    printf("The beam line can end with the supports at 0 and at the end: free, pin, roller\n");
+    printf("or fixed (\"1.0 10 pin roller\"), without them it is a cantilever (fixed free)\n");
+    printf("Point moments (clockwise positive) and distributed moments can follow the\n");
+    printf("distributed forces, both sections are optional:\n");
+    printf("\t#PM\n");
+    printf("\t0.5 2\n");
+    printf("\t#DM\n");
+    printf("\t0 1.0 [1]\n");
+    printf("Then axial forces (positive towards the end) and torques (right handed about\n");
+    printf("the beam), same formats: #PA and #DA, then #PT and #DT. Rollers slide along\n");
+    printf("the beam, pins and rollers hold it against twisting\n");
 
     Beam beam = {0};
     PointForces point_forces = {0};
     DistributedForces distrib_forces = {0};
+    PointMoments point_moments = {0};
+    DistributedMoments distrib_moments = {0};
+    PointForces axial_forces = {0};
+    DistributedForces distrib_axial_forces = {0};
+    PointMoments torques = {0};
+    DistributedMoments distrib_torques = {0};
+    CaseArrays arrays = {
+        &point_forces, &distrib_forces, &point_moments, &distrib_moments,
+        &axial_forces, &distrib_axial_forces, &torques, &distrib_torques,
+    };
     //input
     printf("Enter your input:\n");
     //TODO: when pressing ^D, it does an infinite loop of failure, this shouldnt happen
     while (true)
     {
-        if (read_info_cli(stdin, &beam, &point_forces, &distrib_forces)) break;
+        if (read_case_cli(stdin, &beam, &arrays)) break;
         printf("\nCould not parse input! Please type it again.\n");
         printf("Enter your input:\n");
     };
-    solveBeam(&beam, point_forces.items, point_forces.count, distrib_forces.items, distrib_forces.count);
+    BeamLoads loads = {
+        point_forces.items, point_forces.count, distrib_forces.items, distrib_forces.count,
+        point_moments.items, point_moments.count, distrib_moments.items, distrib_moments.count,
+        axial_forces.items, axial_forces.count, distrib_axial_forces.items, distrib_axial_forces.count,
+        torques.items, torques.count, distrib_torques.items, distrib_torques.count,
+    };
+    SolverContext ctx;
+    initSolverContext(&ctx);
+    bool solved = solveBeamLoads(&ctx, &beam, &loads);
+    freeSolverContext(&ctx);
+    if (!solved)
+    {
+        printf("\nCould not solve: too many sections or the supports do not hold the beam\n");
+        return 1;
+    }
     printf("\nOutput:\n");
+    printf("Reactions: %f, %f at 0 and %f, %f at the end\n",
+            beam.wall_reaction_force, beam.wall_reaction_moment,
+            beam.end_reaction_force, beam.end_reaction_moment);
 
     printStructArray(beam.raws, beam.sections_count, sizeof(beam.raws[0]), printSection );
+    if (point_moments.count > 0 || distrib_moments.count > 0)
+    {
+        printStructArray(beam.applied_moments, beam.sections_count, sizeof(beam.applied_moments[0]), printSection );
+    }
     printStructArray(beam.shears, beam.sections_count, sizeof(beam.shears[0]), printSection );
     printStructArray(beam.moments, beam.sections_count, sizeof(beam.moments[0]), printSection );
+    if (axial_forces.count > 0 || distrib_axial_forces.count > 0)
+    {
+        printf("Axial force %f at 0\n", beam.wall_reaction_axial);
+        printStructArray(beam.axials, beam.sections_count, sizeof(beam.axials[0]), printSection );
+    }
+    if (torques.count > 0 || distrib_torques.count > 0)
+    {
+        printf("Torque %f at 0\n", beam.wall_reaction_torque);
+        printStructArray(beam.torques, beam.sections_count, sizeof(beam.torques[0]), printSection );
+    }
 
 	return 0;
 }
@@ -0,0 +1,247 @@
+#ifndef SOMP_CONTINUOUS_H
+#define SOMP_CONTINUOUS_H
+
+/*
+* Filename:	somp_continuous.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Continuous beams over many supports. Every span is solved on its own with
+* the cantilever solver, turned into a simply supported span, and the
+* moments over the supports come from the three moment equation. That
+* system is tridiagonal, so the Thomas algorithm solves it in O(spans)
+*
+* Supports are pins (no settlement), the two end supports can also be fixed.
+* Loads are in span coordinates, x = 0 at the left support of the span.
+* Moments are positive when sagging, forces positive when pushing down
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+typedef struct {
+	float length;
+	PointForce * pointForces;
+	int pfCount;
+	DistributedForce * distributedForces;
+	int dfCount;
+} Span;
+
+typedef struct {
+	int spansCount;
+	// Per span, in span coordinates: raws are the loads, shears and moments
+	// are the final diagrams of the span
+	Beam * spans;
+	float * spanStarts;     // spansCount+1, the last one is the total length
+	float * supportMoments; // spansCount+1
+	float * reactions;      // spansCount+1, positive pushing up
+} ContinuousBeam;
+
+bool solveContinuousBeam(ContinuousBeam * out, const Span spans[], int spansCount,
+		bool fixedLeft, bool fixedRight);
+void freeContinuousBeam(ContinuousBeam * beam);
+// x from the left end of the whole beam
+float continuousShearAt(const ContinuousBeam * beam, float x);
+float continuousMomentAt(const ContinuousBeam * beam, float x);
+
+#ifdef SOMP_CONTINUOUS_IMPLEMENTATION
+
+#include <stdlib.h>
+
+/*
+ * Solves a tridiagonal system in place with the Thomas algorithm, the three
+ * moment matrix is diagonally dominant so it does not need pivoting
+ *
+ * Parameters:
+ *  [in]sub[]: below the diagonal, sub[0] is not used
+ *  [in,out]diag[]: the diagonal, overwritten
+ *  [in]super[]: above the diagonal, super[n-1] is not used
+ *  [in,out]rhs[]: right hand side, becomes the solution
+ *  [in]n: number of rows
+ */
+static void solveTridiagonal(const double sub[], double diag[], const double super[], double rhs[], int n)
+{
+	for (int i = 1; i < n; i++)
+	{
+		double factor = sub[i] / diag[i-1];
+		diag[i] -= factor * super[i-1];
+		rhs[i] -= factor * rhs[i-1];
+	}
+	rhs[n-1] /= diag[n-1];
+	for (int i = n-2; i >= 0; i--) rhs[i] = (rhs[i] - super[i]*rhs[i+1]) / diag[i];
+}
+
+// Integral of x^power * f over the span, f the moment sections
+static double spanMomentIntegral(const Beam * span, int power)
+{
+	double sum = 0;
+	for (int i = 0; i < span->sections_count; i++)
+	{
+		const Section * s = &span->moments[i];
+		// The section a point force at the free end leaves behind has no length
+		if (s->end > s->start) sum += poly_integral_weighted(s->polynomial, power, s->start, s->end);
+	}
+	return sum;
+}
+
+// Adds a + b*x to every shear or moment section
+static void addLine(Section sections[], int count, float a, float b)
+{
+	for (int i = 0; i < count; i++)
+	{
+		sections[i].polynomial[0] += a;
+		sections[i].polynomial[1] += b;
+	}
+}
+
+/*
+ * Solve a beam that runs continuously over spansCount+1 supports
+ *
+ * Parameters:
+ *  [out]out: the solution, free it with freeContinuousBeam
+ *  [in]spans[]: length and loads of every span, left to right
+ *  [in]spansCount: number of spans
+ *  [in]fixedLeft, fixedRight: the end supports are fixed instead of pinned
+ *
+ * Return:
+ *  bool: false when out of memory or a span has too many sections
+ */
+bool solveContinuousBeam(ContinuousBeam * out, const Span spans[], int spansCount,
+		bool fixedLeft, bool fixedRight)
+{
+	*out = (ContinuousBeam){0};
+	if (spansCount <= 0) return false;
+	const int n = spansCount + 1;
+
+	out->spansCount = spansCount;
+	out->spans = malloc(spansCount * sizeof(Beam));
+	out->spanStarts = malloc(n * sizeof(float));
+	out->supportMoments = malloc(n * sizeof(float));
+	out->reactions = malloc(n * sizeof(float));
+	double * work = malloc(4 * n * sizeof(double));
+	if (out->spans == NULL || out->spanStarts == NULL || out->supportMoments == NULL
+			|| out->reactions == NULL || work == NULL)
+	{
+		free(work);
+		freeContinuousBeam(out);
+		return false;
+	}
+	double * sub = work, * diag = work + n, * super = work + 2*n, * rhs = work + 3*n;
+
+	// Every span simply supported first. The cantilever solution only needs
+	// the reaction of the right support added: m0 = M_cantilever + R*(L - x)
+	SolverContext ctx;
+	initSolverContext(&ctx);
+	out->spanStarts[0] = 0;
+	for (int i = 0; i < spansCount; i++)
+	{
+		Beam * span = &out->spans[i];
+		const float L = spans[i].length;
+		*span = (Beam){ .length = L };
+		if (!(L > 0) || !solveBeamCtx(&ctx, span,
+					spans[i].pointForces, spans[i].pfCount,
+					spans[i].distributedForces, spans[i].dfCount))
+		{
+			freeSolverContext(&ctx);
+			free(work);
+			freeContinuousBeam(out);
+			return false;
+		}
+		const float right = -span->wall_reaction_moment / L;
+		addLine(span->moments, span->sections_count, right*L, -right);
+		addLine(span->shears, span->sections_count, -right, 0);
+		out->spanStarts[i+1] = out->spanStarts[i] + L;
+	}
+	freeSolverContext(&ctx);
+
+	// Three moment equation for every support, with the load terms
+	// 6/L * integral of m0*x (left span) and m0*(L - x) (right span)
+	for (int j = 0; j < n; j++)
+	{
+		sub[j] = diag[j] = super[j] = rhs[j] = 0;
+		const bool hasLeft = j > 0, hasRight = j < spansCount;
+		const bool pinnedEnd = (!hasLeft && !fixedLeft) || (!hasRight && !fixedRight);
+		if (pinnedEnd)
+		{
+			diag[j] = 1;
+			continue;
+		}
+		if (hasLeft)
+		{
+			const Beam * span = &out->spans[j-1];
+			sub[j] = span->length;
+			diag[j] += 2*span->length;
+			rhs[j] -= 6 * spanMomentIntegral(span, 1) / span->length;
+		}
+		if (hasRight)
+		{
+			const Beam * span = &out->spans[j];
+			super[j] = span->length;
+			diag[j] += 2*span->length;
+			rhs[j] -= 6 * (span->length*spanMomentIntegral(span, 0) - spanMomentIntegral(span, 1)) / span->length;
+		}
+	}
+	solveTridiagonal(sub, diag, super, rhs, n);
+	for (int j = 0; j < n; j++) out->supportMoments[j] = rhs[j];
+
+	// Add the support moments, a straight line over every span, and collect
+	// the reactions from the jump in shear over every support
+	for (int j = 0; j < n; j++) out->reactions[j] = 0;
+	for (int i = 0; i < spansCount; i++)
+	{
+		Beam * span = &out->spans[i];
+		const float L = span->length;
+		const float left = out->supportMoments[i], right = out->supportMoments[i+1];
+		const float slope = (right - left) / L;
+		addLine(span->moments, span->sections_count, left, slope);
+		addLine(span->shears, span->sections_count, slope, 0);
+
+		// Shear left of everything in the span, and right of everything
+		const float simpleRight = -span->wall_reaction_moment / L;
+		const float shearStart = span->wall_reaction_force - simpleRight + slope;
+		const float shearEnd = -simpleRight + slope;
+		out->reactions[i] += shearStart;
+		out->reactions[i+1] -= shearEnd;
+	}
+
+	free(work);
+	return true;
+}
+
+void freeContinuousBeam(ContinuousBeam * beam)
+{
+	free(beam->spans);
+	free(beam->spanStarts);
+	free(beam->supportMoments);
+	free(beam->reactions);
+	*beam = (ContinuousBeam){0};
+}
+
+// Returns: index of the span x is in, x becomes the span coordinate
+static int continuousSpanAt(const ContinuousBeam * beam, float * x)
+{
+	int low = 0, high = beam->spansCount - 1;
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+		if (beam->spanStarts[mid] <= *x) low = mid;
+		else high = mid - 1;
+	}
+	*x -= beam->spanStarts[low];
+	return low;
+}
+
+float continuousShearAt(const ContinuousBeam * beam, float x)
+{
+	const Beam * span = &beam->spans[continuousSpanAt(beam, &x)];
+	return poly_eval(span->shears[pw_find(span->shears, span->sections_count, x)].polynomial, x);
+}
+
+float continuousMomentAt(const ContinuousBeam * beam, float x)
+{
+	const Beam * span = &beam->spans[continuousSpanAt(beam, &x)];
+	return poly_eval(span->moments[pw_find(span->moments, span->sections_count, x)].polynomial, x);
+}
+
+#endif // SOMP_CONTINUOUS_IMPLEMENTATION
+#endif // SOMP_CONTINUOUS_H
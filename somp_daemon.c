@@ -0,0 +1,431 @@
+/*
+* Filename:	somp_daemon.c
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Long running solver on a unix domain socket, so short lived programs do
+* not pay for starting up and parsing every time. The protocol is in
+* somp_protocol.h. Every connection gets a thread, the solves themselves
+* use a fixed pool of warm solver contexts. A connection can pipeline: all
+* requests that have arrived are solved and answered in one write
+*
+* Usage:
+*   somp_daemon.out [-s socket] [-w contexts] [-v]
+*   somp_daemon.out -c [-s socket] [-n repeats] [-p pipeline] case.txt...
+* The second form is a client: it sends every case (repeats times, at most
+* pipeline requests in flight) and reports the round trip and the time the
+* daemon spent on each request
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define UTILS_IMPLEMENTATION
+#include "utils.h"
+
+#define SOMP_LOGIC_IMPLEMENTATION
+#include "somp_logic.h"
+
+#define SOMP_IO_IMPLEMENTATION
+#include "somp_io.h"
+
+#define SOMP_PROTOCOL_IMPLEMENTATION
+#include "somp_protocol.h"
+
+#define DEFAULT_SOCKET_PATH "./somp.sock"
+#define READ_CHUNK 65536
+
+typedef struct {
+    const char * socket_path;
+    int contexts;
+    bool verbose;
+
+    bool client;
+    int repeats;
+    int pipeline;
+    char ** cases;
+    int cases_count;
+} DaemonOptions;
+
+// ====================== CONTEXT POOL ==================================
+typedef struct {
+    SompSolveContext * contexts;
+    int * free_list;
+    int free_count;
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+} ContextPool;
+
+static bool pool_init_contexts(ContextPool * pool, int count)
+{
+    *pool = (ContextPool){0};
+    pool->contexts = calloc(count, sizeof(SompSolveContext));
+    pool->free_list = calloc(count, sizeof(int));
+    if (pool->contexts == NULL || pool->free_list == NULL) return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        initSompSolveContext(&pool->contexts[i]);
+        pool->free_list[pool->free_count++] = i;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->available, NULL);
+    return true;
+}
+
+// Waits until a context is free
+static int pool_take(ContextPool * pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->free_count == 0) pthread_cond_wait(&pool->available, &pool->lock);
+    int index = pool->free_list[--pool->free_count];
+    pthread_mutex_unlock(&pool->lock);
+    return index;
+}
+
+static void pool_give(ContextPool * pool, int index)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->free_list[pool->free_count++] = index;
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+}
+// ======================================================================
+
+static ContextPool pool;
+static volatile sig_atomic_t stopping = 0;
+static bool verbose = false;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stopping = 1;
+}
+
+static bool write_all(int fd, const unsigned char * data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Reads whatever is there (at least one byte) into the end of buffer
+// Returns: false on end of file or an error
+static bool read_some(int fd, SompBuffer * buffer)
+{
+    if (!DynamicArrayReserve(buffer, buffer->count + READ_CHUNK)) return false;
+    ssize_t n;
+    do n = read(fd, buffer->items + buffer->count, buffer->capacity - buffer->count);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    buffer->count += n;
+    return true;
+}
+
+// ====================== SERVER ========================================
+typedef struct {
+    int fd;
+    long requests;
+    uint64_t latency_total_ns;
+    uint64_t latency_max_ns;
+} Connection;
+
+// Solves every complete request in input and answers them in one write,
+// the rest of an incomplete request stays at the start of input
+static bool serve_requests(Connection * conn, SompBuffer * input, SompBuffer * output)
+{
+    long offset = 0;
+    int context = -1;
+    bool ok = true;
+    while (ok)
+    {
+        long frame = somp_frame_size(input->items + offset, input->count - offset);
+        if (frame == 0) break;
+        if (frame < 0)
+        {
+            ok = false;
+            break;
+        }
+
+        uint64_t start = somp_now_ns();
+        if (context < 0) context = pool_take(&pool);
+        ok = somp_handle_request(&pool.contexts[context],
+                input->items + offset + sizeof(uint32_t), frame - sizeof(uint32_t), output, start);
+        offset += frame;
+
+        uint64_t latency = somp_now_ns() - start;
+        conn->requests++;
+        conn->latency_total_ns += latency;
+        if (latency > conn->latency_max_ns) conn->latency_max_ns = latency;
+    }
+    if (context >= 0) pool_give(&pool, context);
+
+    memmove(input->items, input->items + offset, input->count - offset);
+    input->count -= offset;
+
+    if (ok && output->count > 0) ok = write_all(conn->fd, output->items, output->count);
+    output->count = 0;
+    return ok;
+}
+
+static void * serve_connection(void * arg)
+{
+    Connection conn = { .fd = (int)(intptr_t) arg };
+    SompBuffer input = {0}, output = {0};
+
+    while (read_some(conn.fd, &input) && serve_requests(&conn, &input, &output));
+
+    if (verbose && conn.requests > 0)
+    {
+        printf("Connection %d: %ld requests, mean %.1fus, max %.1fus\n", conn.fd, conn.requests,
+                conn.latency_total_ns / 1000.0 / conn.requests, conn.latency_max_ns / 1000.0);
+    }
+    close(conn.fd);
+    free(input.items);
+    free(output.items);
+    return NULL;
+}
+
+static int run_server(const DaemonOptions * options)
+{
+    if (!pool_init_contexts(&pool, options->contexts))
+    {
+        fprintf(stderr, "Could not make %d solver contexts\n", options->contexts);
+        return 1;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", options->socket_path);
+    // A socket left behind by a daemon that did not shut down cleanly
+    unlink(options->socket_path);
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0
+            || listen(listener, 64) < 0)
+    {
+        fprintf(stderr, "Could not listen on %s: %s\n", options->socket_path, strerror(errno));
+        return 1;
+    }
+
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    printf("Listening on %s with %d solver contexts\n", options->socket_path, options->contexts);
+    fflush(stdout);
+
+    while (!stopping)
+    {
+        struct pollfd pfd = { .fd = listener, .events = POLLIN };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve_connection, (void *)(intptr_t) fd) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    printf("Stopping\n");
+    close(listener);
+    unlink(options->socket_path);
+    return 0;
+}
+// ======================================================================
+// ====================== CLIENT ========================================
+typedef struct {
+    Beam beam;
+    PointForces pfs;
+    DistributedForces dfs;
+} ClientCase;
+
+static int comp_u64(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static void print_latencies(const char * name, uint64_t * ns, long count)
+{
+    qsort(ns, count, sizeof(uint64_t), comp_u64);
+    double total = 0;
+    for (long i = 0; i < count; i++) total += ns[i];
+    printf("%-10s mean %8.1fus  median %8.1fus  p99 %8.1fus  max %8.1fus\n", name,
+            total / count / 1000.0, ns[count/2] / 1000.0,
+            ns[(long)(0.99*(count-1))] / 1000.0, ns[count-1] / 1000.0);
+}
+
+static int run_client(const DaemonOptions * options)
+{
+    ClientCase * cases = calloc(options->cases_count, sizeof(ClientCase));
+    if (cases == NULL) return 1;
+    for (int i = 0; i < options->cases_count; i++)
+    {
+        FILE * file = fopen(options->cases[i], "r");
+        if (file == NULL || !read_info_cli(file, &cases[i].beam, &cases[i].pfs, &cases[i].dfs))
+        {
+            fprintf(stderr, "%s: could not read\n", options->cases[i]);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", options->socket_path);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0)
+    {
+        fprintf(stderr, "Could not connect to %s: %s\n", options->socket_path, strerror(errno));
+        return 1;
+    }
+
+    const long total = (long) options->repeats * options->cases_count;
+    uint64_t * sent_at = calloc(total, sizeof(uint64_t));
+    uint64_t * round_trip = calloc(total, sizeof(uint64_t));
+    uint64_t * server = calloc(total, sizeof(uint64_t));
+    if (sent_at == NULL || round_trip == NULL || server == NULL) return 1;
+
+    SompBuffer output = {0}, input = {0};
+    long sent = 0, received = 0, failed = 0;
+    uint64_t start = somp_now_ns();
+    while (received < total)
+    {
+        // Send a window of requests, then read their responses
+        for (; sent < total && sent - received < options->pipeline; sent++)
+        {
+            ClientCase * c = &cases[sent % options->cases_count];
+            if (!somp_encode_request(&output, sent, c->beam.length, c->beam.supports,
+                        c->pfs.items, c->pfs.count, c->dfs.items, c->dfs.count)) return 1;
+            sent_at[sent] = somp_now_ns();
+        }
+        if (output.count > 0 && !write_all(fd, output.items, output.count))
+        {
+            fprintf(stderr, "Lost the daemon while sending\n");
+            return 1;
+        }
+        output.count = 0;
+
+        while (received < sent)
+        {
+            long frame = somp_frame_size(input.items, input.count);
+            if (frame == 0)
+            {
+                if (!read_some(fd, &input))
+                {
+                    fprintf(stderr, "Lost the daemon while receiving\n");
+                    return 1;
+                }
+                continue;
+            }
+
+            SompResponseHeader header = {0};
+            Beam beam;
+            if (frame < 0 || !somp_decode_response(input.items + sizeof(uint32_t), frame - sizeof(uint32_t), &header, &beam)
+                    || header.id != (uint32_t) received)
+            {
+                if (frame > 0 && header.magic == SOMP_RESPONSE_MAGIC && header.version != SOMP_PROTOCOL_VERSION)
+                    fprintf(stderr, "The daemon speaks protocol version %u, this client %d\n", header.version, SOMP_PROTOCOL_VERSION);
+                else fprintf(stderr, "Bad response from the daemon\n");
+                return 1;
+            }
+            round_trip[received] = somp_now_ns() - sent_at[received];
+            server[received] = header.latencyNs;
+            if (header.status != SOMP_STATUS_OK) failed++;
+
+            // The first answer for every case is printed
+            if (received < options->cases_count)
+            {
+                const ClientCase * c = &cases[received];
+                if (header.status == SOMP_STATUS_OK)
+                {
+                    printf("%s: wall force %.4f, wall moment %.4f", options->cases[received],
+                            beam.wall_reaction_force, beam.wall_reaction_moment);
+                    if (c->beam.supports.left != SUPPORT_DEFAULT || c->beam.supports.right != SUPPORT_DEFAULT)
+                        printf(", end force %.4f, end moment %.4f", beam.end_reaction_force, beam.end_reaction_moment);
+                    printf(", %d sections\n", beam.sections_count);
+                }
+                else printf("%s: failed with status %d\n", options->cases[received], header.status);
+            }
+
+            memmove(input.items, input.items + frame, input.count - frame);
+            input.count -= frame;
+            received++;
+        }
+    }
+    double seconds = (somp_now_ns() - start) / 1e9;
+
+    printf("%ld requests (%ld failed) in %.3fs, %.0f requests/s, pipeline %d\n",
+            total, failed, seconds, total / seconds, options->pipeline);
+    print_latencies("round trip", round_trip, total);
+    print_latencies("daemon", server, total);
+
+    close(fd);
+    return failed == 0 ? 0 : 1;
+}
+// ======================================================================
+
+static void usage(const char * program)
+{
+    fprintf(stderr, "Usage: %s [-s socket] [-w contexts] [-v]\n", program);
+    fprintf(stderr, "       %s -c [-s socket] [-n repeats] [-p pipeline] case.txt...\n", program);
+}
+
+static bool parse_options(int argc, char * argv[], DaemonOptions * options)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    *options = (DaemonOptions){
+        .socket_path = DEFAULT_SOCKET_PATH,
+        .contexts = (cores > 0) ? cores : 1,
+        .repeats = 1,
+        .pipeline = 32,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:w:vcn:p:")) != -1)
+    {
+        switch (opt) {
+        case 's': options->socket_path = optarg; break;
+        case 'w': options->contexts = atoi(optarg); break;
+        case 'v': options->verbose = true; break;
+        case 'c': options->client = true; break;
+        case 'n': options->repeats = atoi(optarg); break;
+        case 'p': options->pipeline = atoi(optarg); break;
+        default: return false;
+        }
+    }
+    options->cases = &argv[optind];
+    options->cases_count = argc - optind;
+
+    if (options->contexts < 1 || options->repeats < 1 || options->pipeline < 1) return false;
+    if (options->client) return options->cases_count > 0;
+    return options->cases_count == 0;
+}
+
+int main(int argc, char * argv[])
+{
+    DaemonOptions options;
+    if (!parse_options(argc, argv, &options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    verbose = options.verbose;
+    return options.client ? run_client(&options) : run_server(&options);
+}
@@ -0,0 +1,83 @@
+/*
+* Filename:	somp_diff.c
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Differential test of the solver: solves random beams with solveBeam and
+* with the long double reference in somp_reference.h and checks that they
+* agree, and that the free end carries no shear or moment. The first
+* failing beam is shrunk and printed in the cli input format
+*
+* Usage: somp_diff.out [-n cases] [-s seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UTILS_IMPLEMENTATION
+#include "utils.h"
+
+#define SOMP_LOGIC_IMPLEMENTATION
+#include "somp_logic.h"
+
+#define SOMP_REFERENCE_IMPLEMENTATION
+#include "somp_reference.h"
+
+#define DEFAULT_CASES 1000000
+
+int main(int argc, char * argv[])
+{
+    long cases = DEFAULT_CASES;
+    uint64_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt) {
+        case 'n': cases = atol(optarg); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "Usage: %s [-n cases] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SolverContext ctx;
+    initSolverContext(&ctx);
+
+    // Every case gets its own seed so a failure can be rerun on its own
+    // with -n 1 -s <case seed>
+    clock_t start = clock();
+    for (long i = 0; i < cases; i++)
+    {
+        uint64_t case_seed = seed + i;
+        uint64_t state = case_seed;
+        RefCase c;
+        ref_generate_case(&state, &c);
+
+        RefResult result;
+        if (ref_check_case(&ctx, &c, &result)) continue;
+
+        printf("Case %ld (seed %llu) failed: %s at x=%g, expected %.9g, got %.9g\n",
+                i, (unsigned long long) case_seed, result.what, result.x, result.expected, result.actual);
+        ref_print_case(stdout, &c);
+
+        ref_shrink_case(&ctx, &c);
+        ref_check_case(&ctx, &c, &result);
+        printf("Shrunk to: %s at x=%g, expected %.9g, got %.9g\n",
+                result.what, result.x, result.expected, result.actual);
+        ref_print_case(stdout, &c);
+
+        freeSolverContext(&ctx);
+        return 1;
+    }
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%ld cases from seed %llu agree with the reference (%.2fs)\n",
+            cases, (unsigned long long) seed, seconds);
+    freeSolverContext(&ctx);
+    return 0;
+}
@@ -0,0 +1,290 @@
+#ifndef SOMP_FORCES_H
+#define SOMP_FORCES_H
+
+/*
+* Filename:	somp_forces.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Force containers that stay sorted (point forces by distance, distributed
+* forces by start) so the solver gets them already in order. Forces are
+* referred to by handles, the index of a force changes when others are added
+* or moved but its handle does not
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+typedef int ForceHandle;
+#define NO_FORCE_HANDLE (-1)
+
+typedef struct {
+	int * items;
+	int count;
+	int capacity;
+} ForceIndices;
+
+typedef struct {
+	PointForces forces;   // sorted by distance
+	ForceIndices handles; // handles.items[i] is the handle of forces.items[i]
+	ForceIndices lookup;  // lookup.items[handle] is the index in forces, -1 once removed
+	int version;          // changes every time the forces change
+} SortedPointForces;
+
+typedef struct {
+	DistributedForces forces; // sorted by start
+	ForceIndices handles;
+	ForceIndices lookup;
+	int version;
+} SortedDistrForces;
+
+ForceHandle sorted_pf_insert(SortedPointForces * pfs, PointForce pf);
+bool sorted_pf_modify(SortedPointForces * pfs, ForceHandle handle, PointForce pf);
+bool sorted_pf_remove(SortedPointForces * pfs, ForceHandle handle);
+PointForce * sorted_pf_get(const SortedPointForces * pfs, ForceHandle handle);
+void sorted_pf_clear(SortedPointForces * pfs);
+void sorted_pf_free(SortedPointForces * pfs);
+
+ForceHandle sorted_df_insert(SortedDistrForces * dfs, DistributedForce df);
+bool sorted_df_modify(SortedDistrForces * dfs, ForceHandle handle, DistributedForce df);
+bool sorted_df_remove(SortedDistrForces * dfs, ForceHandle handle);
+DistributedForce * sorted_df_get(const SortedDistrForces * dfs, ForceHandle handle);
+void sorted_df_clear(SortedDistrForces * dfs);
+void sorted_df_free(SortedDistrForces * dfs);
+
+#ifdef SOMP_FORCES_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+// ==================== HANDLE BOOKKEEPING ==============================
+static int force_index(const ForceIndices * lookup, ForceHandle handle)
+{
+	if (handle < 0 || handle >= lookup->count) return -1;
+	return lookup->items[handle];
+}
+
+static void force_handles_reindex(ForceIndices * handles, ForceIndices * lookup, int from, int to)
+{
+	for (int i = from; i <= to && i < handles->count; i++) lookup->items[handles->items[i]] = i;
+}
+
+// Room for one more force in all three arrays, checked up front so an insert
+// either happens completely or not at all
+static bool force_handles_reserve(ForceIndices * handles, ForceIndices * lookup)
+{
+	return DynamicArrayReserve(handles, handles->count+1)
+		&& DynamicArrayReserve(lookup, lookup->count+1);
+}
+
+static ForceHandle force_handles_insert(ForceIndices * handles, ForceIndices * lookup, int index)
+{
+	lookup->items[lookup->count++] = -1;
+	ForceHandle handle = lookup->count-1;
+
+	handles->items[handles->count++] = handle;
+	memmove(&handles->items[index+1], &handles->items[index], (handles->count-1-index)*sizeof(int));
+	handles->items[index] = handle;
+	force_handles_reindex(handles, lookup, index, handles->count-1);
+
+	return handle;
+}
+
+static void force_handles_remove(ForceIndices * handles, ForceIndices * lookup, int index)
+{
+	lookup->items[handles->items[index]] = -1;
+	memmove(&handles->items[index], &handles->items[index+1], (handles->count-1-index)*sizeof(int));
+	handles->count--;
+	force_handles_reindex(handles, lookup, index, handles->count-1);
+}
+
+// Moves the handle at index from to index to, everything in between shifts
+// by one, same as what happens to the forces
+static void force_handles_move(ForceIndices * handles, ForceIndices * lookup, int from, int to)
+{
+	int handle = handles->items[from];
+	if (from < to) memmove(&handles->items[from], &handles->items[from+1], (to-from)*sizeof(int));
+	else memmove(&handles->items[to+1], &handles->items[to], (from-to)*sizeof(int));
+	handles->items[to] = handle;
+	force_handles_reindex(handles, lookup, MIN(from, to), MAX(from, to));
+}
+// ======================================================================
+// ====================== POINT FORCES ==================================
+// Index after the last force with distance <= the given distance
+static int sorted_pf_upper_bound(const SortedPointForces * pfs, float distance)
+{
+	int lo = 0, hi = pfs->forces.count;
+	while (lo < hi)
+	{
+		int mid = lo + (hi-lo)/2;
+		if (pfs->forces.items[mid].distance <= distance) lo = mid+1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+// Returns: the handle of the new force, NO_FORCE_HANDLE if there was no memory
+ForceHandle sorted_pf_insert(SortedPointForces * pfs, PointForce pf)
+{
+	int index = sorted_pf_upper_bound(pfs, pf.distance);
+	PointForces * f = &pfs->forces;
+
+	if (!DynamicArrayReserve(f, f->count+1) || !force_handles_reserve(&pfs->handles, &pfs->lookup))
+	{
+		return NO_FORCE_HANDLE;
+	}
+	f->count++;
+	memmove(&f->items[index+1], &f->items[index], (f->count-1-index)*sizeof(PointForce));
+	f->items[index] = pf;
+
+	pfs->version++;
+	return force_handles_insert(&pfs->handles, &pfs->lookup, index);
+}
+
+bool sorted_pf_modify(SortedPointForces * pfs, ForceHandle handle, PointForce pf)
+{
+	int from = force_index(&pfs->lookup, handle);
+	if (from < 0) return false;
+
+	// Slide the force to its new spot, usually it moves past a few neighbours
+	PointForce * items = pfs->forces.items;
+	int to = from;
+	while (to > 0 && items[to-1].distance > pf.distance) to--;
+	while (to < pfs->forces.count-1 && items[to+1].distance < pf.distance) to++;
+
+	if (from < to) memmove(&items[from], &items[from+1], (to-from)*sizeof(PointForce));
+	else if (from > to) memmove(&items[to+1], &items[to], (from-to)*sizeof(PointForce));
+	items[to] = pf;
+	if (from != to) force_handles_move(&pfs->handles, &pfs->lookup, from, to);
+
+	pfs->version++;
+	return true;
+}
+
+bool sorted_pf_remove(SortedPointForces * pfs, ForceHandle handle)
+{
+	int index = force_index(&pfs->lookup, handle);
+	if (index < 0) return false;
+
+	PointForces * f = &pfs->forces;
+	memmove(&f->items[index], &f->items[index+1], (f->count-1-index)*sizeof(PointForce));
+	f->count--;
+	force_handles_remove(&pfs->handles, &pfs->lookup, index);
+
+	pfs->version++;
+	return true;
+}
+
+// The pointer is only valid until the next insert, modify or remove
+PointForce * sorted_pf_get(const SortedPointForces * pfs, ForceHandle handle)
+{
+	int index = force_index(&pfs->lookup, handle);
+	if (index < 0) return NULL;
+	return &pfs->forces.items[index];
+}
+
+void sorted_pf_clear(SortedPointForces * pfs)
+{
+	pfs->forces.count = 0;
+	pfs->handles.count = 0;
+	pfs->lookup.count = 0;
+	pfs->version++;
+}
+
+void sorted_pf_free(SortedPointForces * pfs)
+{
+	free(pfs->forces.items);
+	free(pfs->handles.items);
+	free(pfs->lookup.items);
+	*pfs = (SortedPointForces){0};
+}
+// ======================================================================
+// ====================== DISTRIBUTED FORCES ============================
+static int sorted_df_upper_bound(const SortedDistrForces * dfs, float start)
+{
+	int lo = 0, hi = dfs->forces.count;
+	while (lo < hi)
+	{
+		int mid = lo + (hi-lo)/2;
+		if (dfs->forces.items[mid].start <= start) lo = mid+1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+ForceHandle sorted_df_insert(SortedDistrForces * dfs, DistributedForce df)
+{
+	int index = sorted_df_upper_bound(dfs, df.start);
+	DistributedForces * f = &dfs->forces;
+
+	if (!DynamicArrayReserve(f, f->count+1) || !force_handles_reserve(&dfs->handles, &dfs->lookup))
+	{
+		return NO_FORCE_HANDLE;
+	}
+	f->count++;
+	memmove(&f->items[index+1], &f->items[index], (f->count-1-index)*sizeof(DistributedForce));
+	f->items[index] = df;
+
+	dfs->version++;
+	return force_handles_insert(&dfs->handles, &dfs->lookup, index);
+}
+
+bool sorted_df_modify(SortedDistrForces * dfs, ForceHandle handle, DistributedForce df)
+{
+	int from = force_index(&dfs->lookup, handle);
+	if (from < 0) return false;
+
+	DistributedForce * items = dfs->forces.items;
+	int to = from;
+	while (to > 0 && items[to-1].start > df.start) to--;
+	while (to < dfs->forces.count-1 && items[to+1].start < df.start) to++;
+
+	if (from < to) memmove(&items[from], &items[from+1], (to-from)*sizeof(DistributedForce));
+	else if (from > to) memmove(&items[to+1], &items[to], (from-to)*sizeof(DistributedForce));
+	items[to] = df;
+	if (from != to) force_handles_move(&dfs->handles, &dfs->lookup, from, to);
+
+	dfs->version++;
+	return true;
+}
+
+bool sorted_df_remove(SortedDistrForces * dfs, ForceHandle handle)
+{
+	int index = force_index(&dfs->lookup, handle);
+	if (index < 0) return false;
+
+	DistributedForces * f = &dfs->forces;
+	memmove(&f->items[index], &f->items[index+1], (f->count-1-index)*sizeof(DistributedForce));
+	f->count--;
+	force_handles_remove(&dfs->handles, &dfs->lookup, index);
+
+	dfs->version++;
+	return true;
+}
+
+DistributedForce * sorted_df_get(const SortedDistrForces * dfs, ForceHandle handle)
+{
+	int index = force_index(&dfs->lookup, handle);
+	if (index < 0) return NULL;
+	return &dfs->forces.items[index];
+}
+
+void sorted_df_clear(SortedDistrForces * dfs)
+{
+	dfs->forces.count = 0;
+	dfs->handles.count = 0;
+	dfs->lookup.count = 0;
+	dfs->version++;
+}
+
+void sorted_df_free(SortedDistrForces * dfs)
+{
+	free(dfs->forces.items);
+	free(dfs->handles.items);
+	free(dfs->lookup.items);
+	*dfs = (SortedDistrForces){0};
+}
+// ======================================================================
+
+#endif // SOMP_FORCES_IMPLEMENTATION
+#endif // SOMP_FORCES_H
@@ -1,5 +1,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
@@ -10,6 +12,12 @@
 #define UTIlS_IMPLEMENTATION
 #include "utils.h"
 
+#define SOMP_FORCES_IMPLEMENTATION
+#include "somp_forces.h"
+
+#define SOMP_HITINDEX_IMPLEMENTATION
+#include "somp_hitindex.h"
+
 #define somp_loginfo(cat, msg) SDL_LogInfo((cat), (msg))
 
 #define COLOR_DEFAULT         COLOR_BLACK
@@ -25,10 +33,14 @@
 
 typedef SDL_FRect             SompBoundary;
 typedef Beam                  SompBeam;
-typedef PointForces           SompPointForces;
-typedef DistributedForces     SompDistrForces;
+typedef SortedPointForces     SompPointForces;
+typedef SortedDistrForces     SompDistrForces;
 typedef PointForce            SompPointForce;
 typedef DistributedForce      SompDistrForce;
+typedef PointMoment           SompPointMoment;
+typedef PointMoments          SompPointMoments;
+typedef DistributedMoment     SompDistrMoment;
+typedef DistributedMoments    SompDistrMoments;
 
 typedef struct {
     int windoww;
@@ -40,17 +52,34 @@ typedef struct {
     bool mouse_pressed;
     bool mouse_released;
     bool mouse_down;
+    bool mouse_moved; // any mouse event this frame, hover is only looked up then
     SDL_MouseButtonFlags mouse_state;
 
     // Keyboard
     bool _should_update_keyboard;
     const bool * keyboard;
 
-    // Temporary surfaces used for things like text
-    SDL_Surface * temp_surface;
-    SDL_Texture * temp_texture;
+    // Textures made this frame for things like text, destroyed in gui_reset
+    struct {
+        SDL_Texture ** items;
+        int count;
+        int capacity;
+    } temp_textures;
+
+    // Set from the SOMP_RECORD environment variable, see somp_main
+    bool record_checked;
+    FILE * record_file;
+    uint64_t frame;
 } SompGui;
 
+// A recording is this header followed by one SompRecordedEvent for every
+// event somp_main handled
+#define SOMP_RECORD_MAGIC "SOMPREC1"
+typedef struct {
+    uint64_t frame;
+    SDL_Event event;
+} SompRecordedEvent;
+
 typedef enum {
     TOP_LEFT = 0,
     TOP_CENTRE,
@@ -72,19 +101,30 @@ typedef enum {
     MOD_DISTR_FORCE,
     MOD_DISTR_FORCE_START,
     MOD_DISTR_FORCE_END,
+    ADD_POINT_MOMENT,
+    ADD_DISTRIB_MOMENT,
 } SolveMode;
 
 typedef struct {
     SompBeam beam;
     SompPointForces point_forces;
     SompDistrForces distr_forces;
+    // Not sorted, the solver sorts a copy anyway
+    SompPointMoments point_moments;
+    SompDistrMoments distr_moments;
 
+    // Handles stay valid when the force arrays get reordered or reallocated
     union {
-        SompPointForce * mod_point_force;
-        SompDistrForce * mod_distr_force;
+        ForceHandle mod_point_force;
+        ForceHandle mod_distr_force;
     };
     bool distributed_first_placed;
 
+    // Screen extents of every force, hovered is looked up in it once per
+    // mouse event instead of testing every force every frame
+    HitIndex hit_index;
+    HitItem hovered;
+
     // TODO: magic number
     // Also this is just a TERRIBLE idea, we should look into a temporary
     // allocator instead
@@ -93,27 +133,306 @@ typedef struct {
     SolveMode mode;
 } somp_section_solve_t;
 
+// Every state starts with this so a reloaded module can tell which layout
+// the previous module left behind
+#define SOMP_STATE_MAGIC 0x504d4f53 // "SOMP"
+#define SOMP_STATE_VERSION 4
 typedef struct {
+    uint32_t magic;
+    int version;
+    size_t size;
+} SompStateHeader;
+
+typedef struct {
+    SompStateHeader header;
     SDL_Window * window;
     SDL_Renderer * renderer;
     TTF_Font * font;
 
+    // Migrations only read the beam, forces and moments at the start of
+    // solve, keep them there
     somp_section_solve_t solve;
 
 } SompState;
 
+// ==================== STATE VERSIONS ==================================
+// Layouts that older modules left behind, only the part the migrations read
+// is described. These never change: when SompState, Beam or the force
+// containers change layout bump SOMP_STATE_VERSION, freeze the old layout
+// here and add a migration for it
+typedef struct {
+    float start;
+    float end;
+    float pointForce;
+    float polynomial[4];
+} SectionV1;
+typedef struct {
+    float length;
+    float wall_reaction_force;
+    float wall_reaction_moment;
+    int sections_count;
+    SectionV1 raws[20];
+    SectionV1 shears[20];
+    SectionV1 moments[20];
+} BeamV1;
+typedef struct { float distance; float force; } PointForceV1;
+typedef struct { float start; float end; float polynomial[4]; } DistrForceV1;
+typedef struct {
+    void * items;
+    int count;
+    int capacity;
+} ArrayV1;
+typedef struct {
+    ArrayV1 forces;
+    ArrayV1 handles;
+    ArrayV1 lookup;
+    int version;
+} SortedForcesV1;
+typedef struct {
+    SompStateHeader header;
+    SDL_Window * window;
+    SDL_Renderer * renderer;
+    TTF_Font * font;
+    BeamV1 beam;
+    SortedForcesV1 point_forces;
+    SortedForcesV1 distr_forces;
+} SompStateV1;
+
+// Version 2: the beam got its supports and the reactions at its end
+typedef struct {
+    float length;
+    float wall_reaction_force;
+    float wall_reaction_moment;
+    int sections_count;
+    struct { int left, right; } supports;
+    float end_reaction_force;
+    float end_reaction_moment;
+    SectionV1 raws[20];
+    SectionV1 shears[20];
+    SectionV1 moments[20];
+} BeamV2;
+typedef struct {
+    SompStateHeader header;
+    SDL_Window * window;
+    SDL_Renderer * renderer;
+    TTF_Font * font;
+    BeamV2 beam;
+    SortedForcesV1 point_forces;
+    SortedForcesV1 distr_forces;
+} SompStateV2;
+
+// Version 3: the beam got its applied moments, the moments came after the
+// forces
+typedef struct {
+    float length;
+    float wall_reaction_force;
+    float wall_reaction_moment;
+    int sections_count;
+    struct { int left, right; } supports;
+    float end_reaction_force;
+    float end_reaction_moment;
+    SectionV1 raws[20];
+    SectionV1 shears[20];
+    SectionV1 moments[20];
+    SectionV1 applied_moments[20];
+} BeamV3;
+typedef struct { float distance; float moment; } PointMomentV3;
+typedef struct { float start; float end; float polynomial[4]; } DistrMomentV3;
+typedef struct {
+    SompStateHeader header;
+    SDL_Window * window;
+    SDL_Renderer * renderer;
+    TTF_Font * font;
+    BeamV3 beam;
+    SortedForcesV1 point_forces;
+    SortedForcesV1 distr_forces;
+    ArrayV1 point_moments;
+    ArrayV1 distr_moments;
+} SompStateV3;
+
+// Version 4: the beam got its axial and torque channels
+typedef struct {
+    float length;
+    float wall_reaction_force;
+    float wall_reaction_moment;
+    int sections_count;
+    struct { int left, right; } supports;
+    float end_reaction_force;
+    float end_reaction_moment;
+    float wall_reaction_axial;
+    float wall_reaction_torque;
+    SectionV1 raws[20];
+    SectionV1 shears[20];
+    SectionV1 moments[20];
+    SectionV1 applied_moments[20];
+    SectionV1 applied_axial[20];
+    SectionV1 applied_torques[20];
+    SectionV1 axials[20];
+    SectionV1 torques[20];
+} BeamV4;
+typedef struct {
+    SompStateHeader header;
+    SDL_Window * window;
+    SDL_Renderer * renderer;
+    TTF_Font * font;
+    BeamV4 beam;
+    SortedForcesV1 point_forces;
+    SortedForcesV1 distr_forces;
+    ArrayV1 point_moments;
+    ArrayV1 distr_moments;
+} SompStateV4;
+
+// The live layout is version 4, this fails to compile as soon as it drifts
+// without a version bump
+#if SOMP_STATE_VERSION == 4
+_Static_assert(sizeof(SompBeam) == sizeof(BeamV4), "Beam changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompBeam, supports) == offsetof(BeamV4, supports), "Beam changed, bump SOMP_STATE_VERSION");
+_Static_assert(sizeof(SompPointForce) == sizeof(PointForceV1), "PointForce changed, bump SOMP_STATE_VERSION");
+_Static_assert(sizeof(SompDistrForce) == sizeof(DistrForceV1), "DistributedForce changed, bump SOMP_STATE_VERSION");
+_Static_assert(sizeof(SompPointMoment) == sizeof(PointMomentV3), "PointMoment changed, bump SOMP_STATE_VERSION");
+_Static_assert(sizeof(SompDistrMoment) == sizeof(DistrMomentV3), "DistributedMoment changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompState, solve.beam) == offsetof(SompStateV4, beam), "SompState changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompState, solve.point_forces) == offsetof(SompStateV4, point_forces), "SompState changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompState, solve.distr_forces) == offsetof(SompStateV4, distr_forces), "SompState changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompState, solve.point_moments) == offsetof(SompStateV4, point_moments), "SompState changed, bump SOMP_STATE_VERSION");
+_Static_assert(offsetof(SompState, solve.distr_moments) == offsetof(SompStateV4, distr_moments), "SompState changed, bump SOMP_STATE_VERSION");
+#endif
+// ======================================================================
+
 
 SompState * somp_state;
 SompGui gui = {0};
 
 void gui_init(SompGui * const gui);
 
+SompState * new_state(SDL_Window * window, SDL_Renderer * renderer, TTF_Font * font)
+{
+    SompState * state = calloc(1, sizeof(SompState));
+    if (state == NULL) return NULL;
+
+    state->header = (SompStateHeader){ SOMP_STATE_MAGIC, SOMP_STATE_VERSION, sizeof(SompState) };
+    state->window = window;
+    state->renderer = renderer;
+    state->font = font;
+    state->solve.beam.length = 1.0;
+    state->solve.beam.sections_count = MAX_SECTIONS;
+    return state;
+}
+// Inserts the forces of an older state again so the handles are rebuilt for
+// the new containers, then frees the old arrays. They came from the same
+// heap as the old module so they can be freed from here
+void migrate_forces(SompState * state, SortedForcesV1 * point_forces, SortedForcesV1 * distr_forces)
+{
+    const PointForceV1 * pfs = point_forces->forces.items;
+    for (int i = 0; i < point_forces->forces.count; i++)
+    {
+        sorted_pf_insert(&state->solve.point_forces, (SompPointForce){ .distance = pfs[i].distance, .force = pfs[i].force });
+    }
+    const DistrForceV1 * dfs = distr_forces->forces.items;
+    for (int i = 0; i < distr_forces->forces.count; i++)
+    {
+        SompDistrForce df = { .start = dfs[i].start, .end = dfs[i].end };
+        for (int j = 0; j < 4 && j < MAX_POLYNOMIAL_DEGREE; j++) df.polynomial[j] = dfs[i].polynomial[j];
+        sorted_df_insert(&state->solve.distr_forces, df);
+    }
+
+    free(point_forces->forces.items);
+    free(point_forces->handles.items);
+    free(point_forces->lookup.items);
+    free(distr_forces->forces.items);
+    free(distr_forces->handles.items);
+    free(distr_forces->lookup.items);
+}
+// Builds a fresh state out of a version 1 state and frees the old one. Only
+// the beam length and the forces survive, everything else (hit index,
+// solved sections, modes) starts empty and gets rebuilt when needed.
+// Whatever else the old state owned (the hit index) is leaked, it is small
+// and only happens on a reload
+SompState * migrate_state_v1(void * old_state)
+{
+    SompStateV1 * old = old_state;
+    SompState * state = new_state(old->window, old->renderer, old->font);
+    if (state == NULL) return NULL;
+
+    state->solve.beam.length = old->beam.length;
+    migrate_forces(state, &old->point_forces, &old->distr_forces);
+    free(old);
+    return state;
+}
+// Same as migrate_state_v1, the supports survive as well
+SompState * migrate_state_v2(void * old_state)
+{
+    SompStateV2 * old = old_state;
+    SompState * state = new_state(old->window, old->renderer, old->font);
+    if (state == NULL) return NULL;
+
+    state->solve.beam.length = old->beam.length;
+    state->solve.beam.supports = (BeamSupports){ old->beam.supports.left, old->beam.supports.right };
+    migrate_forces(state, &old->point_forces, &old->distr_forces);
+    free(old);
+    return state;
+}
+// Same as migrate_state_v2, the moments are taken over as they are: their
+// layout did not change
+SompState * migrate_state_v3(void * old_state)
+{
+    SompStateV3 * old = old_state;
+    SompState * state = new_state(old->window, old->renderer, old->font);
+    if (state == NULL) return NULL;
+
+    state->solve.beam.length = old->beam.length;
+    state->solve.beam.supports = (BeamSupports){ old->beam.supports.left, old->beam.supports.right };
+    migrate_forces(state, &old->point_forces, &old->distr_forces);
+    state->solve.point_moments = (SompPointMoments){ old->point_moments.items, old->point_moments.count, old->point_moments.capacity };
+    state->solve.distr_moments = (SompDistrMoments){ old->distr_moments.items, old->distr_moments.count, old->distr_moments.capacity };
+    free(old);
+    return state;
+}
+// Same as migrate_state_v3, the beam only grew. Also runs for the current
+// version when SompState changed size behind the moments
+SompState * migrate_state_v4(void * old_state)
+{
+    SompStateV4 * old = old_state;
+    SompState * state = new_state(old->window, old->renderer, old->font);
+    if (state == NULL) return NULL;
+
+    state->solve.beam.length = old->beam.length;
+    state->solve.beam.supports = (BeamSupports){ old->beam.supports.left, old->beam.supports.right };
+    migrate_forces(state, &old->point_forces, &old->distr_forces);
+    state->solve.point_moments = (SompPointMoments){ old->point_moments.items, old->point_moments.count, old->point_moments.capacity };
+    state->solve.distr_moments = (SompDistrMoments){ old->distr_moments.items, old->distr_moments.count, old->distr_moments.capacity };
+    free(old);
+    return state;
+}
+// Starts over with an empty beam when no migration knows the old layout.
+// Every version starts with the header, window, renderer and font of
+// version 1, the rest of the old state is leaked
+SompState * fresh_state(void * old_state)
+{
+    SompStateV1 * old = old_state;
+    SompState * state = new_state(old->window, old->renderer, old->font);
+    if (state == NULL) return NULL;
+    free(old);
+    return state;
+}
+typedef SompState * state_migration_t(void * old_state);
+// migrations[v] turns a state of version v into the current version, the
+// current version has one too for when only its size changed
+state_migration_t * const state_migrations[SOMP_STATE_VERSION+1] = {
+    [1] = migrate_state_v1,
+    [2] = migrate_state_v2,
+    [3] = migrate_state_v3,
+    [4] = migrate_state_v4,
+};
+_Static_assert(SOMP_STATE_VERSION == 4, "Add a migration for the new version to state_migrations");
+
 // ==================== HOT RELOAD FUNCS ================================
 //bool somp_init(void * state, SDL_Window * window, SDL_Renderer * renderer, TTF_TextEngine * text_engine)
 bool somp_init(void * state, SDL_Window * window, SDL_Renderer * renderer,...)
 {
-    if (!state) somp_state = malloc(sizeof(SompState));
+    if (!state) somp_state = new_state(window, renderer, NULL);
     else somp_state = state;
+    if (somp_state == NULL) return false;
 
     somp_state->window = window;
     somp_state->renderer = renderer;
@@ -121,24 +440,48 @@ bool somp_init(void * state, SDL_Window * window, SDL_Renderer * renderer,...)
 
 #define LIBERATION_SERIF_FILE "/usr/share/fonts/truetype/liberation/LiberationSerif-Regular.ttf"
     somp_state->font = TTF_OpenFont(LIBERATION_SERIF_FILE, 48);
-    somp_state->solve.beam.length = 1.0;
-    somp_state->solve.beam.sections_count = MAX_SECTIONS;
     gui_init(&gui);
 
     return true;
 };
-bool somp_reload(void * state)
+// Takes over the state of the previous module, migrating it when the layout
+// changed in between
+// Returns: the state to use from now on (the old one may have been freed),
+//          NULL when the state can not be used
+void * somp_reload(void * state)
 {
     if (!state)
     {
         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Received invalid state. Run somp_init before reload\n");
-        return false;
-    } else somp_state = state;
+        return NULL;
+    }
 
-    somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Hot Reload\n");
+    const SompStateHeader * header = state;
+    if (header->magic != SOMP_STATE_MAGIC || header->version < 1 || header->version > SOMP_STATE_VERSION)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unknown state layout, restart to reload this module\n");
+        return NULL;
+    }
+
+    if (header->version == SOMP_STATE_VERSION && header->size == sizeof(SompState))
+    {
+        somp_state = state;
+        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Hot Reload\n");
+    } else
+    {
+        state_migration_t * migrate = NULL;
+        if (header->version < (int)(sizeof(state_migrations)/sizeof(*state_migrations))) migrate = state_migrations[header->version];
+        if (migrate == NULL)
+        {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Hot Reload, no migration from version %d, starting over\n", header->version);
+            migrate = fresh_state;
+        } else SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Hot Reload, migrating state from version %d\n", header->version);
+        somp_state = migrate(state);
+        if (somp_state == NULL) return NULL;
+    }
     gui_init(&gui);
 
-    return true;
+    return somp_state;
 };
 SompState * somp_close()
 {
@@ -146,45 +489,25 @@ SompState * somp_close()
 };
 // ======================================================================
 // ====================== SOLVE SECTION =================================
-void mod_distr_force_enter(const SompBoundary beam_bound, const SompBeam beam, SompDistrForce * distr_force);
+void mod_distr_force_enter(const SompBoundary beam_bound, const SompBeam beam, ForceHandle handle);
 #define swap(x,y,type) do { type t = (x); x = y; y = t; } while(0)
 
-bool remove_point_force(SompPointForces * pfs, SompPointForce * pf)
+bool remove_point_force(SompPointForces * pfs, ForceHandle handle)
 {
-    if (pf < pfs->items || pf > pfs->items+pfs->count-1)
+    if (!sorted_pf_remove(pfs, handle))
     {
-        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: pointer to pf not in range of dynamic array.\n");
+        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: point force handle is not valid.\n");
         return false;
     }
-
-    int index = pf - pfs->items;
-    if (index < 0 || index >= pfs->count)
-    {
-        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: pointer to pf not in range of dynamic array.\n");
-        return false;
-    }
-
-    DynamicArrayRemoveShuffle(pfs, index);
-
     return true;
 }
-bool remove_distr_force(SompDistrForces * dfs, SompDistrForce * df)
+bool remove_distr_force(SompDistrForces * dfs, ForceHandle handle)
 {
-    if (df < dfs->items || df > dfs->items+dfs->count-1)
-    {
-        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: pointer to pf not in range of dynamic array.\n");
-        return false;
-    }
-
-    int index = df - dfs->items;
-    if (index < 0 || index >= dfs->count)
+    if (!sorted_df_remove(dfs, handle))
     {
-        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: pointer to pf not in range of dynamic array.\n");
+        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "ERROR: distributed force handle is not valid.\n");
         return false;
     }
-
-    DynamicArrayRemoveShuffle(dfs, index);
-
     return true;
 }
 float px_to_force(float y, SompBoundary bound)
@@ -247,15 +570,25 @@ SDL_FRect anchor_rect(SDL_FRect r, RectAnchor a)
 };
 SDL_Texture * get_text_texture(SDL_Renderer * sdl_renderer, const char * text, SDL_Color color)
 {
-    gui.temp_surface = TTF_RenderText_Solid(somp_state->font, text, 0, color);
-    gui.temp_texture = SDL_CreateTextureFromSurface(sdl_renderer, gui.temp_surface);
-
-    return gui.temp_texture;
+    SDL_Surface * surface = TTF_RenderText_Solid(somp_state->font, text, 0, color);
+    if (surface == NULL) return NULL;
+    SDL_Texture * texture = SDL_CreateTextureFromSurface(sdl_renderer, surface);
+    SDL_DestroySurface(surface);
+    if (texture == NULL) return NULL;
+
+    // Callers hold on to the texture for the rest of the frame
+    if (!DynamicArrayTryAppend(&gui.temp_textures, texture))
+    {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
+    return texture;
 };
 SDL_Texture * text(SDL_Renderer * sdl_renderer, const char * text, float x, float y,
         SDL_Color color, RectAnchor anchor)
 {
     SDL_Texture * texture = get_text_texture(sdl_renderer, text, color);
+    if (texture == NULL) return NULL;
 
     SDL_FRect dstrect = { x, y, texture->w, texture->h };
     dstrect = anchor_rect(dstrect, anchor);
@@ -287,15 +620,40 @@ SDL_Texture * distance_text(SDL_Renderer * sdl_renderer, float distance, float x
     snprintf(text_buf, sizeof(text_buf), "%.3fm", distance);
 
     RectAnchor anchor = BOT_LEFT;
-    float new_y = y - ft->h;
+    float ft_h = (ft != NULL) ? ft->h : 0;
+    float new_y = y - ft_h;
     if (y > beam_bound.y+beam_bound.h/2) {
         anchor = TOP_LEFT;
-        new_y = y + ft->h;
+        new_y = y + ft_h;
     }
 
     return text(sdl_renderer, text_buf, x, new_y, EJSDL_COLOR(COLOR_BLACK), anchor);
 };
-void render_beam(SompBoundary beam_bound)
+// A wall for fixed, a triangle under the beam for a pin and a roller (with a
+// second line under it), nothing for free
+void render_support(SompBoundary beam_bound, SDL_FRect beam_rect, float x, SupportKind kind)
+{
+    // TODO: magic numbers
+    const float size = 10;
+    const float y = beam_rect.y + beam_rect.h;
+
+    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_BLACK);
+    switch (kind) {
+    case SUPPORT_FIXED:
+        SDL_RenderLine(somp_state->renderer, x, beam_bound.y, x, beam_bound.y+beam_bound.h);
+        break;
+    case SUPPORT_ROLLER:
+        SDL_RenderLine(somp_state->renderer, x - size, y + 2*size, x + size, y + 2*size);
+        // fallthrough
+    case SUPPORT_PIN:
+        SDL_RenderLine(somp_state->renderer, x, y, x - size, y + 1.5*size);
+        SDL_RenderLine(somp_state->renderer, x, y, x + size, y + 1.5*size);
+        SDL_RenderLine(somp_state->renderer, x - size, y + 1.5*size, x + size, y + 1.5*size);
+        break;
+    default: break;
+    }
+}
+void render_beam(SompBoundary beam_bound, const SompBeam * beam)
 {
     SDL_FRect beam_rect = { beam_bound.x, beam_bound.y + 0.5*beam_bound.h, beam_bound.w, 10 };
     SDL_SetRenderDrawColor(somp_state->renderer, COLOR_HIBB_BEAM);
@@ -303,73 +661,68 @@ void render_beam(SompBoundary beam_bound)
     SDL_SetRenderDrawColor(somp_state->renderer, COLOR_BLACK);
     SDL_RenderRect(somp_state->renderer, &beam_rect);
 
-    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_BLACK);
-    SDL_RenderLine(somp_state->renderer, beam_bound.x, beam_bound.y, beam_rect.x, beam_bound.y+beam_bound.h);
+    BeamSupports supports = effectiveSupports(beam->supports);
+    render_support(beam_bound, beam_rect, beam_rect.x, supports.left);
+    render_support(beam_bound, beam_rect, beam_rect.x + beam_rect.w, supports.right);
 };
-void render_point_force(SompBoundary beam_bound, SompBeam beam, SompPointForce * pf, SDL_Color color)
+// Pixel position of the arrow of a point force
+void point_force_arrow(int * const x, int * const ys, int * const ye,
+        const SompBoundary beam_bound, const SompBeam beam, const SompPointForce * pf)
 {
-    somp_section_solve_t * const S = &somp_state->solve;
-    // TODO: magic numbers
-    const int hl_distance = 4;
     // Assumptions in this function
     //  1. Beam rendered in centre of beam_bound
     //  2. Beam width = 10
-    //  3. Arrow head width is same everywhere
-    int arrow_x  = lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, pf->distance)); // 1.
-    int arrow_ys = (pf->force > 0) ? beam_bound.y : beam_bound.y+beam_bound.h; // 1.
-    int arrow_ye = beam_bound.y + beam_bound.h/2 + ((pf->force > 0) ? 0 : 10);   // 2.
+    *x  = lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, pf->distance)); // 1.
+    *ys = (pf->force > 0) ? beam_bound.y : beam_bound.y+beam_bound.h; // 1.
+    *ye = beam_bound.y + beam_bound.h/2 + ((pf->force > 0) ? 0 : 10);   // 2.
+}
+bool is_hovered(HitKind kind, ForceHandle handle)
+{
+    const HitItem * hovered = &somp_state->solve.hovered;
+    return handle != NO_FORCE_HANDLE && hovered->kind == kind && hovered->handle == handle;
+}
+// handle: NO_FORCE_HANDLE for previews that are not in the force array yet
+void render_point_force(SompBoundary beam_bound, SompBeam beam, const SompPointForce * pf, ForceHandle handle, SDL_Color color)
+{
+    somp_section_solve_t * const S = &somp_state->solve;
+    // Assumptions in this function
+    //  1. Arrow head width is same everywhere
+    int arrow_x, arrow_ys, arrow_ye;
+    point_force_arrow(&arrow_x, &arrow_ys, &arrow_ye, beam_bound, beam, pf);
 
     // TODO: magic number
     SDL_Texture * force_texture = force_text(somp_state->renderer, pf->force, arrow_x, arrow_ys, beam_bound);
     distance_text(somp_state->renderer, pf->distance, arrow_x, arrow_ys, force_texture, beam_bound);
 
-    SDL_FRect hover_rect = {
-        arrow_x - hl_distance,
-        minf(arrow_ys, arrow_ye),
-        hl_distance*2,
-        abs(arrow_ye - arrow_ys)
-    };
-    if (hover(hover_rect))
+    if (is_hovered(HIT_POINT_FORCE, handle) && S->mode == NORMAL)
     {
-        if (S->mode == NORMAL)
-        {
-            SDL_SetRenderDrawColor(somp_state->renderer, COLOR_HIGHLIGHT);
-            if (gui.mouse_pressed && gui.mouse_state == SDL_BUTTON_LEFT)
-            {
-                S->mode = MOD_POINT_FORCE;
-                S->mod_point_force = pf;
-            }
-            if (gui.keyboard[SDL_SCANCODE_X]) remove_point_force(&S->point_forces, pf);
-        } else if (S->mode == ADD_POINT_FORCE)
-        {
-            SDL_SetRenderDrawColor(somp_state->renderer, COLOR_PREVIEW);
-        }
+        SDL_SetRenderDrawColor(somp_state->renderer, COLOR_HIGHLIGHT);
+    } else if (is_hovered(HIT_POINT_FORCE, handle) && S->mode == ADD_POINT_FORCE)
+    {
+        SDL_SetRenderDrawColor(somp_state->renderer, COLOR_PREVIEW);
     } else
     {
         SDL_SetRenderDrawColor(somp_state->renderer, color.r, color.g, color.b, color.a);
     }
 
     // Always highlighted when modifying
-    if (S->mode == MOD_POINT_FORCE && nearly_equal(pf->distance, S->mod_point_force->distance))
+    if (S->mode == MOD_POINT_FORCE && handle != NO_FORCE_HANDLE && handle == S->mod_point_force)
     {
         SDL_SetRenderDrawColor(somp_state->renderer, COLOR_HIGHLIGHT);
     }
-    render_arrow_vert(somp_state->renderer, arrow_x, arrow_ys, arrow_ye, 5); // 3.
+    render_arrow_vert(somp_state->renderer, arrow_x, arrow_ys, arrow_ye, 5); // 1.
 };
 
 void render_point_forces(const SompBoundary beam_bound, const SompBeam beam, const SompPointForces * point_forces)
 {
-    // loop backwards to prevent flickering when removing
-    for (int i = point_forces->count-1; i >= 0; i--)
+    for (int i = 0; i < point_forces->forces.count; i++)
     {
-        render_point_force(beam_bound, beam, &point_forces->items[i], EJSDL_COLOR(COLOR_DEFAULT));
+        render_point_force(beam_bound, beam, &point_forces->forces.items[i], point_forces->handles.items[i], EJSDL_COLOR(COLOR_DEFAULT));
     };
 }
-// TODO: I want polynomial parameter to be const but evalPolynomial takes a
-// mutable array, this should be changed
 // Returns absolute pixel values of the heights that the distributed lines should be drawns
 // Has some magic numbers
-void get_distr_line_heights(float * const ys, float * const ye, const SompBoundary beam_bound, float polynomial[], const float dist)
+void get_distr_line_heights(float * const ys, float * const ye, const SompBoundary beam_bound, const float polynomial[], const float dist)
 {
     // TODO: magic numbers
     // Assumptions in this function
@@ -393,8 +746,8 @@ void render_phony_distr_force(SompBoundary beam_bound,
     const int distr_preview_step = 16;
 
 
-    float temp_poly[MAX_POLYNOMIAL_DEGREE] = {0};
-    line_from_points(&temp_poly[1], &temp_poly[0], xs, ys, xe, ye);
+    float temp_poly[MAX_POLYNOMIAL_DEGREE];
+    poly_line(temp_poly, xs, ys, xe, ye);
 
     SDL_SetRenderDrawColor(somp_state->renderer, color.r, color.g, color.b, color.a);
 
@@ -420,34 +773,38 @@ void render_phony_distr_force(SompBoundary beam_bound,
     SDL_RenderLine(somp_state->renderer, xe, line_ys, xp, yp);
     SDL_RenderLine(somp_state->renderer, xe, line_ys, xe, line_ye);
 }
-void distr_side(SDL_FRect hover_rect,
-        const SompBoundary beam_bound, const SompBeam beam, SompDistrForce * df,
-        SDL_Color default_color, SDL_Color hl_color)
+void distr_side(HitKind side, ForceHandle handle, SDL_Color default_color, SDL_Color hl_color)
 {
     somp_section_solve_t * S = &somp_state->solve;
     SDL_Color * color = &default_color;
 
-    if (hover(hover_rect)) {
-        if (S->mode == NORMAL)
-        {
-            color = &hl_color;
-            if (gui.mouse_pressed && gui.mouse_state == SDL_BUTTON_LEFT) {
-                mod_distr_force_enter(beam_bound, beam, df);
-            }
-            if (gui.keyboard[SDL_SCANCODE_X]) remove_distr_force(&S->distr_forces, df);
-        }
-    }
-    else color = &default_color;
+    if (is_hovered(side, handle) && S->mode == NORMAL) color = &hl_color;
 
     SDL_SetRenderDrawColor(somp_state->renderer, EXPAND_COLOR(*color));
 
 }
-void render_distr_force(const SompBoundary beam_bound, const SompBeam beam, SompDistrForce * df, SDL_Color color)
+// Area around the start or end line of a distributed force that counts as
+// hovering it
+SompBoundary distr_side_hover_rect(const SompBoundary beam_bound, const SompBeam beam, const SompDistrForce * df, float dist)
 {
     // TODO: magic number
-    const int distr_preview_step = 16;
     const int hl_dist_x = 4;
-    //const int hl_dist_y = 4;
+
+    int x = lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, dist));
+    float line_ys, line_ye;
+    get_distr_line_heights(&line_ys, &line_ye, beam_bound, df->polynomial, dist);
+
+    return (SompBoundary){
+        x-hl_dist_x,
+        minf(line_ys, line_ye),
+        hl_dist_x*2,
+        fabsf(line_ye-line_ys)
+    };
+}
+void render_distr_force(const SompBoundary beam_bound, const SompBeam beam, const SompDistrForce * df, ForceHandle handle, SDL_Color color)
+{
+    // TODO: magic number
+    const int distr_preview_step = 16;
 
     int x_start = lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, df->start));
     int x_end   = lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, df->end  ));
@@ -456,14 +813,7 @@ void render_distr_force(const SompBoundary beam_bound, const SompBeam beam, Somp
     get_distr_line_heights(&line_ys, &line_ye, beam_bound, df->polynomial, df->start);
 
     // Start
-    SompBoundary hover_rect;
-    hover_rect = (SompBoundary){
-        x_start-hl_dist_x,
-        minf(line_ys, line_ye),
-        hl_dist_x*2,
-        fabsf(line_ye-line_ys)
-    };
-    distr_side(hover_rect, beam_bound, beam, df, color, EJSDL_COLOR(COLOR_HIGHLIGHT));
+    distr_side(HIT_DISTR_START, handle, color, EJSDL_COLOR(COLOR_HIGHLIGHT));
     SDL_RenderLine(somp_state->renderer, x_start, line_ys, x_start, line_ye);
 
     SDL_Texture * force_texture =force_text(somp_state->renderer,
@@ -493,13 +843,7 @@ void render_distr_force(const SompBoundary beam_bound, const SompBeam beam, Somp
     SDL_RenderLine(somp_state->renderer, x_end, line_ys, xp, yp);
 
     // End
-    hover_rect = (SompBoundary){
-        x_end-hl_dist_x,
-        minf(line_ys, line_ye),
-        hl_dist_x*2,
-        fabsf(line_ye-line_ys)
-    };
-    distr_side(hover_rect, beam_bound, beam, df, color, EJSDL_COLOR(COLOR_HIGHLIGHT));
+    distr_side(HIT_DISTR_END, handle, color, EJSDL_COLOR(COLOR_HIGHLIGHT));
     SDL_RenderLine(somp_state->renderer, x_end, line_ys, x_end, line_ye);
 
     force_text(somp_state->renderer,
@@ -510,17 +854,201 @@ void render_distr_force(const SompBoundary beam_bound, const SompBeam beam, Somp
 }
 void render_distr_forces(const SompBoundary beam_bound, const SompBeam beam, const SompDistrForces * distr_forces)
 {
-    // loop backwards to prevent flickering when removing
-    for (int i = distr_forces->count-1; i >= 0; i--)
+    for (int i = 0; i < distr_forces->forces.count; i++)
     {
-        render_distr_force(beam_bound, beam, &distr_forces->items[i], EJSDL_COLOR(COLOR_DEFAULT));
+        render_distr_force(beam_bound, beam, &distr_forces->forces.items[i], distr_forces->handles.items[i], EJSDL_COLOR(COLOR_DEFAULT));
+    };
+}
+// Centre of the beam at a distance, moments are drawn around it
+SDL_FPoint beam_centre(const SompBoundary beam_bound, const SompBeam beam, float distance)
+{
+    // Same assumptions as point_force_arrow
+    return (SDL_FPoint){
+        lerp(beam_bound.x, beam_bound.x+beam_bound.w, invlerp(0, beam.length, distance)),
+        beam_bound.y + beam_bound.h/2 + 5,
     };
 }
-bool normal(SompBoundary beam_bound, const SompPointForces * point_forces, const SompDistrForces * distr_forces) 
+// Three quarters of a circle around centre with an arrow head showing the
+// direction, clockwise on screen for a positive moment
+void render_moment_arc(SDL_FPoint centre, float radius, float moment)
+{
+    // TODO: magic numbers
+    const int segments = 24;
+    const float head = radius/3;
+    const float start = -0.75*SDL_PI_F, sweep = 1.5*SDL_PI_F;
+
+    SDL_FPoint points[24+1];
+    for (int i = 0; i <= segments; i++)
+    {
+        float angle = start + sweep*i/segments;
+        points[i] = (SDL_FPoint){ centre.x + radius*cosf(angle), centre.y + radius*sinf(angle) };
+    }
+    SDL_RenderLines(somp_state->renderer, points, segments+1);
+
+    // The head sits on the end the moment turns towards
+    float angle = (moment >= 0) ? start + sweep : start;
+    SDL_FPoint tip = points[(moment >= 0) ? segments : 0];
+    float dx = -sinf(angle), dy = cosf(angle);
+    if (moment < 0) { dx = -dx; dy = -dy; }
+    SDL_RenderLine(somp_state->renderer, tip.x, tip.y, tip.x - head*(dx + dy), tip.y - head*(dy - dx));
+    SDL_RenderLine(somp_state->renderer, tip.x, tip.y, tip.x - head*(dx - dy), tip.y - head*(dy + dx));
+}
+void render_point_moment(SompBoundary beam_bound, SompBeam beam, const SompPointMoment * pm, SDL_Color color)
+{
+    // TODO: magic numbers
+    const float radius = 20;
+    char text_buf[32];
+    SDL_FPoint centre = beam_centre(beam_bound, beam, pm->distance);
+
+    SDL_SetRenderDrawColor(somp_state->renderer, color.r, color.g, color.b, color.a);
+    render_moment_arc(centre, radius, pm->moment);
+
+    TTF_SetFontSize(somp_state->font, 14);
+    snprintf(text_buf, sizeof(text_buf), "%.1fNm", pm->moment);
+    SDL_Texture * moment_texture = text(somp_state->renderer, text_buf, centre.x, centre.y - radius,
+            EJSDL_COLOR(COLOR_BLACK), BOT_CENTRE);
+    float moment_h = (moment_texture != NULL) ? moment_texture->h : 0;
+    snprintf(text_buf, sizeof(text_buf), "%.3fm", pm->distance);
+    text(somp_state->renderer, text_buf, centre.x, centre.y - radius - moment_h, EJSDL_COLOR(COLOR_BLACK), BOT_CENTRE);
+}
+void render_point_moments(const SompBoundary beam_bound, const SompBeam beam, const SompPointMoments * point_moments)
+{
+    for (int i = 0; i < point_moments->count; i++)
+    {
+        render_point_moment(beam_bound, beam, &point_moments->items[i], EJSDL_COLOR(COLOR_DEFAULT));
+    }
+}
+// A row of small arcs under the beam, one every few pixels, with the value
+// at both ends
+void render_distr_moments(const SompBoundary beam_bound, const SompBeam beam, const SompDistrMoments * distr_moments)
+{
+    // TODO: magic numbers
+    const int step = 32;
+    const float radius = 6;
+    const float below = 30;
+    char text_buf[32];
+
+    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_DEFAULT);
+    TTF_SetFontSize(somp_state->font, 14);
+    for (int i = 0; i < distr_moments->count; i++)
+    {
+        const SompDistrMoment * dm = &distr_moments->items[i];
+        SDL_FPoint start = beam_centre(beam_bound, beam, dm->start);
+        SDL_FPoint end = beam_centre(beam_bound, beam, dm->end);
+        start.y += below;
+        end.y += below;
+
+        SDL_RenderLine(somp_state->renderer, start.x, start.y - radius, start.x, start.y + radius);
+        SDL_RenderLine(somp_state->renderer, end.x, end.y - radius, end.x, end.y + radius);
+        for (float x = start.x + step/2; x < end.x; x += step)
+        {
+            float dist = mapf(x, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+            render_moment_arc((SDL_FPoint){ x, start.y }, radius, evalPolynomial(dist, dm->polynomial));
+        }
+
+        snprintf(text_buf, sizeof(text_buf), "%.1fNm/m", evalPolynomial(dm->start, dm->polynomial));
+        text(somp_state->renderer, text_buf, start.x, start.y + radius, EJSDL_COLOR(COLOR_BLACK), TOP_LEFT);
+        snprintf(text_buf, sizeof(text_buf), "%.1fNm/m", evalPolynomial(dm->end, dm->polynomial));
+        text(somp_state->renderer, text_buf, end.x, end.y + radius, EJSDL_COLOR(COLOR_BLACK), TOP_RIGHT);
+    }
+}
+// Removes the point moment closest to x when it is within reach
+// Returns: false when there is none close enough
+bool remove_point_moment_near(const SompBoundary beam_bound, const SompBeam beam, SompPointMoments * point_moments, float x)
+{
+    // TODO: magic number
+    const float reach = 20;
+
+    int found = -1;
+    float found_dist = reach;
+    for (int i = 0; i < point_moments->count; i++)
+    {
+        float dist = fabsf(beam_centre(beam_bound, beam, point_moments->items[i].distance).x - x);
+        if (dist <= found_dist)
+        {
+            found = i;
+            found_dist = dist;
+        }
+    }
+    if (found < 0) return false;
+
+    memmove(&point_moments->items[found], &point_moments->items[found+1], (point_moments->count-1-found)*sizeof(SompPointMoment));
+    point_moments->count--;
+    somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Point moment removed\n");
+    return true;
+}
+// Removes the last distributed moment that spans x
+// Returns: false when none does
+bool remove_distr_moment_at(const SompBoundary beam_bound, const SompBeam beam, SompDistrMoments * distr_moments, float x)
 {
-    (void)beam_bound;
-    (void)point_forces;
-    (void)distr_forces;
+    const float dist = mapf(x, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+    for (int i = distr_moments->count-1; i >= 0; i--)
+    {
+        if (dist < distr_moments->items[i].start || dist > distr_moments->items[i].end) continue;
+
+        memmove(&distr_moments->items[i], &distr_moments->items[i+1], (distr_moments->count-1-i)*sizeof(SompDistrMoment));
+        distr_moments->count--;
+        somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Distributed moment removed\n");
+        return true;
+    }
+    return false;
+}
+HitRect hit_rect(SompBoundary bound)
+{
+    return (HitRect){ bound.x, bound.y, bound.w, bound.h };
+}
+// Rebuilds the hit index when the forces or the beam boundary changed since
+// the last build
+// Returns: true when the index was rebuilt
+bool update_hit_index(const SompBoundary beam_bound, const SompBeam beam,
+        const SompPointForces * point_forces, const SompDistrForces * distr_forces)
+{
+    HitIndex * index = &somp_state->solve.hit_index;
+    if (!hit_index_stale(index, point_forces, distr_forces, beam.length, hit_rect(beam_bound))) return false;
+
+    // TODO: magic number
+    const int hl_distance = 4;
+
+    hit_index_begin(index, point_forces, distr_forces, beam.length, hit_rect(beam_bound));
+    for (int i = 0; i < point_forces->forces.count; i++)
+    {
+        int arrow_x, arrow_ys, arrow_ye;
+        point_force_arrow(&arrow_x, &arrow_ys, &arrow_ye, beam_bound, beam, &point_forces->forces.items[i]);
+        HitRect r = {
+            arrow_x - hl_distance,
+            minf(arrow_ys, arrow_ye),
+            hl_distance*2,
+            abs(arrow_ye - arrow_ys)
+        };
+        hit_index_add(index, r, HIT_POINT_FORCE, point_forces->handles.items[i]);
+    }
+    for (int i = 0; i < distr_forces->forces.count; i++)
+    {
+        const SompDistrForce * df = &distr_forces->forces.items[i];
+        ForceHandle handle = distr_forces->handles.items[i];
+        hit_index_add(index, hit_rect(distr_side_hover_rect(beam_bound, beam, df, df->start)), HIT_DISTR_START, handle);
+        hit_index_add(index, hit_rect(distr_side_hover_rect(beam_bound, beam, df, df->end)), HIT_DISTR_END, handle);
+    }
+    hit_index_build(index);
+
+    return true;
+}
+bool normal(SompBoundary beam_bound, const SompBeam beam)
+{
+    somp_section_solve_t * const S = &somp_state->solve;
+    if (!gui.mouse_pressed || gui.mouse_state != SDL_BUTTON_LEFT) return true;
+
+    switch (S->hovered.kind) {
+    case HIT_POINT_FORCE:
+        S->mode = MOD_POINT_FORCE;
+        S->mod_point_force = S->hovered.handle;
+        break;
+    case HIT_DISTR_START:
+    case HIT_DISTR_END:
+        mod_distr_force_enter(beam_bound, beam, S->hovered.handle);
+        break;
+    case HIT_NONE: break;
+    }
 
     return true;
 }
@@ -535,15 +1063,81 @@ bool add_point_force(SompBoundary beam_bound, const SompBeam beam, SompPointForc
     new_force.distance = lerp(0, beam.length, invlerp(beam_bound.x, beam_bound.x+beam_bound.w, new_force_x));
 
 
-    render_point_force(beam_bound, beam, &new_force, EJSDL_COLOR(COLOR_PREVIEW));
+    render_point_force(beam_bound, beam, &new_force, NO_FORCE_HANDLE, EJSDL_COLOR(COLOR_PREVIEW));
 
     if (gui.mouse_pressed && gui.mouse_state == SDL_BUTTON_LEFT)
     {
         somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Point force added\n");
-        DynamicArrayAppend(point_forces, new_force);
+        sorted_pf_insert(point_forces, new_force);
+    };
+
+
+    return true;
+}
+// The moment is set the same way as a point force, by the height of the
+// mouse: above the beam is clockwise
+bool add_point_moment(SompBoundary beam_bound, const SompBeam beam, SompPointMoments * point_moments)
+{
+    float new_moment_x = MIN(beam_bound.x+beam_bound.w, MAX(beam_bound.x, gui.mouse_x));
+    SompPointMoment new_moment = {
+        .distance = lerp(0, beam.length, invlerp(beam_bound.x, beam_bound.x+beam_bound.w, new_moment_x)),
+        .moment   = px_to_force(gui.mouse_y, beam_bound),
+    };
+
+    render_point_moment(beam_bound, beam, &new_moment, EJSDL_COLOR(COLOR_PREVIEW));
+
+    if (gui.mouse_pressed && gui.mouse_state == SDL_BUTTON_LEFT)
+    {
+        if (DynamicArrayTryAppend(point_moments, new_moment)) somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Point moment added\n");
+        else SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not add the point moment\n");
     };
 
+    return true;
+}
+// Placed like a distributed force: press at the start, release at the end,
+// the height of the mouse at both gives the linear moment per metre
+bool add_distr_moment(SompBoundary beam_bound, SompBeam beam, SompDistrMoments * distr_moments)
+{
+    somp_section_solve_t * S = &somp_state->solve;
+    float * xs = &S->temp_floats[0];
+    float * ys = &S->temp_floats[1];
+
+    const float x = MIN(beam_bound.x+beam_bound.w, MAX(beam_bound.x, gui.mouse_x));
+    if (!S->distributed_first_placed)
+    {
+        *xs = x;
+        *ys = gui.mouse_y;
+        if (gui.mouse_pressed && gui.mouse_state == SDL_BUTTON_LEFT) S->distributed_first_placed = true;
+        return true;
+    }
 
+    float fxs = mapf(*xs, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+    float fxe = mapf(x, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+    float fys = px_to_force(*ys, beam_bound);
+    float fye = px_to_force(gui.mouse_y, beam_bound);
+    if (fxs > fxe)
+    {
+        swap(fxs, fxe, float);
+        swap(fys, fye, float);
+    }
+
+    SompDistrMoment dm = { .start = fxs, .end = fxe };
+    float m, c;
+    line_from_points(&m, &c, fxs, fys, fxe, fye);
+    dm.polynomial[0] = c;
+    dm.polynomial[1] = m;
+
+    SompDistrMoments preview = { &dm, 1, 1 };
+    render_distr_moments(beam_bound, beam, &preview);
+
+    if (gui.mouse_released)
+    {
+        S->distributed_first_placed = false;
+        S->mode = NORMAL;
+        if (fxe <= fxs) return true;
+        if (DynamicArrayTryAppend(distr_moments, dm)) somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Distributed moment added\n");
+        else SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not add the distributed moment\n");
+    }
     return true;
 }
 bool add_distr_force(SompBoundary beam_bound, SompBeam beam, SompDistrForces * distr_forces)
@@ -605,7 +1199,7 @@ bool add_distr_force(SompBoundary beam_bound, SompBeam beam, SompDistrForces * d
             df.polynomial[0] = c;
             df.polynomial[1] = m;
 
-            DynamicArrayAppend(distr_forces, df);
+            sorted_df_insert(distr_forces, df);
             S->distributed_first_placed = false;
             S->mode = NORMAL;
 
@@ -617,13 +1211,18 @@ bool add_distr_force(SompBoundary beam_bound, SompBeam beam, SompDistrForces * d
     render_phony_distr_force(beam_bound, *xs, *ys, *xe, *ye, EJSDL_COLOR(COLOR_PREVIEW));
     return true;
 }
-bool mod_point_force(SompBoundary beam_bound, SompBeam beam, SompPointForce * new_force)
+bool mod_point_force(SompBoundary beam_bound, SompBeam beam, ForceHandle handle)
 {
+    somp_section_solve_t * const S = &somp_state->solve;
+    SompPointForce new_force = {0};
     float new_force_x = MIN(beam_bound.x+beam_bound.w, MAX(beam_bound.x, gui.mouse_x));
     float new_force_y = gui.mouse_y;
 
-    new_force->force    = px_to_force(new_force_y, beam_bound);
-    new_force->distance = mapf(new_force_x, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+    new_force.force    = px_to_force(new_force_y, beam_bound);
+    new_force.distance = mapf(new_force_x, beam_bound.x, beam_bound.x+beam_bound.w, 0, beam.length);
+
+    // The force got removed while we were dragging it
+    if (!sorted_pf_modify(&S->point_forces, handle, new_force)) S->mode = NORMAL;
 
     if (gui.mouse_released)
     {
@@ -635,9 +1234,11 @@ bool mod_point_force(SompBoundary beam_bound, SompBeam beam, SompPointForce * ne
 // This function sets things up for mod_distr_force since there is the trouble
 // of the start and the end, we need to calculate whether we are modding the
 // start or the end
-void mod_distr_force_enter(const SompBoundary beam_bound, const SompBeam beam, SompDistrForce * distr_force)
+void mod_distr_force_enter(const SompBoundary beam_bound, const SompBeam beam, ForceHandle handle)
 {
     somp_section_solve_t * const S = &somp_state->solve;
+    const SompDistrForce * distr_force = sorted_df_get(&S->distr_forces, handle);
+    if (distr_force == NULL) return;
     float xs, xe;
     float * x_select, * y_select;
 
@@ -662,11 +1263,18 @@ void mod_distr_force_enter(const SompBoundary beam_bound, const SompBeam beam, S
 
 
     S->mode = MOD_DISTR_FORCE;
-    S->mod_distr_force = distr_force;
+    S->mod_distr_force = handle;
 };
-bool mod_distr_force(const SompBoundary beam_bound, const SompBeam beam, SompDistrForce * distr_force)
+bool mod_distr_force(const SompBoundary beam_bound, const SompBeam beam, ForceHandle handle)
 {
     somp_section_solve_t * const S = &somp_state->solve;
+    const SompDistrForce * old_force = sorted_df_get(&S->distr_forces, handle);
+    if (old_force == NULL)
+    {
+        S->mode = NORMAL;
+        return true;
+    }
+    SompDistrForce distr_force = *old_force;
     float * xs, * ys;
     float * xe, * ye;
 
@@ -696,10 +1304,11 @@ bool mod_distr_force(const SompBoundary beam_bound, const SompBeam beam, SompDis
     float m, c;
     line_from_points(&m, &c, fxs, fys, fxe, fye);
 
-    distr_force->start = fxs;
-    distr_force->end   = fxe;
-    distr_force->polynomial[0] = c;
-    distr_force->polynomial[1] = m;
+    distr_force.start = fxs;
+    distr_force.end   = fxe;
+    distr_force.polynomial[0] = c;
+    distr_force.polynomial[1] = m;
+    sorted_df_modify(&S->distr_forces, handle, distr_force);
 
     if (gui.mouse_released)
     {
@@ -709,28 +1318,57 @@ bool mod_distr_force(const SompBoundary beam_bound, const SompBeam beam, SompDis
     return true;
 }
 
-bool somp_section_solve(SompBoundary boundary)
+SompBoundary get_beam_boundary(SompBoundary boundary)
+{
+    return (SompBoundary){
+        boundary.x + 0.1*boundary.w,
+        boundary.y + 0.1*boundary.h,
+        0.8*boundary.w,
+        0.8*boundary.h
+    };
+}
+// Draws the beam and its forces without handling any input, also used by
+// the headless renderer
+void render_solve_scene(SompBoundary boundary)
 {
     somp_section_solve_t * state = &somp_state->solve;
+    SompBoundary beam_boundary = get_beam_boundary(boundary);
 
     SDL_Color background_color = EJSDL_COLOR(COLOR_HIBB_BEAM);
     clear_background(boundary, background_color);
 
-    SompBoundary beam_boundary = { 0.1*gui.windoww, 0.1*gui.windowh, 0.8*gui.windoww, 0.8*gui.windowh };
+    render_beam(beam_boundary, &state->beam);
+    render_point_forces(beam_boundary, state->beam, &state->point_forces);
+    render_distr_forces(beam_boundary, state->beam, &state->distr_forces);
+    render_point_moments(beam_boundary, state->beam, &state->point_moments);
+    render_distr_moments(beam_boundary, state->beam, &state->distr_moments);
+}
+bool somp_section_solve(SompBoundary boundary)
+{
+    somp_section_solve_t * state = &somp_state->solve;
+
+    SompBoundary beam_boundary = get_beam_boundary(boundary);
     SompBeam * beam = &state->beam;
     SompPointForces * point_forces = &state->point_forces;
     SompDistrForces * distr_forces = &state->distr_forces;
 
-    render_beam(beam_boundary);
-    render_point_forces(beam_boundary, *beam, point_forces);
-    render_distr_forces(beam_boundary, *beam, distr_forces);
+    // Only look up the hovered force when the mouse did something or the
+    // forces moved under it
+    if (update_hit_index(beam_boundary, *beam, point_forces, distr_forces) || gui.mouse_moved)
+    {
+        state->hovered = hit_index_query(&state->hit_index, gui.mouse_x, gui.mouse_y);
+    }
+
+    render_solve_scene(boundary);
 
     switch (state->mode) {
-    case NORMAL:                  normal(beam_boundary, point_forces, distr_forces); break;
+    case NORMAL:                  normal(beam_boundary, *beam); break;
     case ADD_POINT_FORCE:         add_point_force(beam_boundary, *beam, point_forces); break;
     case ADD_DISTRIB_FORCE:       add_distr_force(beam_boundary, *beam, distr_forces); break;
     case MOD_POINT_FORCE:         mod_point_force(beam_boundary, *beam, state->mod_point_force); break;
     case MOD_DISTR_FORCE:         mod_distr_force(beam_boundary, *beam, state->mod_distr_force); break;
+    case ADD_POINT_MOMENT:        add_point_moment(beam_boundary, *beam, &state->point_moments); break;
+    case ADD_DISTRIB_MOMENT:      add_distr_moment(beam_boundary, *beam, &state->distr_moments); break;
     default: {
         somp_loginfo(SDL_LOG_CATEGORY_APPLICATION, "Unknown mode, switching to NORMAL\n");
         state->mode = NORMAL;
@@ -741,8 +1379,59 @@ bool somp_section_solve(SompBoundary boundary)
     return true;
 }
 // ======================================================================
-bool somp_section_2(SompBoundary boundary) { (void)boundary; return true; }
-bool somp_section_3(SompBoundary boundary) { (void)boundary; return true;}
+// ====================== DIAGRAM SECTIONS ==============================
+// Plots one of the solved section lists (shear or moment) of the beam, one
+// sample per pixel column scaled so the largest value fills the panel
+void render_diagram(SompBoundary bound, const SompBeam * beam, const Section sections[], const char * label)
+{
+    // TODO: magic numbers
+    const float margin = 0.1;
+    if (bound.w < 1 || bound.h < 1 || beam->sections_count <= 0 || beam->length <= 0) return;
+
+    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_HIBB_BACKGROUND);
+    SDL_RenderFillRect(somp_state->renderer, &bound);
+
+    SompBoundary plot = get_beam_boundary(bound);
+    const int columns = plot.w;
+    float * values = malloc((columns+1) * sizeof(float));
+    if (values == NULL) return;
+
+    pw_sample(sections, beam->sections_count, 0, beam->length, values, columns+1);
+    float max_value = 0;
+    for (int i = 0; i <= columns; i++) max_value = maxf(max_value, fabsf(values[i]));
+
+    const float axis_y = plot.y + plot.h/2;
+    const float scale = (max_value > 0) ? (plot.h/2) * (1 - margin) / max_value : 0;
+
+    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_GRAY);
+    SDL_RenderLine(somp_state->renderer, plot.x, axis_y, plot.x + plot.w, axis_y);
+
+    SDL_SetRenderDrawColor(somp_state->renderer, COLOR_BLACK);
+    for (int i = 1; i <= columns; i++)
+    {
+        SDL_RenderLine(somp_state->renderer,
+                plot.x + i-1, axis_y - values[i-1]*scale,
+                plot.x + i,   axis_y - values[i]*scale);
+    }
+    free(values);
+
+    char text_buf[64];
+    TTF_SetFontSize(somp_state->font, 14);
+    snprintf(text_buf, sizeof(text_buf), "%s (max |%.2f|)", label, max_value);
+    text(somp_state->renderer, text_buf, bound.x + 4, bound.y + 4, EJSDL_COLOR(COLOR_BLACK), TOP_LEFT);
+}
+bool somp_section_2(SompBoundary boundary)
+{
+    const SompBeam * beam = &somp_state->solve.beam;
+    render_diagram(boundary, beam, beam->shears, "Shear");
+    return true;
+}
+bool somp_section_3(SompBoundary boundary)
+{
+    const SompBeam * beam = &somp_state->solve.beam;
+    render_diagram(boundary, beam, beam->moments, "Moment");
+    return true;
+}
 
 void gui_init(SompGui * const gui)
 {
@@ -751,30 +1440,44 @@ void gui_init(SompGui * const gui)
 
 
 }
+// Everything is taken from the event itself (not the live mouse or window)
+// so recorded events replay the same without a window
 void gui_update(SDL_Event e, SompGui * const gui)
 {
     switch(e.type)
     {
-    case SDL_EVENT_WINDOW_SHOWN:
-    case SDL_EVENT_WINDOW_RESIZED: {
-        int w,h;
+    case SDL_EVENT_WINDOW_SHOWN: {
+        int w = gui->windoww, h = gui->windowh;
         SDL_GetWindowSize(somp_state->window, &w, &h);
         gui->windoww = w;
         gui->windowh = h;
         break;
     }
+    case SDL_EVENT_WINDOW_RESIZED:
+        gui->windoww = e.window.data1;
+        gui->windowh = e.window.data2;
+        break;
     case SDL_EVENT_MOUSE_BUTTON_UP:
-        gui->mouse_state = SDL_GetMouseState(&gui->mouse_x, &gui->mouse_y);
+        gui->mouse_x = e.button.x;
+        gui->mouse_y = e.button.y;
+        gui->mouse_state &= ~SDL_BUTTON_MASK(e.button.button);
         gui->mouse_released = true;
         gui->mouse_down = false;
+        gui->mouse_moved = true;
         break;
     case SDL_EVENT_MOUSE_BUTTON_DOWN:
-        gui->mouse_state = SDL_GetMouseState(&gui->mouse_x, &gui->mouse_y);
+        gui->mouse_x = e.button.x;
+        gui->mouse_y = e.button.y;
+        gui->mouse_state |= SDL_BUTTON_MASK(e.button.button);
         gui->mouse_pressed = true;
         gui->mouse_down = true;
+        gui->mouse_moved = true;
         break;
     case SDL_EVENT_MOUSE_MOTION:
-        gui->mouse_state = SDL_GetMouseState(&gui->mouse_x, &gui->mouse_y);
+        gui->mouse_x = e.motion.x;
+        gui->mouse_y = e.motion.y;
+        gui->mouse_state = e.motion.state;
+        gui->mouse_moved = true;
         break;
     };
 };
@@ -783,24 +1486,45 @@ void gui_reset(SompGui * const gui)
 {
     gui->mouse_pressed = false;
     gui->mouse_released = false;
+    gui->mouse_moved = false;
     gui->_should_update_keyboard = true;
 
-    if (gui->temp_surface != NULL) SDL_DestroySurface(gui->temp_surface);
-    if (gui->temp_texture != NULL) SDL_DestroyTexture(gui->temp_texture);
-    gui->temp_surface = NULL;
-    gui->temp_texture = NULL;
+    for (int i = 0; i < gui->temp_textures.count; i++) SDL_DestroyTexture(gui->temp_textures.items[i]);
+    DynamicArrayClear(&gui->temp_textures);
 }
 
+// Solves the beam with everything that is on it
+// Returns: false when there are too many sections or the supports do not
+//          hold the beam
+bool solve_state_beam(somp_section_solve_t * S)
+{
+    // Forces are kept sorted so the solver skips straight past sorting. The
+    // gui only shows bending, it has no axial forces or torques
+    BeamLoads loads = {
+        .pointForces = S->point_forces.forces.items, .pfCount = S->point_forces.forces.count,
+        .distributedForces = S->distr_forces.forces.items, .dfCount = S->distr_forces.forces.count,
+        .pointMoments = S->point_moments.items, .pmCount = S->point_moments.count,
+        .distributedMoments = S->distr_moments.items, .dmCount = S->distr_moments.count,
+    };
+    SolverContext ctx;
+    initSolverContext(&ctx);
+    bool solved = solveBeamLoads(&ctx, &S->beam, &loads);
+    freeSolverContext(&ctx);
+    return solved;
+}
 void keyboard_shortcuts(SDL_Event e)
 {
     somp_section_solve_t * S = &somp_state->solve;
+    SompBoundary beam_boundary = get_beam_boundary((SompBoundary){ 0, 0, gui.windoww, gui.windowh });
     switch(e.key.key)
     {
     case SDLK_ESCAPE: S->mode = NORMAL; break;
     case SDLK_S: {
-        solveBeam(&S->beam,
-                S->point_forces.items, S->point_forces.count,
-                S->distr_forces.items, S->distr_forces.count);
+        if (!solve_state_beam(S))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not solve: too many sections or the supports do not hold the beam\n");
+            break;
+        }
         printf("Beam: {\n");
         printf("\t.length = %f\n", S->beam.length);
         printf("\t.sections_count = %d\n", S->beam.sections_count);
@@ -812,6 +1536,16 @@ void keyboard_shortcuts(SDL_Event e)
         printStructArray(S->beam.moments, S->beam.sections_count, sizeof(Section), printSection);
         printf("}\n");
     }; break;
+    case SDLK_1:
+    case SDLK_2: {
+        // Cycle the support at x = 0 (1) or at the end (2)
+        BeamSupports supports = effectiveSupports(S->beam.supports);
+        SupportKind * kind = (e.key.key == SDLK_1) ? &supports.left : &supports.right;
+        *kind = (*kind + 1 < SUPPORT_KINDS_COUNT) ? *kind + 1 : SUPPORT_FREE;
+        S->beam.supports = supports;
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Supports: %s, %s\n",
+                supportName(supports.left), supportName(supports.right));
+    }; break;
     case SDLK_F: {
         S->mode = (S->mode == ADD_POINT_FORCE) ? NORMAL : ADD_POINT_FORCE;
     }; break;
@@ -819,33 +1553,99 @@ void keyboard_shortcuts(SDL_Event e)
         S->mode = (S->mode == ADD_DISTRIB_FORCE) ? NORMAL : ADD_DISTRIB_FORCE;
         S->distributed_first_placed = false;
     }; break;
+    case SDLK_M: {
+        S->mode = (S->mode == ADD_POINT_MOMENT) ? NORMAL : ADD_POINT_MOMENT;
+    }; break;
+    case SDLK_N: {
+        S->mode = (S->mode == ADD_DISTRIB_MOMENT) ? NORMAL : ADD_DISTRIB_MOMENT;
+        S->distributed_first_placed = false;
+    }; break;
     case SDLK_R: {
-        S->point_forces.count = 0;
-        S->distr_forces.count = 0;
+        sorted_pf_clear(&S->point_forces);
+        sorted_df_clear(&S->distr_forces);
+        DynamicArrayClear(&S->point_moments);
+        DynamicArrayClear(&S->distr_moments);
+        S->hovered = (HitItem){ .kind = HIT_NONE, .handle = NO_FORCE_HANDLE };
+        S->mode = NORMAL;
+    }; break;
+    case SDLK_X: {
+        // Delete whatever is under the mouse, once per key press
+        if (S->mode != NORMAL) break;
+        if (S->hovered.kind == HIT_POINT_FORCE) remove_point_force(&S->point_forces, S->hovered.handle);
+        else if (S->hovered.kind != HIT_NONE) remove_distr_force(&S->distr_forces, S->hovered.handle);
+        // Moments are not in the hit index, there are only ever a few
+        else if (!remove_point_moment_near(beam_boundary, S->beam, &S->point_moments, gui.mouse_x))
+            remove_distr_moment_at(beam_boundary, S->beam, &S->distr_moments, gui.mouse_x);
+        S->hovered = (HitItem){ .kind = HIT_NONE, .handle = NO_FORCE_HANDLE };
     }; break;
     }
 };
 
-// Main function that controls logic of application
-// Returns: true to continue looping
-//          false to exit application
-bool somp_main()
+// Appends the event to the recording started by SOMP_RECORD=<file>, a failed
+// write stops the recording
+void record_event(SDL_Event e)
 {
-    SDL_Event sdl_event;
-    while (SDL_PollEvent(&sdl_event))
+    if (gui.record_file == NULL) return;
+
+    SompRecordedEvent record = { .frame = gui.frame, .event = e };
+    if (fwrite(&record, sizeof(record), 1, gui.record_file) != 1)
     {
-        gui_update(sdl_event, &gui);
-        switch(sdl_event.type)
-        {
-        case SDL_EVENT_QUIT: return false;
-        case SDL_EVENT_KEY_DOWN:
-                             gui._should_update_keyboard = true;
-                             keyboard_shortcuts(sdl_event);
-                             break;
-        }
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not write event recording, stopping it\n");
+        fclose(gui.record_file);
+        gui.record_file = NULL;
     }
-    if (gui._should_update_keyboard) gui.keyboard = SDL_GetKeyboardState(NULL);
+}
+void start_recording()
+{
+    if (gui.record_checked) return;
+    gui.record_checked = true;
+
+    const char * path = getenv("SOMP_RECORD");
+    if (path == NULL) return;
+
+    // A reloaded module starts with a fresh gui, keep adding to the
+    // recording this process started instead of truncating it
+    if (getenv("SOMP_RECORD_STARTED") != NULL)
+    {
+        gui.record_file = fopen(path, "ab");
+        if (gui.record_file == NULL) SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not continue event recording\n");
+        return;
+    }
+
+    gui.record_file = fopen(path, "wb");
+    if (gui.record_file == NULL || fwrite(SOMP_RECORD_MAGIC, 8, 1, gui.record_file) != 1)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Could not start event recording\n");
+        if (gui.record_file != NULL) fclose(gui.record_file);
+        gui.record_file = NULL;
+        return;
+    }
+    setenv("SOMP_RECORD_STARTED", "1", 1);
+
+    // The window size is not an event yet, record it so a replay starts
+    // with the same layout
+    SDL_Event resized = { .window = { .type = SDL_EVENT_WINDOW_RESIZED, .data1 = gui.windoww, .data2 = gui.windowh } };
+    record_event(resized);
+}
+
+// Returns: false when the application should exit
+bool somp_handle_event(SDL_Event e)
+{
+    gui_update(e, &gui);
+    switch(e.type)
+    {
+    case SDL_EVENT_QUIT: return false;
+    case SDL_EVENT_KEY_DOWN:
+                         gui._should_update_keyboard = true;
+                         keyboard_shortcuts(e);
+                         break;
+    }
+    return true;
+}
 
+// Draws one frame from the events handled so far, no waiting
+bool somp_frame()
+{
     SompBoundary boundary_solve = { 0, 0, gui.windoww, gui.windowh };
     SompBoundary boundary_2 = { 0, 0, 0, 0 };
     SompBoundary boundary_3 = { 0, 0, 0, 0 };
@@ -856,6 +1656,34 @@ bool somp_main()
     if (!somp_section_3(boundary_3)) return false;
 
     gui_reset(&gui);
+    gui.frame++;
+
+    return true;
+}
+
+// Main function that controls logic of application
+// Returns: true to continue looping
+//          false to exit application
+bool somp_main()
+{
+    start_recording();
+
+    SDL_Event sdl_event;
+    while (SDL_PollEvent(&sdl_event))
+    {
+        record_event(sdl_event);
+        if (!somp_handle_event(sdl_event))
+        {
+            if (gui.record_file != NULL) fclose(gui.record_file);
+            gui.record_file = NULL;
+            return false;
+        }
+    }
+    // Nothing stays buffered, a reload opens the recording again
+    if (gui.record_file != NULL) fflush(gui.record_file);
+    if (gui._should_update_keyboard) gui.keyboard = SDL_GetKeyboardState(NULL);
+
+    if (!somp_frame()) return false;
 
     SDL_Delay(32);
     return true;
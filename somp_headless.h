@@ -0,0 +1,66 @@
+#ifndef SOMP_HEADLESS_H
+#define SOMP_HEADLESS_H
+
+/*
+* Filename:	somp_headless.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Sets up the gui without a window: the software renderer draws straight into
+* a surface, so no display server is needed. Include after somp_gui.c
+*/
+
+typedef struct {
+    SDL_Surface * surface;
+    SDL_Renderer * renderer;
+    TTF_Font * font;
+} HeadlessRenderer;
+
+bool headless_init(HeadlessRenderer * hr, int width, int height, const char * font_file);
+void headless_free(HeadlessRenderer * hr);
+
+bool headless_init(HeadlessRenderer * hr, int width, int height, const char * font_file)
+{
+    *hr = (HeadlessRenderer){0};
+    if (!SDL_Init(0) || !TTF_Init()) return false;
+
+    hr->surface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_XRGB8888);
+    if (hr->surface == NULL) return false;
+    hr->renderer = SDL_CreateSoftwareRenderer(hr->surface);
+    if (hr->renderer == NULL) return false;
+    // Every label goes through the font, without it there is nothing to draw
+    hr->font = TTF_OpenFont(font_file, 48);
+    if (hr->font == NULL) return false;
+
+    somp_state = new_state(NULL, hr->renderer, hr->font);
+    if (somp_state == NULL) return false;
+    gui.windoww = width;
+    gui.windowh = height;
+    return true;
+}
+
+void headless_free(HeadlessRenderer * hr)
+{
+    if (somp_state != NULL)
+    {
+        sorted_pf_free(&somp_state->solve.point_forces);
+        sorted_df_free(&somp_state->solve.distr_forces);
+        free(somp_state->solve.point_moments.items);
+        free(somp_state->solve.distr_moments.items);
+        hit_index_free(&somp_state->solve.hit_index);
+        free(somp_state);
+        somp_state = NULL;
+    }
+    gui_reset(&gui);
+    free(gui.temp_textures.items);
+    gui.temp_textures.items = NULL;
+    gui.temp_textures.capacity = 0;
+
+    if (hr->font != NULL) TTF_CloseFont(hr->font);
+    if (hr->renderer != NULL) SDL_DestroyRenderer(hr->renderer);
+    if (hr->surface != NULL) SDL_DestroySurface(hr->surface);
+    TTF_Quit();
+    SDL_Quit();
+}
+
+#endif // SOMP_HEADLESS_H
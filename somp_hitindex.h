@@ -0,0 +1,159 @@
+#ifndef SOMP_HITINDEX_H
+#define SOMP_HITINDEX_H
+
+/*
+* Filename:	somp_hitindex.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* 1-D index over the screen x extents of the force handles so hover, pick and
+* delete do not have to test every force. Built from the sorted force
+* containers and only rebuilt when they or the viewport change
+*/
+
+#include <stdbool.h>
+#include "somp_forces.h"
+
+typedef enum {
+	HIT_NONE = 0,
+	HIT_POINT_FORCE,
+	HIT_DISTR_START,
+	HIT_DISTR_END,
+} HitKind;
+
+typedef struct {
+	float x, y, w, h;
+} HitRect;
+
+typedef struct {
+	HitRect rect;
+	HitKind kind;
+	ForceHandle handle;
+} HitItem;
+
+typedef struct {
+	HitItem * items; // sorted by rect.x after hit_index_build
+	int count;
+	int capacity;
+	float max_width;
+
+	// What the index was built from, see hit_index_stale
+	bool built;
+	int pf_version;
+	int df_version;
+	float beam_length;
+	HitRect viewport;
+} HitIndex;
+
+bool hit_index_stale(const HitIndex * index, const SortedPointForces * pfs, const SortedDistrForces * dfs,
+		float beam_length, HitRect viewport);
+void hit_index_begin(HitIndex * index, const SortedPointForces * pfs, const SortedDistrForces * dfs,
+		float beam_length, HitRect viewport);
+bool hit_index_add(HitIndex * index, HitRect rect, HitKind kind, ForceHandle handle);
+void hit_index_build(HitIndex * index);
+HitItem hit_index_query(const HitIndex * index, float x, float y);
+void hit_index_free(HitIndex * index);
+
+#ifdef SOMP_HITINDEX_IMPLEMENTATION
+
+#include <stdlib.h>
+
+static bool hit_rect_equal(HitRect a, HitRect b)
+{
+	return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+bool hit_index_stale(const HitIndex * index, const SortedPointForces * pfs, const SortedDistrForces * dfs,
+		float beam_length, HitRect viewport)
+{
+	return !index->built
+		|| index->pf_version != pfs->version
+		|| index->df_version != dfs->version
+		|| index->beam_length != beam_length
+		|| !hit_rect_equal(index->viewport, viewport);
+}
+
+// Empties the index and remembers what it is about to be built from
+void hit_index_begin(HitIndex * index, const SortedPointForces * pfs, const SortedDistrForces * dfs,
+		float beam_length, HitRect viewport)
+{
+	index->count = 0;
+	index->max_width = 0;
+	index->built = false;
+	index->pf_version = pfs->version;
+	index->df_version = dfs->version;
+	index->beam_length = beam_length;
+	index->viewport = viewport;
+}
+
+// Returns: false if there was no memory, the force just can not be hovered
+bool hit_index_add(HitIndex * index, HitRect rect, HitKind kind, ForceHandle handle)
+{
+	HitItem item = { rect, kind, handle };
+	if (!DynamicArrayTryAppend(index, item)) return false;
+	index->max_width = maxf(index->max_width, rect.w);
+	return true;
+}
+
+static int comp_hit_items(const void * a, const void * b)
+{
+	const HitItem * A = (const HitItem *) a;
+	const HitItem * B = (const HitItem *) b;
+	if (A->rect.x < B->rect.x) return -1;
+	else if (A->rect.x > B->rect.x) return 1;
+
+	return 0;
+}
+
+void hit_index_build(HitIndex * index)
+{
+	qsort(index->items, index->count, sizeof(HitItem), comp_hit_items);
+	index->built = true;
+}
+
+/*
+ * Find the handle under (x, y). Only items that start within max_width to
+ * the left of x can contain it, so a binary search finds the first candidate
+ * and we scan until the items start right of x
+ *
+ * Return:
+ *  HitItem: the item whose centre is closest to x, kind is HIT_NONE when
+ *      nothing was hit
+ */
+HitItem hit_index_query(const HitIndex * index, float x, float y)
+{
+	HitItem found = { .kind = HIT_NONE, .handle = NO_FORCE_HANDLE };
+	float found_dist = 0;
+
+	float min_x = x - index->max_width;
+	int lo = 0, hi = index->count;
+	while (lo < hi)
+	{
+		int mid = lo + (hi-lo)/2;
+		if (index->items[mid].rect.x < min_x) lo = mid+1;
+		else hi = mid;
+	}
+
+	for (int i = lo; i < index->count && index->items[i].rect.x <= x; i++)
+	{
+		HitRect r = index->items[i].rect;
+		if (x > r.x + r.w || y < r.y || y > r.y + r.h) continue;
+
+		float dist = fabsf(r.x + r.w/2 - x);
+		if (found.kind == HIT_NONE || dist < found_dist)
+		{
+			found = index->items[i];
+			found_dist = dist;
+		}
+	}
+	return found;
+}
+
+void hit_index_free(HitIndex * index)
+{
+	free(index->items);
+	*index = (HitIndex){0};
+}
+
+#endif // SOMP_HITINDEX_IMPLEMENTATION
+#endif // SOMP_HITINDEX_H
@@ -9,7 +9,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/inotify.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
@@ -19,6 +26,18 @@
 #define WINDOW_HEIGHT (WINDOW_WIDTH/ASPECT_RATIO)
 #define WINDOW_TITLE "SOMP"
 
+// Sources are watched in this directory and rebuilt with this command, elnob
+// passes the module and command of the profile the host was built with
+#define WATCH_DIR "."
+#ifndef SOMP_BUILD_COMMAND
+#define SOMP_BUILD_COMMAND "./elnob.out module"
+#endif
+#ifndef SOMP_MODULE_PATH
+#define SOMP_MODULE_PATH "build/debug/somp_gui.so"
+#endif
+// Editors write a file in a few steps, wait this long after the last event
+#define DEBOUNCE_MS 100
+
 typedef void* module_init_t(void * state, SDL_Window * w, SDL_Renderer * r, TTF_TextEngine * t);
 typedef void* module_reload_t(void * state);
 typedef void* module_main_t();
@@ -30,49 +49,234 @@ typedef struct {
     module_main_t * main;
     module_close_t * close;
     void * state;
+    void * handle;
 } SompModule;
 
-static const char * dl_filename = "somp_gui.so";
-static void * dl_handle = NULL;
+// Rebuilds and loads the module on a background thread, the main thread only
+// has to swap in the pending module between frames
+typedef struct {
+    pthread_t thread;
+    bool running;
+    int inotify_fd;
+    int wake_pipe[2]; // 'b' asks for a build, 'q' stops the thread
+
+    pthread_mutex_t lock;
+    bool ready;
+    SompModule pending;
+} Reloader;
 
+static const char * dl_filename = SOMP_MODULE_PATH;
+static int dl_loads = 0;
+
+static bool copy_file(const char * from, const char * to)
+{
+    int in = open(from, O_RDONLY);
+    if (in < 0) return false;
+    int out = open(to, O_WRONLY|O_CREAT|O_TRUNC, 0700);
+    if (out < 0) { close(in); return false; }
 
+    char buffer[1 << 16];
+    ssize_t n;
+    bool ok = true;
+    while ((n = read(in, buffer, sizeof(buffer))) > 0)
+    {
+        if (write(out, buffer, n) != n) { ok = false; break; }
+    }
+    if (n < 0) ok = false;
+
+    close(in);
+    if (close(out) != 0) ok = false;
+    return ok;
+}
+
+void unload_module(SompModule * somp)
+{
+    if (somp->handle != NULL) dlclose(somp->handle);
+    somp->handle = NULL;
+}
+
+// Loads a private copy of the module. dlopen hands back the already loaded
+// library when the path is the same, and the build overwrites the file we
+// would have mapped, so every load gets its own name. The copy is unlinked
+// straight away, the mapping stays valid
 bool load_module(SompModule * somp)
 {
-    if (dl_handle != NULL) dlclose(dl_handle);
+    char path[64];
+    snprintf(path, sizeof(path), "./.somp_gui_%d_%d.so", (int) getpid(), dl_loads++);
+    if (!copy_file(dl_filename, path)) {
+        printf("Loading %s: could not copy to %s\n", dl_filename, path);
+        return false;
+    }
 
-    dl_handle = dlopen(dl_filename, RTLD_NOW);
-    if (!dl_handle) {
+    somp->handle = dlopen(path, RTLD_NOW);
+    unlink(path);
+    if (!somp->handle) {
         printf("Loading %s: %s\n", dl_filename, dlerror());
         return false;
     }
 
-    somp->init = dlsym(dl_handle, "somp_init");
+    somp->init = dlsym(somp->handle, "somp_init");
     if (!somp->init) {
         printf("Loading %s: %s\n", "somp_init", dlerror());
+        unload_module(somp);
         return false;
     }
-    somp->reload = dlsym(dl_handle, "somp_reload");
+    somp->reload = dlsym(somp->handle, "somp_reload");
     if (!somp->reload) {
         printf("Loading %s: %s\n", "somp_reload", dlerror());
+        unload_module(somp);
         return false;
     }
-    somp->main = dlsym(dl_handle, "somp_main");
+    somp->main = dlsym(somp->handle, "somp_main");
     if (!somp->main) {
         printf("Loading %s: %s\n", "somp_main", dlerror());
+        unload_module(somp);
         return false;
     }
-    somp->close = dlsym(dl_handle, "somp_close");
+    somp->close = dlsym(somp->handle, "somp_close");
     if (!somp->close) {
         printf("Loading %s: %s\n", "somp_close", dlerror());
+        unload_module(somp);
         return false;
     }
     return true;
 }
+// ====================== BACKGROUND RELOADER ===========================
+static bool is_source_file(const char * name)
+{
+    size_t len = strlen(name);
+    if (len < 3 || name[0] == '.') return false;
+    return strcmp(name + len - 2, ".c") == 0 || strcmp(name + len - 2, ".h") == 0;
+}
+
+// Reads everything that is queued on the inotify fd
+// Returns: true if a source file was written
+static bool drain_source_events(int fd)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char * p = buffer; p < buffer + n; )
+        {
+            const struct inotify_event * e = (const struct inotify_event *) p;
+            if (e->len > 0 && is_source_file(e->name)) changed = true;
+            p += sizeof(struct inotify_event) + e->len;
+        }
+    }
+    return changed;
+}
+
+static void rebuild_and_load(Reloader * r)
+{
+    printf("Rebuilding %s\n", dl_filename);
+    if (system(SOMP_BUILD_COMMAND) != 0)
+    {
+        printf("Build failed, keeping the current module\n");
+        return;
+    }
+
+    SompModule next = {0};
+    if (!load_module(&next)) return;
+
+    pthread_mutex_lock(&r->lock);
+    // A build that finished before the last one was swapped in just replaces it
+    if (r->ready) unload_module(&r->pending);
+    r->pending = next;
+    r->ready = true;
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void * reloader_thread(void * arg)
+{
+    Reloader * r = arg;
+    struct pollfd fds[2] = {
+        { .fd = r->wake_pipe[0], .events = POLLIN },
+        { .fd = r->inotify_fd,   .events = POLLIN },
+    };
+    const int fds_count = (r->inotify_fd >= 0) ? 2 : 1;
+
+    for (;;)
+    {
+        if (poll(fds, fds_count, -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        bool build = false;
+        if (fds[0].revents & POLLIN)
+        {
+            char c = 'q';
+            if (read(r->wake_pipe[0], &c, 1) != 1 || c == 'q') break;
+            build = true;
+        }
+        if (fds_count > 1 && (fds[1].revents & POLLIN)) build |= drain_source_events(r->inotify_fd);
+        if (!build) continue;
+
+        while (fds_count > 1 && poll(&fds[1], 1, DEBOUNCE_MS) > 0) drain_source_events(r->inotify_fd);
+        rebuild_and_load(r);
+    }
+    return NULL;
+}
+
+bool reloader_start(Reloader * r)
+{
+    *r = (Reloader){ .inotify_fd = -1, .wake_pipe = { -1, -1 } };
+    pthread_mutex_init(&r->lock, NULL);
+    if (pipe(r->wake_pipe) != 0) return false;
+
+    r->inotify_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if (r->inotify_fd < 0 || inotify_add_watch(r->inotify_fd, WATCH_DIR, IN_CLOSE_WRITE|IN_MOVED_TO) < 0)
+    {
+        // Not fatal, H still rebuilds
+        printf("Watching %s: %s, press H to reload\n", WATCH_DIR, strerror(errno));
+        if (r->inotify_fd >= 0) close(r->inotify_fd);
+        r->inotify_fd = -1;
+    }
+
+    r->running = pthread_create(&r->thread, NULL, reloader_thread, r) == 0;
+    return r->running;
+}
+
+void reloader_request(Reloader * r, char c)
+{
+    if (r->running && write(r->wake_pipe[1], &c, 1) != 1) printf("Could not wake reloader\n");
+}
+
+// Returns: true and the newly loaded module if a build finished since the
+// last call
+bool reloader_take(Reloader * r, SompModule * next)
+{
+    pthread_mutex_lock(&r->lock);
+    bool ready = r->ready;
+    if (ready) *next = r->pending;
+    r->ready = false;
+    pthread_mutex_unlock(&r->lock);
+    return ready;
+}
+
+void reloader_stop(Reloader * r)
+{
+    if (r->running)
+    {
+        reloader_request(r, 'q');
+        pthread_join(r->thread, NULL);
+    }
+    if (r->ready) unload_module(&r->pending);
+    if (r->inotify_fd >= 0) close(r->inotify_fd);
+    if (r->wake_pipe[0] >= 0) close(r->wake_pipe[0]);
+    if (r->wake_pipe[1] >= 0) close(r->wake_pipe[1]);
+    pthread_mutex_destroy(&r->lock);
+}
+// ======================================================================
 int main()
 {
     SDL_Window * sdl_window = NULL;
     SDL_Renderer * sdl_renderer = NULL;
     TTF_TextEngine * sdl_text_engine = NULL;
+    SompModule somp = {0};
 
     if (!SDL_Init(SDL_INIT_VIDEO)) goto cleanup;
     if (
@@ -87,26 +291,43 @@ int main()
     SDL_SetRenderDrawColor(sdl_renderer, 0,0,0,255);
     if (!(sdl_text_engine = TTF_CreateRendererTextEngine(sdl_renderer))) goto cleanup;
 
-    SompModule somp = {0};
-    load_module(&somp);
+    if (!load_module(&somp)) goto cleanup;
     somp.init(somp.state, sdl_window, sdl_renderer, sdl_text_engine);
 
+    Reloader reloader;
+    if (!reloader_start(&reloader)) printf("Could not start reloader thread, hot reload is off\n");
+
     bool quit = false;
-    bool reloaded_once = false;
+    bool requested_once = false;
     while (!quit)
     {
+        // H forces a rebuild, saving a source file does the same
         const bool * key_state = SDL_GetKeyboardState(NULL);
-        if (key_state[SDL_SCANCODE_H] && !reloaded_once)
+        if (key_state[SDL_SCANCODE_H] && !requested_once)
+        {
+            reloader_request(&reloader, 'b');
+            requested_once = true;
+        }
+        else if (!key_state[SDL_SCANCODE_H]) requested_once = false;
+
+        // Swap between frames, the new module is already loaded and resolved
+        SompModule next;
+        if (reloader_take(&reloader, &next))
         {
             somp.state = somp.close();
-            if (!load_module(&somp)) quit = true;
-            if (!somp.reload(somp.state)) quit = true;
-            reloaded_once = true;
+            next.state = somp.state;
+            void * old_handle = somp.handle;
+            somp = next;
+            // The new module may migrate the state into a new allocation
+            void * state = somp.reload(somp.state);
+            if (state == NULL) quit = true;
+            else somp.state = state;
+            if (old_handle != NULL) dlclose(old_handle);
         }
-        else if (!key_state[SDL_SCANCODE_H]) reloaded_once = false;
 
-        if (!somp.main()) quit = true;
+        if (!quit && !somp.main()) quit = true;
     };
+    reloader_stop(&reloader);
 
 cleanup:
     TTF_DestroyRendererTextEngine(sdl_text_engine);
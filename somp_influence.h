@@ -0,0 +1,236 @@
+#ifndef SOMP_INFLUENCE_H
+#define SOMP_INFLUENCE_H
+
+/*
+* Filename:	somp_influence.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Influence lines for the cantilever (wall at x=0, free at the beam length)
+* and moving load envelopes. Instead of calling solveBeam for every position
+* of a vehicle we use the closed form influence functions, with the same sign
+* convention as solveBeam
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+typedef struct {
+	int stationsCount;
+	float * stations;
+	float * shearMax;
+	float * shearMin;
+	float * momentMax;
+	float * momentMin;
+} Envelope;
+
+float shearInfluence(float x, float a, float beamLength);
+float momentInfluence(float x, float a, float beamLength);
+
+bool initEnvelope(Envelope * envelope, float beamLength, int stationsCount);
+void freeEnvelope(Envelope * envelope);
+bool sweepLoadTrain(float beamLength,
+		const PointForce train[], int trainCount,
+		float startPosition, float endPosition, int positionsCount,
+		int threadsCount, Envelope * envelope);
+
+#ifdef SOMP_INFLUENCE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <float.h>
+#include <pthread.h>
+
+/*
+ * Shear at x caused by a unit force at a, for x == a we give the value just
+ * to the right of the force
+ */
+float shearInfluence(float x, float a, float beamLength)
+{
+	if (a < 0 || a > beamLength) return 0;
+	return (x < a) ? 1 : 0;
+}
+
+float momentInfluence(float x, float a, float beamLength)
+{
+	if (a < 0 || a > beamLength) return 0;
+	return (x < a) ? -(a - x) : 0;
+}
+
+bool initEnvelope(Envelope * envelope, float beamLength, int stationsCount)
+{
+	*envelope = (Envelope){0};
+	if (stationsCount < 2) return false;
+
+	float * buffer = malloc(5 * stationsCount * sizeof(float));
+	if (buffer == NULL) return false;
+
+	envelope->stationsCount = stationsCount;
+	envelope->stations  = buffer;
+	envelope->shearMax  = buffer + 1*stationsCount;
+	envelope->shearMin  = buffer + 2*stationsCount;
+	envelope->momentMax = buffer + 3*stationsCount;
+	envelope->momentMin = buffer + 4*stationsCount;
+
+	for (int i = 0; i < stationsCount; i++)
+	{
+		envelope->stations[i] = beamLength * i / (stationsCount-1);
+	}
+	return true;
+}
+
+void freeEnvelope(Envelope * envelope)
+{
+	// Everything lives in one allocation that starts at stations
+	free(envelope->stations);
+	*envelope = (Envelope){0};
+}
+
+typedef struct {
+	float beamLength;
+	const PointForce * train;
+	int trainCount;
+	float startPosition;
+	float positionStep;
+	int firstPosition;
+	int lastPosition; // exclusive
+
+	const float * stations;
+	int stationsCount;
+	float * shearMax;
+	float * shearMin;
+	float * momentMax;
+	float * momentMin;
+} SweepJob;
+
+static void * sweepLoadTrainJob(void * arg)
+{
+	SweepJob * job = (SweepJob *) arg;
+
+	for (int s = 0; s < job->stationsCount; s++)
+	{
+		job->shearMax[s]  = -FLT_MAX;
+		job->shearMin[s]  =  FLT_MAX;
+		job->momentMax[s] = -FLT_MAX;
+		job->momentMin[s] =  FLT_MAX;
+	}
+
+	for (int p = job->firstPosition; p < job->lastPosition; p++)
+	{
+		float position = job->startPosition + p*job->positionStep;
+
+		for (int s = 0; s < job->stationsCount; s++)
+		{
+			float x = job->stations[s];
+			float shear = 0;
+			float moment = 0;
+			for (int i = 0; i < job->trainCount; i++)
+			{
+				float a = position + job->train[i].distance;
+				shear  += job->train[i].force * shearInfluence(x, a, job->beamLength);
+				moment += job->train[i].force * momentInfluence(x, a, job->beamLength);
+			}
+
+			job->shearMax[s]  = maxf(job->shearMax[s], shear);
+			job->shearMin[s]  = minf(job->shearMin[s], shear);
+			job->momentMax[s] = maxf(job->momentMax[s], moment);
+			job->momentMin[s] = minf(job->momentMin[s], moment);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Move a train of point forces across the beam and record the max/min shear
+ * and moment at every station of the envelope
+ *
+ * Parameters:
+ *  [in]beamLength: length of the beam
+ *  [in]train[]: the loads, distance is the offset of each load from the
+ *      position of the train, loads that are off the beam are ignored
+ *  [in]trainCount: number of loads in the train
+ *  [in]startPosition, endPosition: first and last position of the train
+ *  [in]positionsCount: number of positions between start and end (inclusive)
+ *  [in]threadsCount: positions get split between this many threads
+ *  [out]envelope: made with initEnvelope, the results are written to it
+ *
+ * Return:
+ *  bool: false if there are no positions or a thread could not be started
+ */
+bool sweepLoadTrain(float beamLength,
+		const PointForce train[], int trainCount,
+		float startPosition, float endPosition, int positionsCount,
+		int threadsCount, Envelope * envelope)
+{
+	if (positionsCount < 1) return false;
+	if (threadsCount < 1) threadsCount = 1;
+	if (threadsCount > positionsCount) threadsCount = positionsCount;
+
+	const int n = envelope->stationsCount;
+	SweepJob * jobs = malloc(threadsCount * sizeof(SweepJob));
+	pthread_t * threads = malloc(threadsCount * sizeof(pthread_t));
+	// The first job writes straight into the envelope, the others get their
+	// own scratch that is merged afterwards
+	float * scratch = malloc(4 * n * threadsCount * sizeof(float));
+	if (jobs == NULL || threads == NULL || scratch == NULL)
+	{
+		free(jobs);
+		free(threads);
+		free(scratch);
+		return false;
+	}
+
+	float step = (positionsCount > 1) ? (endPosition - startPosition)/(positionsCount-1) : 0;
+	int perThread = (positionsCount + threadsCount - 1) / threadsCount;
+	int started = 0;
+	bool ok = true;
+
+	for (int t = 0; t < threadsCount; t++)
+	{
+		float * buffer = scratch + 4*n*t;
+		jobs[t] = (SweepJob){
+			.beamLength = beamLength,
+			.train = train,
+			.trainCount = trainCount,
+			.startPosition = startPosition,
+			.positionStep = step,
+			.firstPosition = t*perThread,
+			.lastPosition = MIN((t+1)*perThread, positionsCount),
+			.stations = envelope->stations,
+			.stationsCount = n,
+			.shearMax  = (t == 0) ? envelope->shearMax  : buffer,
+			.shearMin  = (t == 0) ? envelope->shearMin  : buffer + n,
+			.momentMax = (t == 0) ? envelope->momentMax : buffer + 2*n,
+			.momentMin = (t == 0) ? envelope->momentMin : buffer + 3*n,
+		};
+		if (t == 0) continue;
+		if (pthread_create(&threads[t], NULL, sweepLoadTrainJob, &jobs[t]) != 0)
+		{
+			ok = false;
+			break;
+		}
+		started = t;
+	}
+
+	// The calling thread does the first chunk itself
+	sweepLoadTrainJob(&jobs[0]);
+
+	for (int t = 1; t <= started; t++)
+	{
+		pthread_join(threads[t], NULL);
+		for (int s = 0; s < n; s++)
+		{
+			envelope->shearMax[s]  = maxf(envelope->shearMax[s],  jobs[t].shearMax[s]);
+			envelope->shearMin[s]  = minf(envelope->shearMin[s],  jobs[t].shearMin[s]);
+			envelope->momentMax[s] = maxf(envelope->momentMax[s], jobs[t].momentMax[s]);
+			envelope->momentMin[s] = minf(envelope->momentMin[s], jobs[t].momentMin[s]);
+		}
+	}
+
+	free(jobs);
+	free(threads);
+	free(scratch);
+	return ok;
+}
+
+#endif // SOMP_INFLUENCE_IMPLEMENTATION
+#endif // SOMP_INFLUENCE_H
@@ -7,9 +7,30 @@ typedef struct PointForces PointForces;
 typedef struct DistributedForces DistributedForces;
 
 bool read_info_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForces * dfs);
+// Same as read_info_cli, with the optional #PM and #DM sections
+bool read_loads_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForces * dfs,
+        PointMoments * pms, DistributedMoments * dms);
+
+// Where every section of a case file goes. pfs and dfs are always needed, an
+// optional section whose array is NULL fails
+typedef struct {
+    PointForces * pfs;
+    DistributedForces * dfs;
+    PointMoments * pms;        // #PM
+    DistributedMoments * dms;  // #DM
+    PointForces * pas;         // #PA, axial point forces
+    DistributedForces * das;   // #DA, axial distributed forces
+    PointMoments * pts;        // #PT, point torques
+    DistributedMoments * dts;  // #DT, distributed torques
+} CaseArrays;
+// Same as read_loads_cli, with the axial and torque sections as well
+bool read_case_cli(FILE * file, Beam * beam, const CaseArrays * arrays);
 bool read_beam_info_cli(char * line, Beam * beam);
+bool read_support_cli(const char * token, SupportKind * kind);
 bool read_pointforce_info_cli(char * line, PointForce * p);
 bool read_distributedforce_info_cli(char * line, DistributedForce * d);
+bool read_pointmoment_info_cli(char * line, PointMoment * p);
+bool read_distributedmoment_info_cli(char * line, DistributedMoment * d);
 
 #ifdef SOMP_IO_IMPLEMENTATION
 #include <stdio.h>
@@ -23,7 +44,7 @@ bool read_distributedforce_info_cli(char * line, DistributedForce * d);
  * Distances are measured from left of beam
  * Format:
  *  #B (beam section)
- *  (length of beam: float) [max number of sections the beam could have: int]
+ *  (length of beam: float) [max number of sections the beam could have: int] [support at 0, support at the end]
  *  #PF (point force section)
  *  (distance: float) (force: float)
  *  ....
@@ -31,9 +52,45 @@ bool read_distributedforce_info_cli(char * line, DistributedForce * d);
  *  (start dist: float) (end dist: float) [ (coeff. of x^0: float) (coeff. of x^1) ... ]
  *  ....
  *  \n or EOF
+ *
+ * Moments are not read, a #PM or #DM section fails
 */
 bool read_info_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForces * dfs)
 {
+    return read_loads_cli(file, beam, pfs, dfs, NULL, NULL);
+}
+/**
+ * Same format as read_info_cli, the distributed forces can be followed by
+ * these sections, in this order and both optional:
+ *  #PM (point moment section, clockwise is positive)
+ *  (distance: float) (moment: float)
+ *  ....
+ *  #DM (distributed moment section)
+ *  (start dist: float) (end dist: float) [ (coeff. of x^0: float) (coeff. of x^1) ... ]
+ *  ....
+ *  \n or EOF
+ *
+ * pms, dms: NULL to fail on the matching section
+*/
+bool read_loads_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForces * dfs,
+        PointMoments * pms, DistributedMoments * dms)
+{
+    return read_case_cli(file, beam, &(CaseArrays){ .pfs = pfs, .dfs = dfs, .pms = pms, .dms = dms });
+}
+/*
+ * After #DF a case file can have #PM, #DM, #PA, #DA, #PT and #DT, in that
+ * order and each one optional:
+ *  #PM, #PT (distance: float) (moment or torque: float)
+ *  #DM, #DT (start dist: float) (end dist: float) [ (coeff. of x^0: float) ... ]
+ *  #PA (distance: float) (force along the beam: float)
+ *  #DA same as #DF
+ * Torques are right handed about the beam axis, axial forces positive
+ * pointing to the end of the beam
+ */
+bool read_case_cli(FILE * file, Beam * beam, const CaseArrays * arrays)
+{
+    PointForces * pfs = arrays->pfs;
+    DistributedForces * dfs = arrays->dfs;
     //TODO: this should become a state machine so point force or distrib force
     //sections arent required
     //TODO: exit on ^D
@@ -41,6 +98,16 @@ bool read_info_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForce
     int line_num = 1;
     size_t line_buffer_size = 0;
 #define FAIL(l, ln) do { printf(">> Failed reading input on line %d\n", (ln)); free((l)); return false; } while(0)
+// Reads the lines of a section up to the next section, a blank line or EOF.
+// more is false once EOF is reached
+#define READ_SECTION(type, array, read) \
+    while ((more = getline(&line, &line_buffer_size, file) != -1) && line[0] != '\n' && line[0] != '#') \
+    { \
+        line_num++; \
+        type item = {0}; \
+        if (!read(line, &item)) FAIL(line, line_num); \
+        if (!DynamicArrayTryAppend((array), item)) FAIL(line, line_num); \
+    }
 
     getline(&line, &line_buffer_size, file); line_num++;
     if (strcmp(line, "#B\n") != 0) FAIL(line, line_num);
@@ -56,17 +123,46 @@ bool read_info_cli(FILE * file, Beam * beam, PointForces * pfs, DistributedForce
         line_num++;
         PointForce point = {0};
         if (!read_pointforce_info_cli(line, &point)) FAIL(line, line_num);
-        DynamicArrayAppend(pfs, point);
+        if (!DynamicArrayTryAppend(pfs, point)) FAIL(line, line_num);
     };
 
     if (strcmp(line, "#DF\n") != 0) FAIL(line, line_num);
-    while (getline(&line, &line_buffer_size, file) != -1 && line[0] != '\n')
+    bool more;
+    READ_SECTION(DistributedForce, dfs, read_distributedforce_info_cli);
+
+    if (more && strcmp(line, "#PM\n") == 0)
     {
-        line_num++;
-        DistributedForce distrib = {0};
-        if (!read_distributedforce_info_cli(line, &distrib)) FAIL(line, line_num);
-        DynamicArrayAppend(dfs, distrib);
-    };
+        if (arrays->pms == NULL) FAIL(line, line_num);
+        READ_SECTION(PointMoment, arrays->pms, read_pointmoment_info_cli);
+    }
+    if (more && strcmp(line, "#DM\n") == 0)
+    {
+        if (arrays->dms == NULL) FAIL(line, line_num);
+        READ_SECTION(DistributedMoment, arrays->dms, read_distributedmoment_info_cli);
+    }
+    if (more && strcmp(line, "#PA\n") == 0)
+    {
+        if (arrays->pas == NULL) FAIL(line, line_num);
+        READ_SECTION(PointForce, arrays->pas, read_pointforce_info_cli);
+    }
+    if (more && strcmp(line, "#DA\n") == 0)
+    {
+        if (arrays->das == NULL) FAIL(line, line_num);
+        READ_SECTION(DistributedForce, arrays->das, read_distributedforce_info_cli);
+    }
+    if (more && strcmp(line, "#PT\n") == 0)
+    {
+        if (arrays->pts == NULL) FAIL(line, line_num);
+        READ_SECTION(PointMoment, arrays->pts, read_pointmoment_info_cli);
+    }
+    if (more && strcmp(line, "#DT\n") == 0)
+    {
+        if (arrays->dts == NULL) FAIL(line, line_num);
+        READ_SECTION(DistributedMoment, arrays->dts, read_distributedmoment_info_cli);
+    }
+    // A section out of order or one we do not know
+    if (more && line[0] == '#') FAIL(line, line_num);
+#undef READ_SECTION
 
     free(line);
     return true;
@@ -75,11 +171,38 @@ bool read_beam_info_cli(char * line, Beam * beam)
 {
     //#B
     //1.0 10
-    int num_reads = sscanf(line, "%f %d\n", &beam->length, &beam->sections_count);
-    if (num_reads == 1) beam->sections_count = MAX_SECTIONS;
-    if (num_reads < 1 || num_reads > 2) return false;
+    //1.0 10 pin roller
+    //1.0 fixed fixed
+    int consumed = 0;
+    if (sscanf(line, "%f%n", &beam->length, &consumed) != 1) return false;
+    line += consumed;
+    if (sscanf(line, "%d%n", &beam->sections_count, &consumed) == 1) line += consumed;
+    else beam->sections_count = MAX_SECTIONS;
+
+    // Both supports or neither, without them it stays a cantilever
+    char left[16], right[16];
+    int supports = sscanf(line, "%15s %15s", left, right);
+    beam->supports = (BeamSupports){0};
+    if (supports == 1) return false;
+    if (supports == 2)
+    {
+        if (!read_support_cli(left, &beam->supports.left)) return false;
+        if (!read_support_cli(right, &beam->supports.right)) return false;
+    }
     return true;
 }
+bool read_support_cli(const char * token, SupportKind * kind)
+{
+    for (int i = SUPPORT_FREE; i < SUPPORT_KINDS_COUNT; i++)
+    {
+        if (strcmp(token, supportName(i)) == 0)
+        {
+            *kind = i;
+            return true;
+        }
+    }
+    return false;
+}
 bool read_pointforce_info_cli(char * line, PointForce * p) 
 {
     //#PF
@@ -91,15 +214,9 @@ bool read_pointforce_info_cli(char * line, PointForce * p)
     if (sscanf(line, "%f %f\n", &p->distance, &p->force) != 2) return false;
     return true;
 }
-bool read_distributedforce_info_cli(char * line, DistributedForce * d) 
+// (start) (end) [ coefficients ], missing coefficients are 0
+static bool read_span_polynomial_cli(char * line, float * start, float * end, float polynomial[MAX_POLYNOMIAL_DEGREE])
 {
-    //#DF
-    //4
-    //0 0.5 [ 1 0 ]
-    //0.25 0.75 [ 2 0 ]
-    //0.75 1.0 [ 3 0 ]
-    //0.65 0.95 [ 4 0 ]
-    
     char * token;
     char * props = strtok(line, "[");
     char * poly = strtok(NULL, "]");
@@ -108,10 +225,10 @@ bool read_distributedforce_info_cli(char * line, DistributedForce * d)
 
     token = strtok(props, " ");
     if (token == NULL) return false;
-    d->start = atof(token);
+    *start = atof(token);
     token = strtok(NULL, " ");
     if (token == NULL) return false;
-    d->end = atof(token);
+    *end = atof(token);
     token = strtok(NULL, " ");
     if (token != NULL) return false; // Expected end of props
 
@@ -119,19 +236,43 @@ bool read_distributedforce_info_cli(char * line, DistributedForce * d)
     int index = 0;
     while (token != NULL && index < MAX_POLYNOMIAL_DEGREE)
     {
-        d->polynomial[index] = atof(token);
+        polynomial[index] = atof(token);
         token = strtok(NULL, " ");
         index++;
     }
 
     while (index < MAX_POLYNOMIAL_DEGREE)
     {
-        d->polynomial[index] = 0;
+        polynomial[index] = 0;
         index++;
     }
 
     return true;
 }
+bool read_distributedforce_info_cli(char * line, DistributedForce * d) 
+{
+    //#DF
+    //4
+    //0 0.5 [ 1 0 ]
+    //0.25 0.75 [ 2 0 ]
+    //0.75 1.0 [ 3 0 ]
+    //0.65 0.95 [ 4 0 ]
+    return read_span_polynomial_cli(line, &d->start, &d->end, d->polynomial);
+}
+bool read_pointmoment_info_cli(char * line, PointMoment * p)
+{
+    //#PM
+    //0.5  2
+    //0.75 -1
+    if (sscanf(line, "%f %f\n", &p->distance, &p->moment) != 2) return false;
+    return true;
+}
+bool read_distributedmoment_info_cli(char * line, DistributedMoment * d)
+{
+    //#DM
+    //0 1.0 [ 1 ]
+    return read_span_polynomial_cli(line, &d->start, &d->end, d->polynomial);
+}
 
 #endif //SOMP_IO_IMPLEMENTATION
 #endif // SOMP_IO_H
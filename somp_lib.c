@@ -0,0 +1,196 @@
+/*
+* Filename:	somp_lib.c
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* libsomp, see libsomp.h. Built with -fvisibility=hidden so only the
+* LIBSOMP_API functions are exported, the solver helpers from the headers
+* stay inside the library and cannot collide with a program that has its
+* own copy of them
+*/
+
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "libsomp.h"
+
+#define UTILS_IMPLEMENTATION
+#include "utils.h"
+
+#define SOMP_LOGIC_IMPLEMENTATION
+#include "somp_logic.h"
+
+#define SOMP_QUERY_IMPLEMENTATION
+#include "somp_query.h"
+
+// The public structs are handed straight to the solver, they have to stay
+// the same as the ones it uses
+_Static_assert(LIBSOMP_MAX_POLYNOMIAL_DEGREE == MAX_POLYNOMIAL_DEGREE, "polynomial size");
+_Static_assert(sizeof(LibsompPointForce) == sizeof(PointForce), "point force layout");
+_Static_assert(offsetof(LibsompPointForce, force) == offsetof(PointForce, force), "point force layout");
+_Static_assert(sizeof(LibsompDistributedForce) == sizeof(DistributedForce), "distributed force layout");
+_Static_assert(offsetof(LibsompDistributedForce, polynomial) == offsetof(DistributedForce, polynomial), "distributed force layout");
+_Static_assert(sizeof(LibsompSection) == sizeof(Section), "section layout");
+_Static_assert(offsetof(LibsompSection, point_force) == offsetof(Section, pointForce), "section layout");
+_Static_assert(offsetof(LibsompSection, polynomial) == offsetof(Section, polynomial), "section layout");
+_Static_assert((int) LIBSOMP_SUPPORT_FREE == (int) SUPPORT_FREE && (int) LIBSOMP_SUPPORT_FIXED == (int) SUPPORT_FIXED, "support kinds");
+
+struct LibsompSolver {
+	SolverContext ctx;
+	Beam beam;
+	bool solved;
+};
+
+LIBSOMP_API int libsomp_version(void)
+{
+	return LIBSOMP_VERSION_MAJOR*1000 + LIBSOMP_VERSION_MINOR;
+}
+
+LIBSOMP_API const char * libsomp_status_string(LibsompStatus status)
+{
+	switch (status) {
+	case LIBSOMP_OK: return "ok";
+	case LIBSOMP_ERROR_ARGUMENT: return "invalid argument";
+	case LIBSOMP_ERROR_TOO_MANY_SECTIONS: return "forces split the beam into too many sections";
+	case LIBSOMP_ERROR_MEMORY: return "out of memory";
+	case LIBSOMP_ERROR_NOT_SOLVED: return "nothing solved yet";
+	}
+	return "unknown status";
+}
+
+LIBSOMP_API LibsompSolver * libsomp_solver_new(void)
+{
+	LibsompSolver * solver = calloc(1, sizeof(LibsompSolver));
+	if (solver == NULL) return NULL;
+	initSolverContext(&solver->ctx);
+	return solver;
+}
+
+LIBSOMP_API void libsomp_solver_free(LibsompSolver * solver)
+{
+	if (solver == NULL) return;
+	freeSolverContext(&solver->ctx);
+	free(solver);
+}
+
+LIBSOMP_API LibsompStatus libsomp_solve(LibsompSolver * solver, float length,
+		const LibsompPointForce * point_forces, int point_forces_count,
+		const LibsompDistributedForce * distributed_forces, int distributed_forces_count)
+{
+	if (solver == NULL || length <= 0) return LIBSOMP_ERROR_ARGUMENT;
+	if (point_forces_count < 0 || (point_forces_count > 0 && point_forces == NULL)) return LIBSOMP_ERROR_ARGUMENT;
+	if (distributed_forces_count < 0 || (distributed_forces_count > 0 && distributed_forces == NULL)) return LIBSOMP_ERROR_ARGUMENT;
+
+	solver->solved = false;
+	// Reserving the scratch here tells running out of memory apart from too
+	// many sections
+	arena_reset(&solver->ctx.scratch);
+	if (!arena_reserve(&solver->ctx.scratch, sectionsScratchSize(point_forces_count, distributed_forces_count)))
+		return LIBSOMP_ERROR_MEMORY;
+
+	solver->beam.length = length;
+	// solveBeamCtx copies the point forces and only reads the distributed
+	// ones, the casts do not let it write to the caller's arrays
+	bool ok = solveBeamCtx(&solver->ctx, &solver->beam,
+			(PointForce *) point_forces, point_forces_count,
+			(DistributedForce *) distributed_forces, distributed_forces_count);
+	if (!ok) return LIBSOMP_ERROR_TOO_MANY_SECTIONS;
+	solver->solved = true;
+	return LIBSOMP_OK;
+}
+
+LIBSOMP_API LibsompStatus libsomp_set_supports(LibsompSolver * solver, LibsompSupport left, LibsompSupport right)
+{
+	if (solver == NULL) return LIBSOMP_ERROR_ARGUMENT;
+	if (left < LIBSOMP_SUPPORT_DEFAULT || left > LIBSOMP_SUPPORT_FIXED) return LIBSOMP_ERROR_ARGUMENT;
+	if (right < LIBSOMP_SUPPORT_DEFAULT || right > LIBSOMP_SUPPORT_FIXED) return LIBSOMP_ERROR_ARGUMENT;
+	BeamSupports supports = { (SupportKind) left, (SupportKind) right };
+	if (!supportsHoldBeam(supports)) return LIBSOMP_ERROR_ARGUMENT;
+
+	solver->beam.supports = supports;
+	solver->solved = false;
+	return LIBSOMP_OK;
+}
+
+LIBSOMP_API float libsomp_wall_reaction_force(const LibsompSolver * solver)
+{
+	return (solver != NULL && solver->solved) ? solver->beam.wall_reaction_force : 0;
+}
+
+LIBSOMP_API float libsomp_wall_reaction_moment(const LibsompSolver * solver)
+{
+	return (solver != NULL && solver->solved) ? solver->beam.wall_reaction_moment : 0;
+}
+
+LIBSOMP_API float libsomp_end_reaction_force(const LibsompSolver * solver)
+{
+	return (solver != NULL && solver->solved) ? solver->beam.end_reaction_force : 0;
+}
+
+LIBSOMP_API float libsomp_end_reaction_moment(const LibsompSolver * solver)
+{
+	return (solver != NULL && solver->solved) ? solver->beam.end_reaction_moment : 0;
+}
+
+LIBSOMP_API int libsomp_sections_count(const LibsompSolver * solver)
+{
+	return (solver != NULL && solver->solved) ? solver->beam.sections_count : 0;
+}
+
+// Section just right of x, a point force at x is already applied. The free
+// end uses the last section with any length
+static int section_at(const Beam * beam, float x)
+{
+	// Same lookup as libsomp_sample, past a section without length (the one
+	// that carries a point force at the end of the beam) back to the one
+	// before it
+	int i = pw_find(beam->raws, beam->sections_count, x);
+	while (i > 0 && beam->raws[i].end <= beam->raws[i].start) i--;
+	return i;
+}
+
+LIBSOMP_API float libsomp_shear_at(const LibsompSolver * solver, float x)
+{
+	if (solver == NULL || !solver->solved) return 0;
+	return evalPolynomial(x, solver->beam.shears[section_at(&solver->beam, x)].polynomial);
+}
+
+LIBSOMP_API float libsomp_moment_at(const LibsompSolver * solver, float x)
+{
+	if (solver == NULL || !solver->solved) return 0;
+	return evalPolynomial(x, solver->beam.moments[section_at(&solver->beam, x)].polynomial);
+}
+
+LIBSOMP_API LibsompStatus libsomp_get_sections(const LibsompSolver * solver,
+		LibsompSectionKind kind, LibsompSection * dest, int capacity)
+{
+	if (solver == NULL || dest == NULL) return LIBSOMP_ERROR_ARGUMENT;
+	if (!solver->solved) return LIBSOMP_ERROR_NOT_SOLVED;
+	if (capacity < solver->beam.sections_count) return LIBSOMP_ERROR_ARGUMENT;
+
+	const Section * sections;
+	switch (kind) {
+	case LIBSOMP_SECTIONS_LOAD: sections = solver->beam.raws; break;
+	case LIBSOMP_SECTIONS_SHEAR: sections = solver->beam.shears; break;
+	case LIBSOMP_SECTIONS_MOMENT: sections = solver->beam.moments; break;
+	default: return LIBSOMP_ERROR_ARGUMENT;
+	}
+	memcpy(dest, sections, solver->beam.sections_count * sizeof(Section));
+	return LIBSOMP_OK;
+}
+
+LIBSOMP_API LibsompStatus libsomp_sample(const LibsompSolver * solver,
+		LibsompSectionKind kind, const float * xs, int count, float * left, float * right)
+{
+	if (solver == NULL || count < 0 || (count > 0 && (xs == NULL || right == NULL))) return LIBSOMP_ERROR_ARGUMENT;
+	if (!solver->solved) return LIBSOMP_ERROR_NOT_SOLVED;
+
+	DiagramKind diagram;
+	switch (kind) {
+	case LIBSOMP_SECTIONS_SHEAR: diagram = DIAGRAM_SHEAR; break;
+	case LIBSOMP_SECTIONS_MOMENT: diagram = DIAGRAM_MOMENT; break;
+	default: return LIBSOMP_ERROR_ARGUMENT;
+	}
+	query_beam_sorted(&solver->beam, diagram, xs, count, left, right);
+	return LIBSOMP_OK;
+}
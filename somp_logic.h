@@ -15,7 +15,9 @@
 #define UTILS_IMPLEMENTATION
 #include "utils.h"
 
-#define MAX_POLYNOMIAL_DEGREE 4
+#define SOMP_POLY_IMPLEMENTATION
+#include "somp_poly.h"
+
 #define MAX_SECTIONS 20
 
 struct PointForce 
@@ -48,27 +50,123 @@ struct DistributedForces{
     int capacity;
 };
 
-struct Section
+// Applied moments, positive is clockwise: the moment diagram steps up by a
+// point moment going left to right
+struct PointMoment
+{
+	float distance;
+	float moment;
+};
+typedef struct PointMoment PointMoment;
+
+// Moment per length over [start, end]
+struct DistributedMoment
 {
 	float start;
 	float end;
-	float pointForce;
 	float polynomial[MAX_POLYNOMIAL_DEGREE];
 };
-typedef struct Section Section;
+typedef struct DistributedMoment DistributedMoment;
+
+typedef struct {
+	PointMoment * items;
+	int count;
+	int capacity;
+} PointMoments;
+
+typedef struct {
+	DistributedMoment * items;
+	int count;
+	int capacity;
+} DistributedMoments;
+
+// Everything acting on a beam, any of the arrays can be NULL when its count
+// is 0
+typedef struct {
+	PointForce * pointForces;
+	int pfCount;
+	DistributedForce * distributedForces;
+	int dfCount;
+	PointMoment * pointMoments;
+	int pmCount;
+	DistributedMoment * distributedMoments;
+	int dmCount;
+	// Along the beam, positive towards x = length
+	PointForce * axialPointForces;
+	int apCount;
+	DistributedForce * axialDistributedForces;
+	int adCount;
+	// About the beam axis, positive right handed around +x
+	PointMoment * pointTorques;
+	int ptCount;
+	DistributedMoment * distributedTorques;
+	int dtCount;
+} BeamLoads;
+
+// The load channels of a beam, every one of them on the same sections
+typedef enum {
+	LOAD_FORCES,  // raws
+	LOAD_MOMENTS, // applied_moments
+	LOAD_AXIAL,   // applied_axial
+	LOAD_TORQUES, // applied_torques
+	LOAD_CHANNELS,
+} LoadChannel;
+
+// How an end of the beam is held. The zero value keeps every Beam a
+// cantilever: fixed at x = 0 and free at the other end
+typedef enum {
+	SUPPORT_DEFAULT = 0,
+	SUPPORT_FREE,
+	SUPPORT_PIN,
+	SUPPORT_ROLLER, // same as a pin for vertical loads, slides along the beam
+	SUPPORT_FIXED,
+	SUPPORT_KINDS_COUNT,
+} SupportKind;
+
+typedef struct {
+	SupportKind left;  // at x = 0
+	SupportKind right; // at x = length
+} BeamSupports;
 
 struct Beam {
 	float length;
+	// Reactions at x = 0: the force (up is positive) and the moment in the
+	// beam there. Without a support at x = 0 both are 0
     float wall_reaction_force;
     float wall_reaction_moment;
 	int sections_count;
+	BeamSupports supports;
+	// Same as the wall reactions, at x = length
+	float end_reaction_force;
+	float end_reaction_moment;
+	// Axial force (tension positive) and torque in the beam at x = 0, the
+	// support at x = length takes the axial force and torque there
+	float wall_reaction_axial;
+	float wall_reaction_torque;
 	Section raws[MAX_SECTIONS];
 	Section shears[MAX_SECTIONS];
 	Section moments[MAX_SECTIONS];
+	// The applied moments on the same sections as raws: pointForce is the
+	// point moment at the start of a section, polynomial the moment per length
+	Section applied_moments[MAX_SECTIONS];
+	// Axial loads and torques on the same sections, like applied_moments
+	Section applied_axial[MAX_SECTIONS];
+	Section applied_torques[MAX_SECTIONS];
+	// Axial force and torque along the beam
+	Section axials[MAX_SECTIONS];
+	Section torques[MAX_SECTIONS];
 };
 typedef struct Beam Beam;
 
-float evalPolynomial(float x, float poly[MAX_POLYNOMIAL_DEGREE]);
+// Scratch memory for a solve. Keep one per thread and reuse it, after the
+// first few solves it has grown big enough and no more heap calls are made
+struct SolverContext {
+	Arena scratch;
+	Pool nodes;
+};
+typedef struct SolverContext SolverContext;
+
+float evalPolynomial(float x, const float poly[MAX_POLYNOMIAL_DEGREE]);
 void integratePolynomial(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE]);
 
 void printSection(const void * vp);
@@ -88,18 +186,50 @@ int compDistributedStarts(const void * a, const void * b);
 int compDistributedEnds(const void * a, const void * b);
 int compDistributedEndsPtr(const void * a, const void * b);
 
+void initSolverContext(SolverContext * ctx);
+void freeSolverContext(SolverContext * ctx);
+long solverContextHeapCalls(const SolverContext * ctx);
+
 bool seperateBeamIntoSections(float beamLength,
 		PointForce pForces[],       int pfCount, 
 		DistributedForce dForces[], int dfCount, 
 		Section sections[],         int * sectionsCount);
+bool seperateBeamIntoSectionsCtx(SolverContext * ctx, float beamLength,
+		PointForce pForces[],       int pfCount, 
+		DistributedForce dForces[], int dfCount, 
+		Section sections[],         int * sectionsCount);
+// Scratch seperateBeamIntoSectionsCtx reserves for these forces, reserving
+// it up front tells running out of memory apart from too many sections
+size_t sectionsScratchSize(int pfCount, int dfCount);
+// Same as seperateBeamIntoSectionsCtx for every channel of loads, they all
+// end up on the same sections: channels[LOAD_FORCES] gets the forces,
+// channels[LOAD_MOMENTS] the applied moments and so on. A channel only adds
+// a section where no other one starts one
+bool seperateLoadsIntoSectionsCtx(SolverContext * ctx, float beamLength,
+		const BeamLoads * loads,
+		Section * channels[LOAD_CHANNELS], int * sectionsCount);
 float calculateWallReactionMoment(Section sections[], int sectionsCount);
 float calculateWallReactionForce(Section sections[], int sectionsCount);
 
-void solveShearSections(Section shear[], Section raw[], int count);
-void solveMomentSections(Section moment[], Section shear[], Section raw[], int count);
+BeamSupports effectiveSupports(BeamSupports supports);
+const char * supportName(SupportKind kind);
+// Returns: false when the supports let the beam move (free-free, a pin and
+// a free end)
+bool supportsHoldBeam(BeamSupports supports);
+bool supportReactions(BeamSupports supports, double length, const double I[4], double reactions[4]);
+bool solveReactions(Beam * beam);
+bool solveAxialReactions(Beam * beam);
+
+void solveShearSections(Section shear[], const Section raw[], int count, float leftReactionForce);
+void solveMomentSections(Section moment[], const Section shear[], const Section applied[], int count, float leftMoment);
+void solveSectionDiagrams(Beam * beam);
 bool solveBeam(Beam * beam,
 		PointForce pointForces[], int pfCount,
 		DistributedForce distributedForces[], int dfCount);
+bool solveBeamCtx(SolverContext * ctx, Beam * beam,
+		PointForce pointForces[], int pfCount,
+		DistributedForce distributedForces[], int dfCount);
+bool solveBeamLoads(SolverContext * ctx, Beam * beam, const BeamLoads * loads);
 
 #ifdef SOMP_LOGIC_IMPLEMENTATION
 
@@ -107,6 +237,7 @@ bool solveBeam(Beam * beam,
 #include <stdio.h>  
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 
 /// FROM STACKOVERFLOW: Daniel Gehriger at 
@@ -132,6 +263,11 @@ bool comp_beams(void * a, void * b)
         if (!comp_sections(&A->raws[j], &B->raws[j])) return false;
         if (!comp_sections(&A->shears[j], &B->shears[j])) return false;
         if (!comp_sections(&A->moments[j], &B->moments[j])) return false;
+        if (!comp_sections(&A->applied_moments[j], &B->applied_moments[j])) return false;
+        if (!comp_sections(&A->applied_axial[j], &B->applied_axial[j])) return false;
+        if (!comp_sections(&A->applied_torques[j], &B->applied_torques[j])) return false;
+        if (!comp_sections(&A->axials[j], &B->axials[j])) return false;
+        if (!comp_sections(&A->torques[j], &B->torques[j])) return false;
     }
 
 	return true;
@@ -248,10 +384,7 @@ void LL_SumDistributedPolynomials(LL_Node * head, float poly[])
 	while (current)
 	{
 		DistributedForce * d = (DistributedForce *) current->data;
-		for (int i = 0; i < MAX_POLYNOMIAL_DEGREE; i++)
-		{
-			poly[i] += d->polynomial[i];
-		}
+		poly_add(poly, d->polynomial);
 		current = current->next;
 	}
 }
@@ -316,11 +449,118 @@ int compDistributedEndsPtr(const void * a, const void * b)
 	
 	return 0;
 }
+// Sorting of the force events. These used to go through qsort with the
+// comparison functions above, the calls through a function pointer were most
+// of the cost for big load sets. Small arrays use insertion sort, big ones a
+// radix sort on the bits of the float key. Both are stable
+#define SORT_RADIX_THRESHOLD 64
+
+// Maps a float to an unsigned int with the same ordering
+static inline uint32_t floatSortKey(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static inline float pointForceKey(const PointForce * p) { return p->distance; }
+static inline float distributedStartKey(DistributedForce * const * d) { return (*d)->start; }
+static inline float distributedEndKey(DistributedForce * const * d) { return (*d)->end; }
+
+/*
+ * Defines name(arr, n, temp) that sorts n items of type by key(&item)
+ * temp: scratch with room for n items, only used above SORT_RADIX_THRESHOLD
+ */
+#define DEFINE_FORCE_SORT(name, type, key) \
+static void name(type * arr, int n, type * temp) \
+{ \
+	int sorted = 1; \
+	for (int i = 1; i < n && sorted; i++) sorted = key(&arr[i-1]) <= key(&arr[i]); \
+	if (sorted) return; \
+	if (n < SORT_RADIX_THRESHOLD) \
+	{ \
+		for (int i = 1; i < n; i++) \
+		{ \
+			type item = arr[i]; \
+			float k = key(&item); \
+			int j = i - 1; \
+			while (j >= 0 && key(&arr[j]) > k) { arr[j+1] = arr[j]; j--; } \
+			arr[j+1] = item; \
+		} \
+		return; \
+	} \
+	type * src = arr; \
+	type * dst = temp; \
+	for (int shift = 0; shift < 32; shift += 8) \
+	{ \
+		int counts[256] = {0}; \
+		for (int i = 0; i < n; i++) counts[(floatSortKey(key(&src[i])) >> shift) & 0xff]++; \
+		if (counts[(floatSortKey(key(&src[0])) >> shift) & 0xff] == n) continue; \
+		int offset = 0; \
+		for (int b = 0; b < 256; b++) { int c = counts[b]; counts[b] = offset; offset += c; } \
+		for (int i = 0; i < n; i++) dst[counts[(floatSortKey(key(&src[i])) >> shift) & 0xff]++] = src[i]; \
+		type * t = src; src = dst; dst = t; \
+	} \
+	if (src != arr) memcpy(arr, src, n * sizeof(type)); \
+}
+
+DEFINE_FORCE_SORT(sortPointForces, PointForce, pointForceKey)
+DEFINE_FORCE_SORT(sortDistributedStarts, DistributedForce *, distributedStartKey)
+DEFINE_FORCE_SORT(sortDistributedEnds, DistributedForce *, distributedEndKey)
+
+void initSolverContext(SolverContext * ctx)
+{
+	ctx->scratch = (Arena){0};
+	pool_init(&ctx->nodes, &ctx->scratch, sizeof(LL_Node));
+}
+
+void freeSolverContext(SolverContext * ctx)
+{
+	arena_free(&ctx->scratch);
+	pool_init(&ctx->nodes, &ctx->scratch, sizeof(LL_Node));
+}
+
+// Number of times the context had to go to the heap, stops growing once the
+// context has seen the biggest solve
+long solverContextHeapCalls(const SolverContext * ctx)
+{
+	return ctx->scratch.heap_calls;
+}
+
+// Arena space splitIntoSections takes, at most dfCount nodes are in the
+// linked list at once
+size_t sectionsScratchSize(int pfCount, int dfCount)
+{
+	size_t pointForcesSize = arena_align(pfCount * sizeof(PointForce));
+	size_t pointersSize = arena_align(dfCount * sizeof(DistributedForce *));
+	size_t sortTempSize = (pointForcesSize > pointersSize) ? pointForcesSize : pointersSize;
+	return pointForcesSize + 2*pointersSize + sortTempSize + dfCount*arena_align(sizeof(LL_Node));
+}
+
+static bool splitIntoSections(SolverContext * ctx, float beamLength,
+		PointForce pForces[],       int pfCount,
+		DistributedForce dForces[], int dfCount,
+		Section sections[],         int * sectionsCount);
+
+bool seperateBeamIntoSections(float beamLength,
+		PointForce pForces[],       int pfCount, 
+		DistributedForce dForces[], int dfCount, 
+		Section sections[],         int * sectionsCount)
+{
+	SolverContext ctx;
+	initSolverContext(&ctx);
+	bool result = seperateBeamIntoSectionsCtx(&ctx, beamLength,
+			pForces, pfCount, dForces, dfCount, sections, sectionsCount);
+	freeSolverContext(&ctx);
+	return result;
+}
+
 /*
 * Seperate beam into sections
 * Converts an array of point forces and potentially overlapping distributed
 * forces into an array of sections that cover the entire beam
 *
+* ctx: scratch memory, it is reset at the start of every call
 * beamLength: length of the beam, used to cut off sections that go too far or add an "empty" section
 * pForces: array of point forces to be used
 * pfCount: number of elements in pForces
@@ -332,16 +572,35 @@ int compDistributedEndsPtr(const void * a, const void * b)
 * 	it will return false. After all the sections have been found sectionsCount
 * 	is updated to be the amount of sections in the sections array
 */
-bool seperateBeamIntoSections(float beamLength,
+bool seperateBeamIntoSectionsCtx(SolverContext * ctx, float beamLength,
 		PointForce pForces[],       int pfCount, 
 		DistributedForce dForces[], int dfCount, 
 		Section sections[],         int * sectionsCount)
 {
+	arena_reset(&ctx->scratch);
+	pool_reset(&ctx->nodes);
+	if (!arena_reserve(&ctx->scratch, sectionsScratchSize(pfCount, dfCount))) return false;
+	return splitIntoSections(ctx, beamLength, pForces, pfCount, dForces, dfCount, sections, sectionsCount);
+}
 
-	PointForce * pF = pForces;
+// seperateBeamIntoSectionsCtx without the reset, everything comes out of
+// the part of ctx that is already reserved
+static bool splitIntoSections(SolverContext * ctx, float beamLength,
+		PointForce pForces[],       int pfCount,
+		DistributedForce dForces[], int dfCount,
+		Section sections[],         int * sectionsCount)
+{
+	// The point forces are copied so the caller's array is never reordered
+	size_t pointForcesSize = arena_align(pfCount * sizeof(PointForce));
+	size_t pointersSize = arena_align(dfCount * sizeof(DistributedForce *));
+	size_t sortTempSize = (pointForcesSize > pointersSize) ? pointForcesSize : pointersSize;
+
+	PointForce * pF = arena_alloc(&ctx->scratch, pfCount * sizeof(PointForce));
+	if (pfCount > 0) memcpy(pF, pForces, pfCount * sizeof(PointForce));
 	// Make an array of pointers so we can sort them based on ends vs starts
-	DistributedForce ** dFS = malloc(dfCount * sizeof(DistributedForce *));
-	DistributedForce ** dFE = malloc(dfCount * sizeof(DistributedForce *));
+	DistributedForce ** dFS = arena_alloc(&ctx->scratch, dfCount * sizeof(DistributedForce *));
+	DistributedForce ** dFE = arena_alloc(&ctx->scratch, dfCount * sizeof(DistributedForce *));
+	void * sortTemp = arena_alloc(&ctx->scratch, sortTempSize);
 
 	for ( int i = 0; i < dfCount; i++ )
 	{
@@ -353,9 +612,9 @@ bool seperateBeamIntoSections(float beamLength,
 	// do since we know which shoud come next
 	// With this, we can keep a current index for each array and then move
 	// it up once we "use" it
-	qsort( pF , pfCount, sizeof (PointForce), compPointDists );
-	qsort( dFS, dfCount, sizeof (DistributedForce *), compDistributedStartsPtr );
-	qsort( dFE, dfCount, sizeof (DistributedForce *), compDistributedEndsPtr );
+	sortPointForces(pF, pfCount, sortTemp);
+	sortDistributedStarts(dFS, dfCount, sortTemp);
+	sortDistributedEnds(dFE, dfCount, sortTemp);
 
 	int iDS = 0, iDE = 0, iPF = 0; // index of dFS, dFE, pF
 	int iSection = 0;
@@ -371,14 +630,11 @@ bool seperateBeamIntoSections(float beamLength,
 		// control
 		//
 		// A better approach would be appreciated
-        //
-        // BIG WHOOPS HERE!!!
-        // We still get a segfault if there are zero point forces 
 		
         int P_less_S = 0; 
         int P_less_E = 0;
 
-        if (pfCount != 0)
+        if (iPF < pfCount)
         {
             P_less_S = (iDS < dfCount) ? pF[iPF].distance < dFS[iDS]->start : 1;
             P_less_E = (iDE < dfCount) ? pF[iPF].distance < dFE[iDE]->end : 1;
@@ -397,12 +653,13 @@ bool seperateBeamIntoSections(float beamLength,
 			// Sum up linked list
 			LL_SumDistributedPolynomials(head, sections[iSection].polynomial);
 
+			if (iSection+1 >= *sectionsCount) return false;
 			iSection++;
 			sections[iSection].start = pF[iPF].distance;
 			}
 
-			// Save force in section
-			sections[iSection].pointForce = pF[iPF].force;
+			// Save force in section, forces at the same point add up
+			sections[iSection].pointForce += pF[iPF].force;
 			iPF++;
 		} else if (iDS < dfCount && S_less_E)
 		{
@@ -415,12 +672,13 @@ bool seperateBeamIntoSections(float beamLength,
 			// Sum up linked list
 			LL_SumDistributedPolynomials(head, sections[iSection].polynomial);
 
+			if (iSection+1 >= *sectionsCount) return false;
 			iSection++;
 			sections[iSection].start = dFS[iDS]->start;
 			}
 
 			// Push force to linked list
-			LL_push(&head, dFS[iDS]);
+			LL_push_node(&head, pool_alloc(&ctx->nodes), dFS[iDS]);
 			iDS++;
 		} else
 		{
@@ -431,10 +689,11 @@ bool seperateBeamIntoSections(float beamLength,
 			// Sum up linked list
 			LL_SumDistributedPolynomials(head, sections[iSection].polynomial);
 
+			if (iSection+1 >= *sectionsCount) return false;
 			iSection++;
 			sections[iSection].start = dFE[iDE]->end;
 			// Remove force from linked list
-			LL_remove(&head, dFE[iDE]);
+			pool_release(&ctx->nodes, LL_remove(&head, dFE[iDE]));
 			iDE++;
 		}
 	}
@@ -444,17 +703,133 @@ bool seperateBeamIntoSections(float beamLength,
 	if (iSection >= *sectionsCount) return false;
 
 	// make sure sections cover only/entirely the beam
-	if (sections[iSection].start < beamLength) sections[iSection].end = beamLength;
+	if (sections[iSection].start < beamLength || iSection == 0) sections[iSection].end = beamLength;
 	else sections[iSection-1].end = beamLength;
 
     // Since iSection represents the index of the last section, the no. of
     // sections is iSection + 1
 	*sectionsCount = iSection+1;
 
-	free(dFS);
-	free(dFE);
-	LL_free(head);
+	return true;
+}
 
+// Copies src onto the grid and drops the polynomial of pieces without length,
+// a grid piece at the end of the beam may be covered by a longer piece of src
+static void resampleOntoGrid(Section dest[], const float starts[], const float ends[], int gridCount,
+		const Section src[], int count)
+{
+	pw_resample(dest, starts, ends, gridCount, src, count);
+	for (int k = 0; k < gridCount; k++)
+	{
+		if (!(dest[k].end > dest[k].start)) memset(dest[k].polynomial, 0, sizeof(dest[k].polynomial));
+	}
+}
+
+bool seperateLoadsIntoSectionsCtx(SolverContext * ctx, float beamLength,
+		const BeamLoads * loads,
+		Section * channels[LOAD_CHANNELS], int * sectionsCount)
+{
+	const int capacity = *sectionsCount;
+	const int pointsCount[LOAD_CHANNELS] = { loads->pfCount, loads->pmCount, loads->apCount, loads->ptCount };
+	const int distributedCount[LOAD_CHANNELS] = { loads->dfCount, loads->dmCount, loads->adCount, loads->dtCount };
+	bool onlyForces = true;
+	for (int c = LOAD_FORCES+1; c < LOAD_CHANNELS; c++) onlyForces &= pointsCount[c] == 0 && distributedCount[c] == 0;
+	if (onlyForces)
+	{
+		Section * sections = channels[LOAD_FORCES];
+		if (!seperateBeamIntoSectionsCtx(ctx, beamLength,
+					loads->pointForces, loads->pfCount,
+					loads->distributedForces, loads->dfCount,
+					sections, sectionsCount)) return false;
+		for (int c = LOAD_FORCES+1; c < LOAD_CHANNELS; c++)
+			for (int i = 0; i < *sectionsCount; i++) channels[c][i] = (Section){ .start = sections[i].start, .end = sections[i].end };
+		return true;
+	}
+
+	// Every channel is split on its own, as forces, and all of them are put
+	// on the union of their breakpoints. Moments and torques are copied into
+	// forces first
+	const int pointCopies = loads->pmCount + loads->ptCount, distributedCopies = loads->dmCount + loads->dtCount;
+	const size_t sectionsSize = arena_align(capacity * sizeof(Section));
+	const size_t floatsSize = arena_align(capacity * sizeof(float));
+	size_t splitScratch = 0;
+	for (int c = 0; c < LOAD_CHANNELS; c++)
+	{
+		size_t size = sectionsScratchSize(pointsCount[c], distributedCount[c]);
+		if (size > splitScratch) splitScratch = size;
+	}
+	arena_reset(&ctx->scratch);
+	pool_reset(&ctx->nodes);
+	if (!arena_reserve(&ctx->scratch,
+				arena_align(pointCopies * sizeof(PointForce)) + arena_align(distributedCopies * sizeof(DistributedForce))
+				+ LOAD_CHANNELS*sectionsSize + 4*floatsSize + splitScratch)) return false;
+
+	PointForce * pointCopy = arena_alloc(&ctx->scratch, pointCopies * sizeof(PointForce));
+	DistributedForce * distributedCopy = arena_alloc(&ctx->scratch, distributedCopies * sizeof(DistributedForce));
+	Section * split[LOAD_CHANNELS];
+	for (int c = 0; c < LOAD_CHANNELS; c++) split[c] = arena_alloc(&ctx->scratch, capacity * sizeof(Section));
+	float * starts = arena_alloc(&ctx->scratch, capacity * sizeof(float));
+	float * grid = arena_alloc(&ctx->scratch, capacity * sizeof(float));
+	float * merged = arena_alloc(&ctx->scratch, capacity * sizeof(float));
+	float * ends = arena_alloc(&ctx->scratch, capacity * sizeof(float));
+
+	PointForce * points[LOAD_CHANNELS] = { loads->pointForces, pointCopy, loads->axialPointForces, pointCopy + loads->pmCount };
+	DistributedForce * distributed[LOAD_CHANNELS] = {
+		loads->distributedForces, distributedCopy, loads->axialDistributedForces, distributedCopy + loads->dmCount,
+	};
+	for (int i = 0; i < loads->pmCount; i++) points[LOAD_MOMENTS][i] = (PointForce){ loads->pointMoments[i].distance, loads->pointMoments[i].moment };
+	for (int i = 0; i < loads->ptCount; i++) points[LOAD_TORQUES][i] = (PointForce){ loads->pointTorques[i].distance, loads->pointTorques[i].moment };
+	for (int i = 0; i < loads->dmCount; i++)
+	{
+		DistributedForce * copy = &distributed[LOAD_MOMENTS][i];
+		*copy = (DistributedForce){ .start = loads->distributedMoments[i].start, .end = loads->distributedMoments[i].end };
+		memcpy(copy->polynomial, loads->distributedMoments[i].polynomial, sizeof(copy->polynomial));
+	}
+	for (int i = 0; i < loads->dtCount; i++)
+	{
+		DistributedForce * copy = &distributed[LOAD_TORQUES][i];
+		*copy = (DistributedForce){ .start = loads->distributedTorques[i].start, .end = loads->distributedTorques[i].end };
+		memcpy(copy->polynomial, loads->distributedTorques[i].polynomial, sizeof(copy->polynomial));
+	}
+
+	// The splits take their scratch from the same spot, everything they
+	// leave behind is in the sections. The forces are always split, they
+	// give the sections of an unloaded beam
+	const size_t mark = ctx->scratch.used;
+	int splitCount[LOAD_CHANNELS] = {0};
+	int count = 0;
+	for (int c = 0; c < LOAD_CHANNELS; c++)
+	{
+		if (c != LOAD_FORCES && pointsCount[c] == 0 && distributedCount[c] == 0) continue;
+		ctx->scratch.used = mark;
+		pool_reset(&ctx->nodes);
+		splitCount[c] = capacity;
+		for (int i = 0; i < capacity; i++) split[c][i] = (Section){0};
+		if (!splitIntoSections(ctx, beamLength, points[c], pointsCount[c], distributed[c], distributedCount[c],
+					split[c], &splitCount[c])) return false;
+
+		for (int i = 0; i < splitCount[c]; i++) starts[i] = split[c][i].start;
+		count = pw_merge_breakpoints(merged, capacity, grid, count, starts, splitCount[c]);
+		if (count < 0) return false;
+		float * swap = grid;
+		grid = merged;
+		merged = swap;
+	}
+
+	// Same rule as splitIntoSections, a section that starts at the end of
+	// the beam only carries its point values
+	for (int k = 0; k < count; k++)
+	{
+		if (!(grid[k] < beamLength)) ends[k] = 0;
+		else if (k < count-1) ends[k] = (grid[k+1] < beamLength) ? grid[k+1] : beamLength;
+		else ends[k] = beamLength;
+	}
+	for (int c = 0; c < LOAD_CHANNELS; c++)
+	{
+		if (splitCount[c] > 0) resampleOntoGrid(channels[c], grid, ends, count, split[c], splitCount[c]);
+		else for (int k = 0; k < count; k++) channels[c][k] = (Section){ .start = grid[k], .end = ends[k] };
+	}
+	*sectionsCount = count;
 	return true;
 }
 
@@ -483,133 +858,339 @@ void printPolynomial(float p[MAX_POLYNOMIAL_DEGREE])
  */
 float calculateWallReactionMoment(Section sections[], int sectionsCount)
 {
-	float pointSum = 0;
-	float distributedSum = 0;
-	float integrated[MAX_POLYNOMIAL_DEGREE];
-
-	for ( int i = 0; i < sectionsCount; i++ )
-	{
-		pointSum += sections[i].pointForce * sections[i].start;
-		
-		integratePolynomial(integrated, sections[i].polynomial);
-		float integral = evalPolynomial(sections[i].end, integrated) - evalPolynomial(sections[i].start, integrated);
-		distributedSum += integral * (sections[i].start + sections[i].end)/2;
-	}
-	return -(pointSum + distributedSum);
+	// The load acts at its centroid, not the middle of the section, so this
+	// is the integral of x*w(x)
+	return -pw_first_moment(sections, sectionsCount);
 }
 
 float calculateWallReactionForce(Section sections[], int sectionsCount)
 {
 	// Prefer to do calculate wall reaction force using sections because it
 	// ensures that we dont consider forces longer than the beam
+	return pw_total(sections, sectionsCount);
+}
 
-	float pointSum = 0;
-	float distributedSum = 0;
-	float integrated[MAX_POLYNOMIAL_DEGREE];
+float evalPolynomial(float x, const float poly[MAX_POLYNOMIAL_DEGREE])
+{
+	return poly_eval(poly, x);
+}
 
-	for (int i = 0; i < sectionsCount; i++)
-	{
-		pointSum += sections[i].pointForce;
-		integratePolynomial(integrated, sections[i].polynomial);
+void integratePolynomial(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE])
+{
+	poly_integrate(dest, src);
+}
 
-		distributedSum += evalPolynomial(sections[i].end, integrated) - evalPolynomial(sections[i].start, integrated);
-	}
-	return pointSum + distributedSum;
+BeamSupports effectiveSupports(BeamSupports supports)
+{
+	if (supports.left == SUPPORT_DEFAULT) supports.left = SUPPORT_FIXED;
+	if (supports.right == SUPPORT_DEFAULT) supports.right = SUPPORT_FREE;
+	return supports;
 }
 
-float evalPolynomial(float x, float poly[MAX_POLYNOMIAL_DEGREE])
+const char * supportName(SupportKind kind)
 {
-	float answer = 0;
-	for (int i = 0; i < MAX_POLYNOMIAL_DEGREE; i++)
-	{
-		answer += poly[i] * pow(x, i);
+	switch (kind) {
+	case SUPPORT_DEFAULT: return "default";
+	case SUPPORT_FREE: return "free";
+	case SUPPORT_PIN: return "pin";
+	case SUPPORT_ROLLER: return "roller";
+	case SUPPORT_FIXED: return "fixed";
+	case SUPPORT_KINDS_COUNT: break;
 	}
+	return "unknown";
+}
 
-	return answer;
+// ====================== SUPPORT KERNELS ===============================
+// Every pair of end supports has a closed form for the reactions at x = 0
+// in terms of the load integrals I[k] = integral of x^k q(x) (point forces
+// included). With EI constant the indeterminate ones come from the
+// deflection conditions:
+//  v(L)  = 0: J = (L^3 I0 - 3L^2 I1 + 3L I2 - I3)/6
+//  v'(L) = 0: P = (L^2 I0 - 2L I1 + I2)/2
+//  x*M integrates to 0: K = L^3 I0/3 - L^2 I1/2 + I3/6
+typedef void SupportKernel(double L, const double I[4], double * force, double * moment);
+
+static void reactionsCantilever(double L, const double I[4], double * force, double * moment)
+{
+	(void) L;
+	*force = I[0];
+	*moment = -I[1];
+}
+static void reactionsCantileverRight(double L, const double I[4], double * force, double * moment)
+{
+	(void) L; (void) I;
+	*force = 0;
+	*moment = 0;
+}
+static void reactionsSimple(double L, const double I[4], double * force, double * moment)
+{
+	*force = I[0] - I[1]/L;
+	*moment = 0;
+}
+static void reactionsPropped(double L, const double I[4], double * force, double * moment)
+{
+	double J = (L*L*L*I[0] - 3*L*L*I[1] + 3*L*I[2] - I[3]) / 6;
+	*force = 3*((L*I[0] - I[1])*L*L/2 - J) / (L*L*L);
+	*moment = L*I[0] - I[1] - *force*L;
+}
+static void reactionsProppedRight(double L, const double I[4], double * force, double * moment)
+{
+	double K = L*L*L*I[0]/3 - L*L*I[1]/2 + I[3]/6;
+	*force = 3*K / (L*L*L);
+	*moment = 0;
+}
+static void reactionsFixedFixed(double L, const double I[4], double * force, double * moment)
+{
+	double P = (L*L*I[0] - 2*L*I[1] + I[2]) / 2;
+	double K = L*L*L*I[0]/3 - L*L*I[1]/2 + I[3]/6;
+	*force = 12*(K - P*L/2) / (L*L*L);
+	*moment = (P - *force*L*L/2) / L;
 }
 
-void integratePolynomial(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE])
+typedef enum { END_FREE, END_PIN, END_FIXED, END_KINDS } EndKind;
+static EndKind endKind(SupportKind kind)
 {
-	// NOTE: if the src polynomial has a degree of MAX_POLYNOMIAL_DEGREE,
-	// that term will not be able to be integrated
-	// Make sure that MAX_POLYNOMIAL_DEGREE is always one higher than the
-	// highest degree in src
-	for (int i = 1; i < MAX_POLYNOMIAL_DEGREE; i++)
-	{
-		dest[i] = src[i-1]/(float)i;
-	}
-	dest[0] = 0.0f;
+	if (kind == SUPPORT_FIXED) return END_FIXED;
+	if (kind == SUPPORT_PIN || kind == SUPPORT_ROLLER) return END_PIN;
+	return END_FREE;
 }
+// [left][right], NULL where the beam can move. solveReactions still takes
+// the cantilever (fixed, free) straight from the sections
+static SupportKernel * const supportKernels[END_KINDS][END_KINDS] = {
+	[END_FREE]  = { [END_FIXED] = reactionsCantileverRight },
+	[END_PIN]   = { [END_PIN] = reactionsSimple, [END_FIXED] = reactionsProppedRight },
+	[END_FIXED] = { [END_FREE] = reactionsCantilever, [END_PIN] = reactionsPropped, [END_FIXED] = reactionsFixedFixed },
+};
 
-// NOTE: there is a lot of overlap between solveShearSections and
-// solveMomentSections, would be good to find a way to generalize this a bit
-void solveShearSections(Section shear[], Section raw[], int count)
+bool supportsHoldBeam(BeamSupports supports)
 {
-	float wallReactionForce = calculateWallReactionForce(raw, count);
+	supports = effectiveSupports(supports);
+	return supportKernels[endKind(supports.left)][endKind(supports.right)] != NULL;
+}
 
-	for (int i = 0; i < count; i++)
-	{
-		shear[i].start = raw[i].start;
-		shear[i].end = raw[i].end;
+/*
+ * Reactions at both ends from the load integrals I[k] = integral of x^k q(x)
+ *
+ * Parameters:
+ *  [out]reactions[]: force and moment at x = 0, then force and moment at
+ *      x = length, in the same sense as the Beam fields
+ *
+ * Return:
+ *  bool: false when the supports do not hold the beam in place, or when
+ *      they need a length to share the load over and the beam has none
+ */
+bool supportReactions(BeamSupports supports, double length, const double I[4], double reactions[4])
+{
+	supports = effectiveSupports(supports);
+	SupportKernel * kernel = supportKernels[endKind(supports.left)][endKind(supports.right)];
+	if (kernel == NULL) return false;
+	// Every kernel but the cantilever divides by the length
+	if (kernel != reactionsCantilever && !(length > 0)) return false;
+
+	const double L = length;
+	double force, moment;
+	kernel(L, I, &force, &moment);
+	reactions[0] = force;
+	reactions[1] = moment;
+	reactions[2] = I[0] - force;
+	reactions[3] = moment + force*L - L*I[0] + I[1];
+	return true;
+}
 
-		integratePolynomial(shear[i].polynomial, raw[i].polynomial);
+/*
+ * Fill in the reactions at both ends of a beam whose raw sections are solved
+ *
+ * Return:
+ *  bool: false when the supports do not hold the beam in place (free-free,
+ *      a pin with a free end)
+ */
+bool solveReactions(Beam * beam)
+{
+	const BeamSupports supports = effectiveSupports(beam->supports);
+	const EndKind left = endKind(supports.left), right = endKind(supports.right);
+	const Section * raws = beam->raws;
+	const int count = beam->sections_count;
 
-		for (int j = 0; j < MAX_POLYNOMIAL_DEGREE; j++) shear[i].polynomial[j] *= -1;
+	const Section * applied = beam->applied_moments;
 
-		if (i == 0) shear[i].polynomial[0] = wallReactionForce - raw[0].pointForce;
-		else 
+	if (left == END_FIXED && right == END_FREE)
+	{
+		beam->wall_reaction_force = calculateWallReactionForce(beam->raws, count);
+		beam->wall_reaction_moment = calculateWallReactionMoment(beam->raws, count) - pw_total(applied, count);
+		beam->end_reaction_force = 0;
+		beam->end_reaction_moment = 0;
+		return true;
+	}
+	double I[4] = {0};
+	for (int i = 0; i < count; i++)
+	{
+		double x = raws[i].start, power = 1;
+		for (int k = 0; k < 4; k++)
+		{
+			I[k] += raws[i].pointForce * power;
+			if (raws[i].end > raws[i].start) I[k] += poly_integral_weighted(raws[i].polynomial, k, raws[i].start, raws[i].end);
+			power *= x;
+		}
+		// A moment is the limit of a pair of opposite forces, its integral
+		// against x^k is k times the moment against x^(k-1)
+		power = 1;
+		for (int k = 1; k < 4; k++)
 		{
-			float previous = evalPolynomial(shear[i-1].end, shear[i-1].polynomial);
-			float current = evalPolynomial(shear[i].start, shear[i].polynomial);
-			float point = raw[i].pointForce;
-			shear[i].polynomial[0] =  previous - current - point;
+			I[k] += k * applied[i].pointForce * power;
+			if (raws[i].end > raws[i].start) I[k] += k * poly_integral_weighted(applied[i].polynomial, k-1, raws[i].start, raws[i].end);
+			power *= x;
 		}
 	}
+
+	double reactions[4];
+	if (!supportReactions(supports, beam->length, I, reactions)) return false;
+	beam->wall_reaction_force = reactions[0];
+	beam->wall_reaction_moment = reactions[1];
+	beam->end_reaction_force = reactions[2];
+	beam->end_reaction_moment = reactions[3];
+	return true;
 }
 
-void solveMomentSections(Section moment[], Section shear[], Section raw[], int count)
-{
-	float wallReactionMoment = -calculateWallReactionMoment(raw, count);
+// Ends that hold the beam along its axis and against twisting. A roller
+// slides, pins and rollers hold the twist like fork supports do
+static bool holdsAxial(SupportKind kind) { return kind == SUPPORT_PIN || kind == SUPPORT_FIXED; }
+static bool holdsTorsion(SupportKind kind) { return kind != SUPPORT_FREE; }
 
+/*
+ * Axial force or torque in the beam at x = 0 from the loads of its channel.
+ * Held at both ends it is indeterminate: with EA (or GJ) constant the ends
+ * do not move apart, so the diagram integrates to 0 over the beam
+ *
+ * Return:
+ *  bool: false when neither end holds the beam and the loads do not balance
+ */
+static bool channelReaction(bool left, bool right, float length, const Section loads[], int count, float * value)
+{
+	double I0 = 0, I1 = 0;
 	for (int i = 0; i < count; i++)
 	{
-		moment[i].start = shear[i].start;
-		moment[i].end = shear[i].end;
- 
- 		integratePolynomial(moment[i].polynomial, shear[i].polynomial);
+		I0 += loads[i].pointForce;
+		I1 += (double)loads[i].pointForce * loads[i].start;
+		if (!(loads[i].end > loads[i].start)) continue;
+		I0 += poly_integral_weighted(loads[i].polynomial, 0, loads[i].start, loads[i].end);
+		I1 += poly_integral_weighted(loads[i].polynomial, 1, loads[i].start, loads[i].end);
+	}
+	if (left && right && !(length > 0)) return false;
+	if (left && right) *value = I0 - I1/length;
+	else if (left) *value = I0;
+	else *value = 0;
+	return left || right || nearly_equal(I0, 0);
+}
 
-		if (i == 0) moment[i].polynomial[0] = -wallReactionMoment;
-		else 
-		{
-			float previous = evalPolynomial(moment[i-1].end, moment[i-1].polynomial);
-			float current = evalPolynomial(moment[i].start, moment[i].polynomial);
-			//TODO: make point moments
-			moment[i].polynomial[0] =  previous - current;
-		}
+/*
+ * Fill in the axial force and torque at x = 0 of a beam whose channels are
+ * split into sections
+ *
+ * Return:
+ *  bool: false when the axial loads or torques move the beam as a whole
+ */
+bool solveAxialReactions(Beam * beam)
+{
+	const BeamSupports supports = effectiveSupports(beam->supports);
+	const int count = beam->sections_count;
+	return channelReaction(holdsAxial(supports.left), holdsAxial(supports.right),
+				beam->length, beam->applied_axial, count, &beam->wall_reaction_axial)
+		&& channelReaction(holdsTorsion(supports.left), holdsTorsion(supports.right),
+				beam->length, beam->applied_torques, count, &beam->wall_reaction_torque);
+}
+// ======================================================================
+
+// Shear is minus the integral of the load, starting at the reaction at
+// x = 0. Every point force is a step down
+void solveShearSections(Section shear[], const Section raw[], int count, float leftReactionForce)
+{
+	pw_integrate(shear, raw, count, -1, leftReactionForce);
+}
+
+// Moment is the integral of the shear plus the distributed moments, starting
+// at the moment at x = 0. A point moment is a point value of applied, so it
+// becomes a step in the integral like a point force does in the shear
+void solveMomentSections(Section moment[], const Section shear[], const Section applied[], int count, float leftMoment)
+{
+	memcpy(moment, shear, count * sizeof(Section));
+	pw_add(moment, applied, count);
+	pw_integrate(moment, moment, count, 1, leftMoment);
+}
+
+// Shear, moment, axial force and torque of a beam with its reactions solved,
+// all four in one pass over the sections. Every diagram comes out the same
+// as integrating it on its own: N' = -axial load and T' = -torque, like V
+void solveSectionDiagrams(Beam * beam)
+{
+	for (int i = 0; i < beam->sections_count; i++)
+	{
+		const bool first = i == 0;
+		pw_integrate_piece(&beam->shears[i], &beam->raws[i], first ? NULL : &beam->shears[i-1],
+				-1, beam->wall_reaction_force);
+		// See solveMomentSections
+		Section slope = beam->shears[i];
+		slope.pointForce += beam->applied_moments[i].pointForce;
+		poly_add(slope.polynomial, beam->applied_moments[i].polynomial);
+		pw_integrate_piece(&beam->moments[i], &slope, first ? NULL : &beam->moments[i-1],
+				1, beam->wall_reaction_moment);
+		pw_integrate_piece(&beam->axials[i], &beam->applied_axial[i], first ? NULL : &beam->axials[i-1],
+				-1, beam->wall_reaction_axial);
+		pw_integrate_piece(&beam->torques[i], &beam->applied_torques[i], first ? NULL : &beam->torques[i-1],
+				-1, beam->wall_reaction_torque);
 	}
 }
 /* 
  * Solve for the shear and moment sections of the beam
  *
  * Parameters:
- *  [out]beam:  pointer to beam whose sections will get modified, sections and
- *      sections_count get reset before updating them
+ *  [in,out]beam:  pointer to beam whose sections will get modified, sections and
+ *      sections_count get reset before updating them. Its length and
+ *      supports are read
  *  [in]pointForces[]: array of point forces acting on beam
  *  [in]pfCount: number of pointforces
  *  [in]distributedForces[]: array of distributed forces acting on beam
  *  [in]pfCount: number of distributed forces
  *
  * Return:
- *  bool: false on fail (right now its only when we cannot seperate sections)
+ *  bool: false on fail (when we cannot seperate sections or the supports
+ *      do not hold the beam)
 */
 bool solveBeam(Beam * beam,
 		PointForce pointForces[], int pfCount,
 		DistributedForce distributedForces[], int dfCount)
+{
+	SolverContext ctx;
+	initSolverContext(&ctx);
+	bool result = solveBeamCtx(&ctx, beam, pointForces, pfCount, distributedForces, dfCount);
+	freeSolverContext(&ctx);
+	return result;
+}
+
+// Same as solveBeam but all scratch memory comes from ctx
+bool solveBeamCtx(SolverContext * ctx, Beam * beam,
+		PointForce pointForces[], int pfCount,
+		DistributedForce distributedForces[], int dfCount)
+{
+	BeamLoads loads = {
+		.pointForces = pointForces, .pfCount = pfCount,
+		.distributedForces = distributedForces, .dfCount = dfCount,
+	};
+	return solveBeamLoads(ctx, beam, &loads);
+}
+
+// Same as solveBeamCtx with applied moments as well
+bool solveBeamLoads(SolverContext * ctx, Beam * beam, const BeamLoads * loads)
 {
 	Section * rawSections = beam->raws;
 	Section * shearSections = beam->shears;
 	Section * momentSections = beam->moments;
 	float beamLength = beam->length;
+	Section * channels[LOAD_CHANNELS] = {
+		[LOAD_FORCES] = rawSections,
+		[LOAD_MOMENTS] = beam->applied_moments,
+		[LOAD_AXIAL] = beam->applied_axial,
+		[LOAD_TORQUES] = beam->applied_torques,
+	};
 
     // Need to make sure the beam sections are cleared before we do calculations
     beam->sections_count = MAX_SECTIONS;
@@ -618,23 +1199,22 @@ bool solveBeam(Beam * beam,
         rawSections[i] = (Section){0};
         shearSections[i] = (Section){0};
         momentSections[i] = (Section){0};
+        beam->axials[i] = (Section){0};
+        beam->torques[i] = (Section){0};
+        for (int c = LOAD_MOMENTS; c < LOAD_CHANNELS; c++) channels[c][i] = (Section){0};
     }
 
-    if (!seperateBeamIntoSections(
-                beamLength, 
-                pointForces, pfCount,
-                distributedForces, dfCount, 
-                rawSections, &beam->sections_count)
+    if (!seperateLoadsIntoSectionsCtx(
+                ctx, beamLength, loads,
+                channels, &beam->sections_count)
         )
 	{
 		// ERROR: forces result in too many sections (number of sections > allocated sections)
 		return false;
 	}
-	int sectionsCount = beam->sections_count;
-    beam->wall_reaction_force = calculateWallReactionForce(rawSections, sectionsCount);
-    beam->wall_reaction_moment = calculateWallReactionMoment(rawSections, sectionsCount);
-	solveShearSections(shearSections, rawSections, sectionsCount);
-	solveMomentSections(momentSections, shearSections, rawSections, sectionsCount);
+	// ERROR: the supports do not hold the beam
+	if (!solveReactions(beam) || !solveAxialReactions(beam)) return false;
+	solveSectionDiagrams(beam);
 	return true;
 }
 
@@ -0,0 +1,347 @@
+#ifndef SOMP_POLY_H
+#define SOMP_POLY_H
+
+/*
+* Filename:	somp_poly.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Polynomial and piecewise polynomial kernels the solver, superposition and
+* the diagrams are built on. A polynomial is MAX_POLYNOMIAL_DEGREE floats,
+* p[k] the coefficient of x^k with x in beam coordinates. A piecewise
+* polynomial is a sorted array of touching Sections, the pointForce of a
+* section is a concentrated value at its start, so integrating it makes a
+* jump
+*
+* Integrating drops the highest term, see poly_integrate. The solver only
+* integrates twice so loads have to stay at most MAX_POLYNOMIAL_DEGREE-3
+* degree
+*/
+
+#include <stdbool.h>
+#include <float.h>
+#include <math.h>
+#include "utils.h"
+
+#define MAX_POLYNOMIAL_DEGREE 4
+
+struct Section
+{
+	float start;
+	float end;
+	float pointForce;
+	float polynomial[MAX_POLYNOMIAL_DEGREE];
+};
+typedef struct Section Section;
+
+// ====================== POLYNOMIALS ===================================
+float poly_eval(const float p[MAX_POLYNOMIAL_DEGREE], float x);
+// xs and out can not overlap
+void poly_eval_many(const float p[MAX_POLYNOMIAL_DEGREE], const float * restrict xs, float * restrict out, int count);
+void poly_add(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE]);
+void poly_scale(float p[MAX_POLYNOMIAL_DEGREE], float factor);
+// dest[i] += factor*src[i] for count floats, any number of polynomials
+// stored back to back
+void poly_axpy(float dest[], float factor, const float src[], int count);
+void poly_integrate(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE]);
+void poly_differentiate(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE]);
+// Integral of p (and of x*p) from a to b, with the same terms poly_integrate keeps
+float poly_integral(const float p[MAX_POLYNOMIAL_DEGREE], float a, float b);
+float poly_first_moment(const float p[MAX_POLYNOMIAL_DEGREE], float a, float b);
+// Integral of x^power * p from a to b with every term kept, in double
+double poly_integral_weighted(const float p[MAX_POLYNOMIAL_DEGREE], int power, float a, float b);
+// Straight line through (ax, ay) and (bx, by)
+void poly_line(float p[MAX_POLYNOMIAL_DEGREE], float ax, float ay, float bx, float by);
+// ======================================================================
+// ====================== PIECEWISE =====================================
+// Integral over all pieces, point values included
+float pw_total(const Section pieces[], int count);
+// Integral of x*f over all pieces, point values included
+float pw_first_moment(const Section pieces[], int count);
+// dest = scale * integral of src, starting at initial. Every piece starts
+// where the one before ended plus scale times its point value. dest can be src
+void pw_integrate(Section dest[], const Section src[], int count, float scale, float initial);
+// One piece of pw_integrate, it carries on from the end of previous (the
+// piece before it in dest) or from initial when previous is NULL. Lets a
+// sweep integrate several piecewise polynomials side by side
+void pw_integrate_piece(Section * dest, const Section * src, const Section * previous, float scale, float initial);
+// Point values are lost, their derivative is not a polynomial
+void pw_differentiate(Section dest[], const Section src[], int count);
+void pw_scale(Section pieces[], int count, float factor);
+// Pieces with the same breakpoints
+void pw_add(Section dest[], const Section src[], int count);
+// x is on a breakpoint when it is the same float give or take a few ULP.
+// Unlike nearly_equal this does not reach out EPSILON around it, a query
+// close to a breakpoint stays on its own side
+static inline bool pw_on_breakpoint(float start, float x)
+{
+	return fabsf(start - x) <= 4*FLT_EPSILON*fmaxf(fabsf(start), fabsf(x));
+}
+// Returns: index of the last piece that starts at or before x (see
+// pw_on_breakpoint), 0 when x is before all of them
+int pw_find(const Section pieces[], int count, float x);
+// samples values evenly spaced from x0 to x1 (both included) in one walk
+// over the pieces. At a breakpoint the piece on the left is used
+void pw_sample(const Section pieces[], int count, float x0, float x1, float out[], int samples);
+// Copies src onto a finer grid of pieces (one that has every breakpoint of
+// src), point values only go to the grid piece that starts at them
+void pw_resample(Section dest[], const float starts[], const float ends[], int gridCount,
+		const Section src[], int count);
+// The pieces of src that overlap [a, b], cut to [a, b]
+// Returns: number of pieces in dest, -1 when more than capacity
+int pw_restrict(Section dest[], int capacity, const Section src[], int count, float a, float b);
+// Sorted union of two sorted breakpoint lists, breakpoints closer than
+// EPSILON become one
+// Returns: number of breakpoints in out, -1 when more than capacity
+int pw_merge_breakpoints(float out[], int capacity, const float a[], int aCount, const float b[], int bCount);
+// ======================================================================
+
+#ifdef SOMP_POLY_IMPLEMENTATION
+
+#include <string.h>
+
+float poly_eval(const float p[MAX_POLYNOMIAL_DEGREE], float x)
+{
+	float value = p[MAX_POLYNOMIAL_DEGREE-1];
+	for (int k = MAX_POLYNOMIAL_DEGREE-2; k >= 0; k--) value = value*x + p[k];
+	return value;
+}
+
+// Coefficient at a time over all xs so the inner loop vectorizes
+void poly_eval_many(const float p[MAX_POLYNOMIAL_DEGREE], const float * restrict xs, float * restrict out, int count)
+{
+	for (int i = 0; i < count; i++) out[i] = p[MAX_POLYNOMIAL_DEGREE-1];
+	for (int k = MAX_POLYNOMIAL_DEGREE-2; k >= 0; k--)
+	{
+		const float c = p[k];
+		for (int i = 0; i < count; i++) out[i] = out[i]*xs[i] + c;
+	}
+}
+
+void poly_add(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE])
+{
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++) dest[k] += src[k];
+}
+
+void poly_scale(float p[MAX_POLYNOMIAL_DEGREE], float factor)
+{
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++) p[k] *= factor;
+}
+
+void poly_axpy(float dest[], float factor, const float src[], int count)
+{
+	for (int i = 0; i < count; i++) dest[i] += factor*src[i];
+}
+
+void poly_integrate(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE])
+{
+	// NOTE: the highest term of src has nowhere to go, so it is dropped.
+	// MAX_POLYNOMIAL_DEGREE has to stay higher than anything integrated
+	for (int k = MAX_POLYNOMIAL_DEGREE-1; k >= 1; k--) dest[k] = src[k-1]/(float)k;
+	dest[0] = 0.0f;
+}
+
+void poly_differentiate(float dest[MAX_POLYNOMIAL_DEGREE], const float src[MAX_POLYNOMIAL_DEGREE])
+{
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE-1; k++) dest[k] = src[k+1]*(k+1);
+	dest[MAX_POLYNOMIAL_DEGREE-1] = 0.0f;
+}
+
+float poly_integral(const float p[MAX_POLYNOMIAL_DEGREE], float a, float b)
+{
+	float integrated[MAX_POLYNOMIAL_DEGREE];
+	poly_integrate(integrated, p);
+	return poly_eval(integrated, b) - poly_eval(integrated, a);
+}
+
+float poly_first_moment(const float p[MAX_POLYNOMIAL_DEGREE], float a, float b)
+{
+	// x*p integrated has a term more than p, leave out the one
+	// poly_integrate would drop so the force and the moment agree
+	float sum = 0;
+	float powerA = a*a, powerB = b*b;
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE-1; k++)
+	{
+		sum += p[k] * (powerB - powerA) / (k+2);
+		powerA *= a;
+		powerB *= b;
+	}
+	return sum;
+}
+
+double poly_integral_weighted(const float p[MAX_POLYNOMIAL_DEGREE], int power, float a, float b)
+{
+	double powerA = a, powerB = b;
+	for (int k = 0; k < power; k++)
+	{
+		powerA *= a;
+		powerB *= b;
+	}
+	double sum = 0;
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+	{
+		sum += p[k] * (powerB - powerA) / (k + power + 1);
+		powerA *= a;
+		powerB *= b;
+	}
+	return sum;
+}
+
+void poly_line(float p[MAX_POLYNOMIAL_DEGREE], float ax, float ay, float bx, float by)
+{
+	memset(p, 0, MAX_POLYNOMIAL_DEGREE*sizeof(float));
+	line_from_points(&p[1], &p[0], ax, ay, bx, by);
+}
+
+float pw_total(const Section pieces[], int count)
+{
+	float pointSum = 0;
+	float distributedSum = 0;
+	for (int i = 0; i < count; i++)
+	{
+		pointSum += pieces[i].pointForce;
+		distributedSum += poly_integral(pieces[i].polynomial, pieces[i].start, pieces[i].end);
+	}
+	return pointSum + distributedSum;
+}
+
+float pw_first_moment(const Section pieces[], int count)
+{
+	float pointSum = 0;
+	float distributedSum = 0;
+	for (int i = 0; i < count; i++)
+	{
+		pointSum += pieces[i].pointForce * pieces[i].start;
+		distributedSum += poly_first_moment(pieces[i].polynomial, pieces[i].start, pieces[i].end);
+	}
+	return pointSum + distributedSum;
+}
+
+void pw_integrate(Section dest[], const Section src[], int count, float scale, float initial)
+{
+	for (int i = 0; i < count; i++) pw_integrate_piece(&dest[i], &src[i], (i > 0) ? &dest[i-1] : NULL, scale, initial);
+}
+
+void pw_integrate_piece(Section * dest, const Section * src, const Section * previous, float scale, float initial)
+{
+	const float point = src->pointForce;
+	dest->start = src->start;
+	dest->end = src->end;
+	dest->pointForce = 0;
+	poly_integrate(dest->polynomial, src->polynomial);
+	poly_scale(dest->polynomial, scale);
+
+	float value = (previous != NULL) ? poly_eval(previous->polynomial, previous->end) : initial;
+	value += scale*point;
+	dest->polynomial[0] = value - poly_eval(dest->polynomial, dest->start);
+}
+
+void pw_differentiate(Section dest[], const Section src[], int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		dest[i].start = src[i].start;
+		dest[i].end = src[i].end;
+		dest[i].pointForce = 0;
+		poly_differentiate(dest[i].polynomial, src[i].polynomial);
+	}
+}
+
+void pw_scale(Section pieces[], int count, float factor)
+{
+	for (int i = 0; i < count; i++)
+	{
+		pieces[i].pointForce *= factor;
+		poly_scale(pieces[i].polynomial, factor);
+	}
+}
+
+void pw_add(Section dest[], const Section src[], int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		dest[i].pointForce += src[i].pointForce;
+		poly_add(dest[i].polynomial, src[i].polynomial);
+	}
+}
+
+int pw_find(const Section pieces[], int count, float x)
+{
+	// The starts are sorted, binary search for the last one at or before x
+	int low = 0, high = count - 1;
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+		if (pieces[mid].start <= x || pw_on_breakpoint(pieces[mid].start, x)) low = mid;
+		else high = mid - 1;
+	}
+	return low;
+}
+
+void pw_sample(const Section pieces[], int count, float x0, float x1, float out[], int samples)
+{
+	if (count <= 0) return;
+	const float step = (samples > 1) ? (x1 - x0)/(samples - 1) : 0;
+	int piece = 0;
+	for (int i = 0; i < samples; i++)
+	{
+		const float x = x0 + i*step;
+		while (piece < count-1 && x > pieces[piece].end) piece++;
+		out[i] = poly_eval(pieces[piece].polynomial, x);
+	}
+}
+
+void pw_resample(Section dest[], const float starts[], const float ends[], int gridCount,
+		const Section src[], int count)
+{
+	int j = 0;
+	for (int k = 0; k < gridCount; k++)
+	{
+		// Both are sorted, so the covering piece only moves forward
+		while (j+1 < count && (src[j+1].start <= starts[k] || nearly_equal(src[j+1].start, starts[k]))) j++;
+
+		dest[k].start = starts[k];
+		dest[k].end = ends[k];
+		dest[k].pointForce = nearly_equal(src[j].start, starts[k]) ? src[j].pointForce : 0;
+		memcpy(dest[k].polynomial, src[j].polynomial, sizeof(dest[k].polynomial));
+	}
+}
+
+int pw_restrict(Section dest[], int capacity, const Section src[], int count, float a, float b)
+{
+	int n = 0;
+	for (int i = 0; i < count; i++)
+	{
+		// A piece without length only matters for its point value
+		float end = (src[i].end > src[i].start) ? src[i].end : src[i].start;
+		if (end < a || src[i].start > b) continue;
+		if (end == a && src[i].end > src[i].start) continue;
+		if (n >= capacity) return -1;
+
+		dest[n] = src[i];
+		if (src[i].start < a)
+		{
+			dest[n].start = a;
+			dest[n].pointForce = 0;
+		}
+		if (src[i].end > b) dest[n].end = b;
+		n++;
+	}
+	return n;
+}
+
+int pw_merge_breakpoints(float out[], int capacity, const float a[], int aCount, const float b[], int bCount)
+{
+	int n = 0, i = 0, j = 0;
+	while (i < aCount || j < bCount)
+	{
+		float next = (j >= bCount || (i < aCount && a[i] <= b[j])) ? a[i++] : b[j++];
+		if (n > 0 && nearly_equal(next, out[n-1])) continue;
+		if (n >= capacity) return -1;
+		out[n++] = next;
+	}
+	return n;
+}
+
+#endif // SOMP_POLY_IMPLEMENTATION
+#endif // SOMP_POLY_H
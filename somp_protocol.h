@@ -0,0 +1,273 @@
+#ifndef SOMP_PROTOCOL_H
+#define SOMP_PROTOCOL_H
+
+/*
+* Filename:	somp_protocol.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Binary request/response protocol of the solver daemon (somp_daemon.c).
+* Every message is a frame: a uint32 payload length followed by the
+* payload. Both ends are on the same machine so everything is in host byte
+* order and the forces and sections are sent as the structs themselves
+*
+* Request:  SompRequestHeader, pfCount PointForce, dfCount DistributedForce
+* Response: SompResponseHeader, then sectionsCount Section for the loads,
+*           the shear and the moment (only when status is SOMP_STATUS_OK)
+*
+* Both headers start with their magic and SOMP_PROTOCOL_VERSION. A request
+* of another version gets SOMP_STATUS_BAD_VERSION back, a response of
+* another version does not decode. Version 2 added the supports to the
+* request and the reactions at the end of the beam to the response
+*
+* Responses come back in the order the requests were sent, a client can
+* send many requests before reading any response
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "somp_logic.h"
+
+#define SOMP_PROTOCOL_VERSION 2
+#define SOMP_REQUEST_MAGIC  0x51504d53 // "SMPQ"
+#define SOMP_RESPONSE_MAGIC 0x52504d53 // "SMPR"
+// Bigger frames close the connection, they cannot be a sane beam
+#define SOMP_MAX_FRAME (1 << 20)
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t id; // echoed in the response
+	float length;
+	uint32_t pfCount;
+	uint32_t dfCount;
+	int32_t leftSupport;  // SupportKind, 0 for both keeps the cantilever
+	int32_t rightSupport;
+} SompRequestHeader;
+
+typedef enum {
+	SOMP_STATUS_OK = 0,
+	SOMP_STATUS_BAD_REQUEST,
+	SOMP_STATUS_TOO_MANY_SECTIONS,
+	SOMP_STATUS_OUT_OF_MEMORY,
+	SOMP_STATUS_BAD_VERSION, // the request is of another protocol version
+} SompStatus;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t id;
+	int32_t status;
+	uint32_t latencyNs; // time the daemon spent on the request
+	float wallReactionForce;
+	float wallReactionMoment;
+	float endReactionForce;
+	float endReactionMoment;
+	int32_t sectionsCount;
+} SompResponseHeader;
+
+typedef struct {
+	unsigned char * items;
+	int count;
+	int capacity;
+} SompBuffer;
+
+// Everything one solve needs, the daemon keeps a pool of these so they stay
+// warm between requests
+typedef struct {
+	SolverContext ctx;
+	PointForces pfs;
+	DistributedForces dfs;
+	Beam beam;
+} SompSolveContext;
+
+void initSompSolveContext(SompSolveContext * sc);
+void freeSompSolveContext(SompSolveContext * sc);
+
+uint64_t somp_now_ns();
+
+// Appends a whole request frame to out
+// Returns: false when out of memory
+bool somp_encode_request(SompBuffer * out, uint32_t id, float length, BeamSupports supports,
+		const PointForce * pfs, int pfCount, const DistributedForce * dfs, int dfCount);
+
+// Returns: size of the frame at the start of data (length prefix included),
+// 0 while it is not complete yet, -1 when the length is invalid
+long somp_frame_size(const unsigned char * data, size_t available);
+
+// Solves the request payload and appends the response frame to out. Bad
+// requests still get a response (with an error status)
+// startNs: when the request arrived, for the latency in the response
+// Returns: false when the response could not be appended
+bool somp_handle_request(SompSolveContext * sc, const unsigned char * payload, size_t size,
+		SompBuffer * out, uint64_t startNs);
+
+// Reads a response payload, the sections go into beam when beam != NULL
+// Returns: false when the payload is not a valid response, header->version
+//          tells when it failed because the daemon speaks another version
+bool somp_decode_response(const unsigned char * payload, size_t size,
+		SompResponseHeader * header, Beam * beam);
+
+#ifdef SOMP_PROTOCOL_IMPLEMENTATION
+
+#include <string.h>
+#include <time.h>
+
+void initSompSolveContext(SompSolveContext * sc)
+{
+	*sc = (SompSolveContext){0};
+	initSolverContext(&sc->ctx);
+}
+
+void freeSompSolveContext(SompSolveContext * sc)
+{
+	freeSolverContext(&sc->ctx);
+	free(sc->pfs.items);
+	free(sc->dfs.items);
+	*sc = (SompSolveContext){0};
+}
+
+uint64_t somp_now_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+bool somp_encode_request(SompBuffer * out, uint32_t id, float length, BeamSupports supports,
+		const PointForce * pfs, int pfCount, const DistributedForce * dfs, int dfCount)
+{
+	SompRequestHeader header = { SOMP_REQUEST_MAGIC, SOMP_PROTOCOL_VERSION, id, length, pfCount, dfCount,
+		supports.left, supports.right };
+	uint32_t size = sizeof(header) + pfCount*sizeof(PointForce) + dfCount*sizeof(DistributedForce);
+
+	return DynamicArrayReserve(out, out->count + sizeof(size) + size)
+		&& DynamicArrayAppendMany(out, (unsigned char *) &size, sizeof(size))
+		&& DynamicArrayAppendMany(out, (unsigned char *) &header, sizeof(header))
+		&& DynamicArrayAppendMany(out, (unsigned char *) pfs, pfCount*sizeof(PointForce))
+		&& DynamicArrayAppendMany(out, (unsigned char *) dfs, dfCount*sizeof(DistributedForce));
+}
+
+long somp_frame_size(const unsigned char * data, size_t available)
+{
+	uint32_t size;
+	if (available < sizeof(size)) return 0;
+	memcpy(&size, data, sizeof(size));
+	if (size > SOMP_MAX_FRAME) return -1;
+	if (available < sizeof(size) + size) return 0;
+	return sizeof(size) + size;
+}
+
+static bool somp_append_response(SompBuffer * out, SompResponseHeader header,
+		const Beam * beam, uint64_t startNs)
+{
+	int sectionsSize = (header.status == SOMP_STATUS_OK) ? beam->sections_count*sizeof(Section) : 0;
+	uint32_t size = sizeof(header) + 3*sectionsSize;
+	if (!DynamicArrayReserve(out, out->count + sizeof(size) + size)) return false;
+
+	header.magic = SOMP_RESPONSE_MAGIC;
+	header.version = SOMP_PROTOCOL_VERSION;
+	header.latencyNs = somp_now_ns() - startNs;
+	DynamicArrayAppendMany(out, (unsigned char *) &size, sizeof(size));
+	DynamicArrayAppendMany(out, (unsigned char *) &header, sizeof(header));
+	if (sectionsSize > 0)
+	{
+		DynamicArrayAppendMany(out, (unsigned char *) beam->raws, sectionsSize);
+		DynamicArrayAppendMany(out, (unsigned char *) beam->shears, sectionsSize);
+		DynamicArrayAppendMany(out, (unsigned char *) beam->moments, sectionsSize);
+	}
+	return true;
+}
+
+bool somp_handle_request(SompSolveContext * sc, const unsigned char * payload, size_t size,
+		SompBuffer * out, uint64_t startNs)
+{
+	SompRequestHeader request = {0};
+	SompResponseHeader response = { .status = SOMP_STATUS_BAD_REQUEST };
+	if (size >= sizeof(request)) memcpy(&request, payload, sizeof(request));
+	response.id = request.id;
+
+	// Every version starts with the magic and the version, the rest of
+	// another version's header can not be trusted (not even the id)
+	uint32_t start[2] = {0};
+	if (size >= sizeof(start)) memcpy(start, payload, sizeof(start));
+	if (start[0] == SOMP_REQUEST_MAGIC && start[1] != SOMP_PROTOCOL_VERSION)
+	{
+		response.id = 0;
+		response.status = SOMP_STATUS_BAD_VERSION;
+		return somp_append_response(out, response, &sc->beam, startNs);
+	}
+
+	// Counts are checked one at a time so the sizes below cannot overflow
+	size_t forcesSize = (size_t) request.pfCount*sizeof(PointForce) + (size_t) request.dfCount*sizeof(DistributedForce);
+	if (size < sizeof(request) || request.magic != SOMP_REQUEST_MAGIC
+			|| request.pfCount > SOMP_MAX_FRAME || request.dfCount > SOMP_MAX_FRAME
+			|| size != sizeof(request) + forcesSize || !(request.length > 0)
+			|| request.leftSupport < 0 || request.leftSupport >= SUPPORT_KINDS_COUNT
+			|| request.rightSupport < 0 || request.rightSupport >= SUPPORT_KINDS_COUNT
+			|| !supportsHoldBeam((BeamSupports){ request.leftSupport, request.rightSupport }))
+	{
+		return somp_append_response(out, response, &sc->beam, startNs);
+	}
+
+	// Copied out of the payload, it has no alignment
+	sc->pfs.count = 0;
+	sc->dfs.count = 0;
+	const unsigned char * forces = payload + sizeof(request);
+	if (!DynamicArrayAppendMany(&sc->pfs, (PointForce *) forces, request.pfCount)
+		|| !DynamicArrayReserve(&sc->dfs, request.dfCount))
+	{
+		response.status = SOMP_STATUS_OUT_OF_MEMORY;
+		return somp_append_response(out, response, &sc->beam, startNs);
+	}
+	memcpy(sc->dfs.items, forces + request.pfCount*sizeof(PointForce), request.dfCount*sizeof(DistributedForce));
+	sc->dfs.count = request.dfCount;
+
+	sc->beam.length = request.length;
+	sc->beam.supports = (BeamSupports){ request.leftSupport, request.rightSupport };
+	if (solveBeamCtx(&sc->ctx, &sc->beam, sc->pfs.items, sc->pfs.count, sc->dfs.items, sc->dfs.count))
+	{
+		response.status = SOMP_STATUS_OK;
+		response.wallReactionForce = sc->beam.wall_reaction_force;
+		response.wallReactionMoment = sc->beam.wall_reaction_moment;
+		response.endReactionForce = sc->beam.end_reaction_force;
+		response.endReactionMoment = sc->beam.end_reaction_moment;
+		response.sectionsCount = sc->beam.sections_count;
+	} else
+	{
+		response.status = SOMP_STATUS_TOO_MANY_SECTIONS;
+	}
+	return somp_append_response(out, response, &sc->beam, startNs);
+}
+
+bool somp_decode_response(const unsigned char * payload, size_t size,
+		SompResponseHeader * header, Beam * beam)
+{
+	// Headers of other versions can be shorter, the magic and the version
+	// are read from whatever is there
+	*header = (SompResponseHeader){0};
+	memcpy(header, payload, (size < sizeof(*header)) ? size : sizeof(*header));
+	if (size < sizeof(*header)) return false;
+	if (header->magic != SOMP_RESPONSE_MAGIC || header->version != SOMP_PROTOCOL_VERSION) return false;
+
+	int count = (header->status == SOMP_STATUS_OK) ? header->sectionsCount : 0;
+	if (count < 0 || count > MAX_SECTIONS) return false;
+	size_t sectionsSize = count*sizeof(Section);
+	if (size != sizeof(*header) + 3*sectionsSize) return false;
+	if (beam == NULL) return true;
+
+	const unsigned char * sections = payload + sizeof(*header);
+	beam->wall_reaction_force = header->wallReactionForce;
+	beam->wall_reaction_moment = header->wallReactionMoment;
+	beam->end_reaction_force = header->endReactionForce;
+	beam->end_reaction_moment = header->endReactionMoment;
+	beam->sections_count = count;
+	memcpy(beam->raws, sections, sectionsSize);
+	memcpy(beam->shears, sections + sectionsSize, sectionsSize);
+	memcpy(beam->moments, sections + 2*sectionsSize, sectionsSize);
+	return true;
+}
+
+#endif // SOMP_PROTOCOL_IMPLEMENTATION
+#endif // SOMP_PROTOCOL_H
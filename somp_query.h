@@ -0,0 +1,141 @@
+#ifndef SOMP_QUERY_H
+#define SOMP_QUERY_H
+
+/*
+* Filename:	somp_query.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Values of the diagrams of a solved beam at any x. A single query is a
+* binary search over the breakpoints. A batch of sorted queries walks the
+* sections and the queries together and evaluates every run of queries in
+* one section with poly_eval_many, so n stations cost O(n + sections)
+*
+* A diagram can jump at a breakpoint (a point force in the shear, a point
+* moment in the moment): left is the value just before x and right the value
+* just after it, away from breakpoints they are the same. At the start of
+* the first section both are the value there, at the end of the beam right
+* is after anything applied at the end
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+typedef struct {
+	float left;
+	float right;
+} QueryLimits;
+
+typedef enum {
+	DIAGRAM_SHEAR,
+	DIAGRAM_MOMENT,
+	DIAGRAM_AXIAL,
+	DIAGRAM_TORQUE,
+} DiagramKind;
+
+const Section * beam_diagram(const Beam * beam, DiagramKind kind);
+
+QueryLimits query_at(const Section pieces[], int count, float x);
+// xs sorted from small to big for the linear walk, anything else still
+// works with a search every time the walk has to go back. left can be NULL,
+// xs, left and right can not overlap
+void query_sorted(const Section pieces[], int count, const float * xs, int n,
+		float * left, float * right);
+
+QueryLimits query_beam_at(const Beam * beam, DiagramKind kind, float x);
+void query_beam_sorted(const Beam * beam, DiagramKind kind, const float * xs, int n,
+		float * left, float * right);
+
+#ifdef SOMP_QUERY_IMPLEMENTATION
+
+#include <string.h>
+
+const Section * beam_diagram(const Beam * beam, DiagramKind kind)
+{
+	switch (kind) {
+	case DIAGRAM_SHEAR: return beam->shears;
+	case DIAGRAM_MOMENT: return beam->moments;
+	case DIAGRAM_AXIAL: return beam->axials;
+	case DIAGRAM_TORQUE: return beam->torques;
+	}
+	return beam->shears;
+}
+
+// Same rule as pw_find: x is in the last piece that starts at or before it
+static inline bool query_in_piece(const Section pieces[], int count, int piece, float x)
+{
+	const bool afterStart = piece == 0 || pieces[piece].start <= x || pw_on_breakpoint(pieces[piece].start, x);
+	const bool beforeNext = piece == count-1 || (pieces[piece+1].start > x && !pw_on_breakpoint(pieces[piece+1].start, x));
+	return afterStart && beforeNext;
+}
+
+// Returns: the piece left of a breakpoint at x, past any piece without
+// length that starts there too. -1 when x is not on a breakpoint
+static int query_left_piece(const Section pieces[], int piece, float x)
+{
+	if (piece == 0 || !pw_on_breakpoint(pieces[piece].start, x)) return -1;
+	int left = piece - 1;
+	while (left > 0 && pw_on_breakpoint(pieces[left].start, x)) left--;
+	return left;
+}
+
+QueryLimits query_at(const Section pieces[], int count, float x)
+{
+	if (count <= 0) return (QueryLimits){0};
+	const int piece = pw_find(pieces, count, x);
+	const float right = poly_eval(pieces[piece].polynomial, x);
+	const int left = query_left_piece(pieces, piece, x);
+	return (QueryLimits){ (left < 0) ? right : poly_eval(pieces[left].polynomial, x), right };
+}
+
+void query_sorted(const Section pieces[], int count, const float * xs, int n,
+		float * left, float * right)
+{
+	if (count <= 0)
+	{
+		if (n > 0) memset(right, 0, n * sizeof(float));
+		if (n > 0 && left != NULL) memset(left, 0, n * sizeof(float));
+		return;
+	}
+	int piece = 0;
+	for (int k = 0; k < n;)
+	{
+		const float x = xs[k];
+		if (!query_in_piece(pieces, count, piece, x))
+		{
+			// A few steps forward for sorted queries, a search otherwise
+			int next = piece;
+			while (next < count-1 && next < piece + 4 && !query_in_piece(pieces, count, next, x)) next++;
+			piece = query_in_piece(pieces, count, next, x) ? next : pw_find(pieces, count, x);
+		}
+		int end = k + 1;
+		while (end < n && query_in_piece(pieces, count, piece, xs[end])) end++;
+
+		poly_eval_many(pieces[piece].polynomial, xs + k, right + k, end - k);
+		if (left != NULL)
+		{
+			memcpy(left + k, right + k, (end - k) * sizeof(float));
+			// Only queries on the start of the piece see a jump
+			for (int j = k; j < end; j++)
+			{
+				const int l = query_left_piece(pieces, piece, xs[j]);
+				if (l >= 0) left[j] = poly_eval(pieces[l].polynomial, xs[j]);
+			}
+		}
+		k = end;
+	}
+}
+
+QueryLimits query_beam_at(const Beam * beam, DiagramKind kind, float x)
+{
+	return query_at(beam_diagram(beam, kind), beam->sections_count, x);
+}
+
+void query_beam_sorted(const Beam * beam, DiagramKind kind, const float * xs, int n,
+		float * left, float * right)
+{
+	query_sorted(beam_diagram(beam, kind), beam->sections_count, xs, n, left, right);
+}
+
+#endif // SOMP_QUERY_IMPLEMENTATION
+#endif // SOMP_QUERY_H
@@ -0,0 +1,436 @@
+#ifndef SOMP_REFERENCE_H
+#define SOMP_REFERENCE_H
+
+/*
+* Filename:	somp_reference.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* A slow reference for solveBeam and a differential check of the two. The
+* reference works in long double straight from the forces (no sections),
+* so it shares nothing with the solver it checks. Random beams come from a
+* seeded generator and a failing beam is shrunk to a small one that still
+* fails, ready to be pasted into tests/
+*
+* The solver keeps MAX_POLYNOMIAL_DEGREE terms for the moment, so loads can
+* be at most MAX_POLYNOMIAL_DEGREE-3 degree (linear)
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "somp_logic.h"
+
+#define REF_MAX_POINT_FORCES 6
+#define REF_MAX_DISTR_FORCES 4
+#define REF_LOAD_DEGREE (MAX_POLYNOMIAL_DEGREE-3)
+// Values along the beam compared between the solvers
+#define REF_SAMPLES 4
+// Relative to the size of the loads on the beam
+#define REF_TOLERANCE 1e-4
+
+typedef struct {
+	float length;
+	int pfCount;
+	int dfCount;
+	PointForce pfs[REF_MAX_POINT_FORCES];
+	DistributedForce dfs[REF_MAX_DISTR_FORCES];
+} RefCase;
+
+typedef struct {
+	long double reactionForce;
+	long double reactionMoment;
+} RefReactions;
+
+typedef struct {
+	bool failed;
+	char what[128]; // first check that failed
+	float x;
+	double expected;
+	double actual;
+} RefResult;
+
+// splitmix64, small and good enough to spread seeds
+uint64_t ref_random(uint64_t * state);
+float ref_random_float(uint64_t * state, float min, float max);
+
+void ref_generate_case(uint64_t * state, RefCase * c);
+RefReactions ref_reactions(const RefCase * c);
+// Shear and bending moment a tiny bit right of x
+long double ref_shear(const RefCase * c, RefReactions r, long double x);
+long double ref_moment(const RefCase * c, RefReactions r, long double x);
+
+bool ref_check_case(SolverContext * ctx, const RefCase * c, RefResult * result);
+// Removes forces and rounds values for as long as the case keeps failing
+void ref_shrink_case(SolverContext * ctx, RefCase * c);
+// Same as ref_shrink_case with another check in place of ref_check_case,
+// tests use it to fake a failure
+typedef bool RefCheck(SolverContext * ctx, const RefCase * c, RefResult * result);
+void ref_shrink_case_with(SolverContext * ctx, RefCase * c, RefCheck * check);
+void ref_print_case(FILE * file, const RefCase * c);
+
+#ifdef SOMP_REFERENCE_IMPLEMENTATION
+
+#include <math.h>
+#include <string.h>
+
+uint64_t ref_random(uint64_t * state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+float ref_random_float(uint64_t * state, float min, float max)
+{
+	double t = (ref_random(state) >> 11) * (1.0/9007199254740992.0);
+	return min + (max - min)*t;
+}
+
+// Positions land on a coarse grid half of the time, so forces often share a
+// start, an end or a point
+static float ref_random_position(uint64_t * state, float length, bool snap)
+{
+	float x = ref_random_float(state, 0, length);
+	if (snap) x = floorf(x / length * 8) * length / 8;
+	return x;
+}
+
+// Forces stay on the beam and distributed forces keep some length, like the
+// generator makes them
+static bool ref_case_valid(const RefCase * c)
+{
+	if (c->length <= 0) return false;
+	for (int i = 0; i < c->pfCount; i++)
+	{
+		if (c->pfs[i].distance < 0 || c->pfs[i].distance >= c->length) return false;
+	}
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		if (c->dfs[i].start < 0 || c->dfs[i].end > c->length) return false;
+		if (c->dfs[i].end - c->dfs[i].start < 1e-3) return false;
+	}
+	return true;
+}
+
+// The solver merges breakpoints closer than EPSILON on purpose, the
+// reference does not, so the generator keeps them either equal or apart
+static bool ref_has_near_breakpoints(const RefCase * c)
+{
+	float xs[2 + REF_MAX_POINT_FORCES + 2*REF_MAX_DISTR_FORCES] = { 0, c->length };
+	int count = 2;
+	for (int i = 0; i < c->pfCount; i++) xs[count++] = c->pfs[i].distance;
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		xs[count++] = c->dfs[i].start;
+		xs[count++] = c->dfs[i].end;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i+1; j < count; j++)
+		{
+			float d = fabsf(xs[i] - xs[j]);
+			if (d > 0 && d < 2*EPSILON) return true;
+		}
+	}
+	return false;
+}
+
+static void ref_generate_once(uint64_t * state, RefCase * c)
+{
+	*c = (RefCase){0};
+	c->length = ref_random_float(state, 0.5, 20);
+	c->pfCount = ref_random(state) % (REF_MAX_POINT_FORCES+1);
+	c->dfCount = ref_random(state) % (REF_MAX_DISTR_FORCES+1);
+	bool snap = ref_random(state) % 2;
+
+	for (int i = 0; i < c->pfCount; i++)
+	{
+		c->pfs[i].distance = ref_random_position(state, c->length, snap);
+		c->pfs[i].force = ref_random_float(state, -100, 100);
+	}
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		DistributedForce * d = &c->dfs[i];
+		float a = ref_random_position(state, c->length, snap);
+		float b = ref_random_position(state, c->length, snap);
+		if (fabsf(a - b) < 1e-3) b = c->length;
+		if (fabsf(a - b) < 1e-3) a = 0;
+		d->start = minf(a, b);
+		d->end = maxf(a, b);
+		// Roughly the same size at both ends of the beam
+		float scale = 50;
+		for (int k = 0; k <= REF_LOAD_DEGREE; k++)
+		{
+			d->polynomial[k] = ref_random_float(state, -scale, scale);
+			scale /= c->length;
+		}
+	}
+}
+
+void ref_generate_case(uint64_t * state, RefCase * c)
+{
+	do ref_generate_once(state, c);
+	while (!ref_case_valid(c) || ref_has_near_breakpoints(c));
+}
+
+// Integral of x^power * polynomial from a to b
+static long double ref_integrate(const float polynomial[MAX_POLYNOMIAL_DEGREE], int power,
+		long double a, long double b)
+{
+	long double sum = 0;
+	long double an = a, bn = b; // a^n and b^n
+	for (int n = 1; n <= power; n++) { an *= a; bn *= b; }
+	for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+	{
+		int n = k + power + 1;
+		sum += polynomial[k] * (bn - an) / n;
+		an *= a;
+		bn *= b;
+	}
+	return sum;
+}
+
+RefReactions ref_reactions(const RefCase * c)
+{
+	RefReactions r = {0};
+	for (int i = 0; i < c->pfCount; i++)
+	{
+		r.reactionForce += c->pfs[i].force;
+		r.reactionMoment -= (long double) c->pfs[i].force * c->pfs[i].distance;
+	}
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		const DistributedForce * d = &c->dfs[i];
+		r.reactionForce += ref_integrate(d->polynomial, 0, d->start, d->end);
+		r.reactionMoment -= ref_integrate(d->polynomial, 1, d->start, d->end);
+	}
+	return r;
+}
+
+long double ref_shear(const RefCase * c, RefReactions r, long double x)
+{
+	long double v = r.reactionForce;
+	for (int i = 0; i < c->pfCount; i++)
+	{
+		if (c->pfs[i].distance <= x) v -= c->pfs[i].force;
+	}
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		const DistributedForce * d = &c->dfs[i];
+		if (d->start >= x) continue;
+		v -= ref_integrate(d->polynomial, 0, d->start, fminl(x, d->end));
+	}
+	return v;
+}
+
+// M(x) = M(0) + integral of the shear, a load at t adds -load*(x - t)
+long double ref_moment(const RefCase * c, RefReactions r, long double x)
+{
+	long double m = r.reactionMoment + r.reactionForce*x;
+	for (int i = 0; i < c->pfCount; i++)
+	{
+		if (c->pfs[i].distance <= x) m -= c->pfs[i].force * (x - c->pfs[i].distance);
+	}
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		const DistributedForce * d = &c->dfs[i];
+		if (d->start >= x) continue;
+		long double end = fminl(x, d->end);
+		m -= x*ref_integrate(d->polynomial, 0, d->start, end) - ref_integrate(d->polynomial, 1, d->start, end);
+	}
+	return m;
+}
+
+// Size of the loads, the tolerance scales with it
+static long double ref_load_scale(const RefCase * c)
+{
+	long double scale = 1;
+	for (int i = 0; i < c->pfCount; i++) scale += fabsl(c->pfs[i].force);
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		const DistributedForce * d = &c->dfs[i];
+		for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+		{
+			long double coef = fabsl(d->polynomial[k]);
+			scale += coef * (powl(d->end, k+1) - powl(d->start, k+1)) / (k+1);
+		}
+	}
+	return scale;
+}
+
+static bool ref_fail(RefResult * result, const char * what, float x, double expected, double actual)
+{
+	result->failed = true;
+	snprintf(result->what, sizeof(result->what), "%s", what);
+	result->x = x;
+	result->expected = expected;
+	result->actual = actual;
+	return false;
+}
+
+static bool ref_close(long double expected, long double actual, long double tolerance)
+{
+	return fabsl(expected - actual) <= tolerance;
+}
+
+// Section of the solved beam that holds x, the first one when x is on a
+// boundary so a point force there is already applied
+static int ref_section_at(const Beam * beam, float x)
+{
+	int last = 0;
+	for (int i = 0; i < beam->sections_count; i++)
+	{
+		if (beam->raws[i].end <= beam->raws[i].start) continue;
+		last = i;
+		if (x < beam->raws[i].end) return i;
+	}
+	return last;
+}
+
+bool ref_check_case(SolverContext * ctx, const RefCase * c, RefResult * result)
+{
+	*result = (RefResult){0};
+
+	Beam beam = { .length = c->length };
+	PointForce pfs[REF_MAX_POINT_FORCES];
+	DistributedForce dfs[REF_MAX_DISTR_FORCES];
+	memcpy(pfs, c->pfs, sizeof(pfs));
+	memcpy(dfs, c->dfs, sizeof(dfs));
+	if (!solveBeamCtx(ctx, &beam, pfs, c->pfCount, dfs, c->dfCount))
+	{
+		return ref_fail(result, "solveBeam failed", 0, 0, 0);
+	}
+
+	RefReactions r = ref_reactions(c);
+	const long double forceTolerance = REF_TOLERANCE * ref_load_scale(c);
+	const long double momentTolerance = forceTolerance * c->length;
+
+	if (!ref_close(r.reactionForce, beam.wall_reaction_force, forceTolerance))
+		return ref_fail(result, "wall reaction force", 0, r.reactionForce, beam.wall_reaction_force);
+	if (!ref_close(r.reactionMoment, beam.wall_reaction_moment, momentTolerance))
+		return ref_fail(result, "wall reaction moment", 0, r.reactionMoment, beam.wall_reaction_moment);
+
+	// Sections have to cover the beam from the wall to the free end
+	if (beam.sections_count < 1 || !nearly_equal(beam.raws[0].start, 0))
+		return ref_fail(result, "first section does not start at the wall", 0, 0, beam.raws[0].start);
+	for (int i = 1; i < beam.sections_count; i++)
+	{
+		if (!nearly_equal(beam.raws[i-1].end, beam.raws[i].start))
+			return ref_fail(result, "gap between sections", beam.raws[i].start, beam.raws[i-1].end, beam.raws[i].start);
+	}
+	// A force ending at the free end leaves a last section starting there,
+	// its end is never set
+	int last = beam.sections_count-1;
+	if (last > 0 && nearly_equal(beam.raws[last].start, c->length)) last--;
+	if (!nearly_equal(beam.raws[last].end, c->length))
+		return ref_fail(result, "last section does not end at the free end", c->length,
+				c->length, beam.raws[last].end);
+
+	// Nothing holds the free end, shear and moment are zero there
+	const Section * shear = &beam.shears[ref_section_at(&beam, c->length)];
+	const Section * moment = &beam.moments[ref_section_at(&beam, c->length)];
+	if (!ref_close(0, evalPolynomial(c->length, shear->polynomial), forceTolerance))
+		return ref_fail(result, "shear at the free end", c->length, 0, evalPolynomial(c->length, shear->polynomial));
+	if (!ref_close(0, evalPolynomial(c->length, moment->polynomial), momentTolerance))
+		return ref_fail(result, "moment at the free end", c->length, 0, evalPolynomial(c->length, moment->polynomial));
+
+	// Inside every section, away from the jumps at its ends
+	for (int i = 0; i < beam.sections_count; i++)
+	{
+		const Section * raw = &beam.raws[i];
+		if (raw->end - raw->start < 1e-3) continue;
+		for (int s = 1; s <= REF_SAMPLES; s++)
+		{
+			float x = raw->start + (raw->end - raw->start) * s / (REF_SAMPLES+1);
+			long double v = ref_shear(c, r, x);
+			long double m = ref_moment(c, r, x);
+			float actualV = evalPolynomial(x, beam.shears[i].polynomial);
+			float actualM = evalPolynomial(x, beam.moments[i].polynomial);
+			if (!ref_close(v, actualV, forceTolerance)) return ref_fail(result, "shear", x, v, actualV);
+			if (!ref_close(m, actualM, momentTolerance)) return ref_fail(result, "moment", x, m, actualM);
+		}
+	}
+	return true;
+}
+
+// Shrinking must not swap the failure for a different one
+static bool ref_still_fails(SolverContext * ctx, RefCheck * check, const RefCase * c, const char * what)
+{
+	RefResult result;
+	if (!ref_case_valid(c)) return false;
+	return !check(ctx, c, &result) && strcmp(result.what, what) == 0;
+}
+
+// Tries one simplification, keeps it only when it changed something and
+// the case still fails the same way
+#define REF_TRY(change) do { \
+		RefCase before = *c; \
+		change; \
+		if (memcmp(&before, c, sizeof(before)) == 0) break; \
+		if (ref_still_fails(ctx, check, c, first.what)) progress = true; \
+		else *c = before; \
+	} while (0)
+
+void ref_shrink_case(SolverContext * ctx, RefCase * c)
+{
+	ref_shrink_case_with(ctx, c, ref_check_case);
+}
+
+void ref_shrink_case_with(SolverContext * ctx, RefCase * c, RefCheck * check)
+{
+	RefResult first;
+	if (check(ctx, c, &first)) return;
+
+	bool progress = true;
+	while (progress)
+	{
+		progress = false;
+		for (int i = c->pfCount-1; i >= 0; i--)
+		{
+			REF_TRY({ c->pfs[i] = c->pfs[--c->pfCount]; c->pfs[c->pfCount] = (PointForce){0}; });
+		}
+		for (int i = c->dfCount-1; i >= 0; i--)
+		{
+			REF_TRY({ c->dfs[i] = c->dfs[--c->dfCount]; c->dfs[c->dfCount] = (DistributedForce){0}; });
+		}
+
+		// Whole numbers are easier to check by hand
+		REF_TRY({ c->length = roundf(c->length); });
+		for (int i = 0; i < c->pfCount; i++)
+		{
+			REF_TRY({ c->pfs[i].distance = roundf(c->pfs[i].distance); });
+			REF_TRY({ c->pfs[i].force = roundf(c->pfs[i].force); });
+		}
+		for (int i = 0; i < c->dfCount; i++)
+		{
+			REF_TRY({ c->dfs[i].start = roundf(c->dfs[i].start); });
+			REF_TRY({ c->dfs[i].end = roundf(c->dfs[i].end); });
+			for (int k = 0; k < MAX_POLYNOMIAL_DEGREE; k++)
+			{
+				REF_TRY({ c->dfs[i].polynomial[k] = 0; });
+				REF_TRY({ c->dfs[i].polynomial[k] = roundf(c->dfs[i].polynomial[k]); });
+			}
+		}
+	}
+}
+#undef REF_TRY
+
+// Same format read_info_cli reads
+void ref_print_case(FILE * file, const RefCase * c)
+{
+	fprintf(file, "#B\n%.9g %d\n#PF\n", c->length, MAX_SECTIONS);
+	for (int i = 0; i < c->pfCount; i++) fprintf(file, "%.9g %.9g\n", c->pfs[i].distance, c->pfs[i].force);
+	fprintf(file, "#DF\n");
+	for (int i = 0; i < c->dfCount; i++)
+	{
+		const DistributedForce * d = &c->dfs[i];
+		fprintf(file, "%.9g %.9g [", d->start, d->end);
+		for (int k = 0; k <= REF_LOAD_DEGREE; k++) fprintf(file, "%s%.9g", (k > 0) ? " " : "", d->polynomial[k]);
+		fprintf(file, "]\n");
+	}
+}
+
+#endif // SOMP_REFERENCE_IMPLEMENTATION
+#endif // SOMP_REFERENCE_H
@@ -0,0 +1,222 @@
+#ifndef SOMP_SUPERPOSE_H
+#define SOMP_SUPERPOSE_H
+
+/*
+* Filename:	somp_superpose.h
+* Date:		19/10/2026
+* Name:		EL Joubert
+*
+* Load case superposition. The solver is linear so every basic load case is
+* solved once and stored on a common section grid, after that any load
+* combination is just a weighted sum of the stored coefficients. All cases
+* act on the same beam, with the same supports
+*/
+
+#include <stdbool.h>
+#include "somp_logic.h"
+
+typedef struct {
+	PointForce * pointForces;
+	int pfCount;
+	DistributedForce * distributedForces;
+	int dfCount;
+} LoadCase;
+
+typedef struct {
+	float length;
+	BeamSupports supports;
+	int sectionsCount;
+	float starts[MAX_SECTIONS];
+	float ends[MAX_SECTIONS];
+
+	int casesCount;
+	// Number of floats stored per case, see packLoadCase for the layout
+	int stride;
+	float * coeffs;
+} LoadCaseSet;
+
+bool initLoadCaseSet(LoadCaseSet * set, float beamLength, BeamSupports supports,
+		LoadCase cases[], int casesCount);
+bool combineLoadCases(const LoadCaseSet * set, const float factors[], Beam * out);
+void freeLoadCaseSet(LoadCaseSet * set);
+
+#ifdef SOMP_SUPERPOSE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+// Each case is packed as:
+//  [ wall reaction force, wall reaction moment, end reaction force,
+//    end reaction moment, for every section: raw pointForce, raw poly[], shear poly[], moment poly[] ]
+#define SUPERPOSE_HEADER_FLOATS 4
+#define SUPERPOSE_SECTION_FLOATS (1 + 3*MAX_POLYNOMIAL_DEGREE)
+
+static void packLoadCase(const LoadCaseSet * set, const Beam * beam, float * dest)
+{
+	dest[0] = beam->wall_reaction_force;
+	dest[1] = beam->wall_reaction_moment;
+	dest[2] = beam->end_reaction_force;
+	dest[3] = beam->end_reaction_moment;
+	dest += SUPERPOSE_HEADER_FLOATS;
+
+	// The polynomials are in global x so they can be copied onto the grid
+	// as is, a point force only belongs to the grid section that starts at it
+	Section raws[MAX_SECTIONS], shears[MAX_SECTIONS], moments[MAX_SECTIONS];
+	pw_resample(raws, set->starts, set->ends, set->sectionsCount, beam->raws, beam->sections_count);
+	pw_resample(shears, set->starts, set->ends, set->sectionsCount, beam->shears, beam->sections_count);
+	pw_resample(moments, set->starts, set->ends, set->sectionsCount, beam->moments, beam->sections_count);
+
+	for (int k = 0; k < set->sectionsCount; k++)
+	{
+		dest[0] = raws[k].pointForce;
+		memcpy(dest + 1, raws[k].polynomial, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+		memcpy(dest + 1 + MAX_POLYNOMIAL_DEGREE, shears[k].polynomial, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+		memcpy(dest + 1 + 2*MAX_POLYNOMIAL_DEGREE, moments[k].polynomial, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+		dest += SUPERPOSE_SECTION_FLOATS;
+	}
+}
+
+/*
+ * Solve every basic load case and store the results on a shared section grid
+ *
+ * Parameters:
+ *  [out]set: set to fill, free it with freeLoadCaseSet
+ *  [in]beamLength: length of the beam all cases act on
+ *  [in]supports: how that beam is held, 0 for the cantilever
+ *  [in]cases[]: basic load cases, not modified
+ *  [in]casesCount: number of cases
+ *
+ * Return:
+ *  bool: false if a case could not be solved or the combined grid needs
+ *      more than MAX_SECTIONS sections
+ */
+bool initLoadCaseSet(LoadCaseSet * set, float beamLength, BeamSupports supports,
+		LoadCase cases[], int casesCount)
+{
+	*set = (LoadCaseSet){0};
+	set->length = beamLength;
+	set->supports = supports;
+	set->casesCount = casesCount;
+
+	Beam * beams = malloc(casesCount * sizeof(Beam));
+	if (beams == NULL) return false;
+
+	// Every section start of every case goes into one shared grid
+	set->starts[set->sectionsCount++] = 0;
+
+	for (int c = 0; c < casesCount; c++)
+	{
+		beams[c] = (Beam){ .length = beamLength, .supports = supports, .sections_count = MAX_SECTIONS };
+		if (!solveBeam(&beams[c],
+					cases[c].pointForces, cases[c].pfCount,
+					cases[c].distributedForces, cases[c].dfCount))
+		{
+			free(beams);
+			return false;
+		}
+
+		float starts[MAX_SECTIONS], merged[MAX_SECTIONS];
+		for (int i = 0; i < beams[c].sections_count; i++) starts[i] = beams[c].raws[i].start;
+		int mergedCount = pw_merge_breakpoints(merged, MAX_SECTIONS,
+				set->starts, set->sectionsCount, starts, beams[c].sections_count);
+		if (mergedCount < 0)
+		{
+			free(beams);
+			return false;
+		}
+		memcpy(set->starts, merged, mergedCount*sizeof(float));
+		set->sectionsCount = mergedCount;
+	}
+
+	// Same rule as seperateBeamIntoSections, a section that starts at the
+	// end of the beam only carries its point force
+	for (int k = 0; k < set->sectionsCount; k++)
+	{
+		if (k < set->sectionsCount-1) set->ends[k] = set->starts[k+1];
+		else if (set->starts[k] < beamLength) set->ends[k] = beamLength;
+		else set->ends[k] = 0;
+	}
+
+	set->stride = SUPERPOSE_HEADER_FLOATS + set->sectionsCount * SUPERPOSE_SECTION_FLOATS;
+	set->coeffs = malloc(casesCount * set->stride * sizeof(float));
+	if (set->coeffs == NULL)
+	{
+		free(beams);
+		return false;
+	}
+
+	for (int c = 0; c < casesCount; c++) packLoadCase(set, &beams[c], set->coeffs + c*set->stride);
+
+	free(beams);
+	return true;
+}
+
+/*
+ * Build the solution of a load combination from the stored load cases
+ *
+ * Parameters:
+ *  [in]set: load cases made by initLoadCaseSet
+ *  [in]factors[]: one load factor per case, a factor of 0 skips the case
+ *  [out]out: beam that receives the combined sections and reactions
+ *
+ * Return:
+ *  bool: false if the combined coefficients could not be allocated
+ */
+bool combineLoadCases(const LoadCaseSet * set, const float factors[], Beam * out)
+{
+	float * sum = calloc(set->stride, sizeof(float));
+	if (sum == NULL) return false;
+
+	for (int c = 0; c < set->casesCount; c++)
+	{
+		const float factor = factors[c];
+		if (factor == 0) continue;
+
+		poly_axpy(sum, factor, set->coeffs + c*set->stride, set->stride);
+	}
+
+	out->length = set->length;
+	out->supports = set->supports;
+	out->sections_count = set->sectionsCount;
+	out->wall_reaction_force = sum[0];
+	out->wall_reaction_moment = sum[1];
+	out->end_reaction_force = sum[2];
+	out->end_reaction_moment = sum[3];
+	out->wall_reaction_axial = 0;
+	out->wall_reaction_torque = 0;
+
+	const float * s = sum + SUPERPOSE_HEADER_FLOATS;
+	for (int k = 0; k < set->sectionsCount; k++)
+	{
+		Section section = { .start = set->starts[k], .end = set->ends[k] };
+
+		out->raws[k] = section;
+		out->raws[k].pointForce = s[0];
+		memcpy(out->raws[k].polynomial, s + 1, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+
+		out->shears[k] = section;
+		memcpy(out->shears[k].polynomial, s + 1 + MAX_POLYNOMIAL_DEGREE, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+
+		out->moments[k] = section;
+		memcpy(out->moments[k].polynomial, s + 1 + 2*MAX_POLYNOMIAL_DEGREE, sizeof(float)*MAX_POLYNOMIAL_DEGREE);
+
+		// Load cases only have forces
+		out->applied_moments[k] = section;
+		out->applied_axial[k] = out->applied_torques[k] = section;
+		out->axials[k] = out->torques[k] = section;
+
+		s += SUPERPOSE_SECTION_FLOATS;
+	}
+
+	free(sum);
+	return true;
+}
+
+void freeLoadCaseSet(LoadCaseSet * set)
+{
+	free(set->coeffs);
+	*set = (LoadCaseSet){0};
+}
+
+#endif // SOMP_SUPERPOSE_IMPLEMENTATION
+#endif // SOMP_SUPERPOSE_H
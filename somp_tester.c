@@ -21,6 +21,36 @@
 #define SOMP_IO_IMPLEMENTATION
 #include "somp_io.h"
 
+#define SOMP_SUPERPOSE_IMPLEMENTATION
+#include "somp_superpose.h"
+
+#define SOMP_INFLUENCE_IMPLEMENTATION
+#include "somp_influence.h"
+
+#define SOMP_CACHE_IMPLEMENTATION
+#include "somp_cache.h"
+
+#define SOMP_FORCES_IMPLEMENTATION
+#include "somp_forces.h"
+
+#define SOMP_HITINDEX_IMPLEMENTATION
+#include "somp_hitindex.h"
+
+#define SOMP_REFERENCE_IMPLEMENTATION
+#include "somp_reference.h"
+
+#include <pthread.h>
+#include "somp_lib.c"
+
+#define SOMP_PROTOCOL_IMPLEMENTATION
+#include "somp_protocol.h"
+
+#define SOMP_CONTINUOUS_IMPLEMENTATION
+#include "somp_continuous.h"
+
+#define SOMP_BIAXIAL_IMPLEMENTATION
+#include "somp_biaxial.h"
+
 #include "ejtest/ejtest.h"
  
 void testLinkedLists();
@@ -49,6 +79,25 @@ void testDoubleSameSolve();
 void testDoubleDiffSolve();
 
 void testLineFromPoints();
+void testPiecewisePolynomials();
+void testContinuousBeam();
+void testSupports();
+void testAppliedMoments();
+void testBiaxialBending();
+void testAxialAndTorsion();
+void testQuery();
+
+void testLoadCaseCombination();
+void testMovingLoadEnvelope();
+void testBeamCache();
+void testSolverContext();
+void testSortedEventsLarge();
+void testSortedForceContainers();
+void testHitIndex();
+void testPointForcesSamePlace();
+void testReferenceSolver();
+void testLibsomp();
+void testDaemonProtocol();
 #define TEST_BEGIN(name) void name() {\
     bool R = true;\
     const char * test_name = #name;
@@ -80,34 +129,98 @@ TEST_BEGIN(testDynamicArrayRemoveShuffle)
     ejtest_expect_int(&R, I.items[2], 4);
     ejtest_expect_int(&R, I.items[I.count-1], 4);
 } TEST_END();
-int main()
-{
-	testFloatComparison();
-	testLinkedLists();
-    testLineFromPoints();
-    testShiftArray();
-    testDynamicArrayRemoveShuffle();
-	testSeperateSections();
-
-	testWallReactionForce();
-	testWallReactionMoment();
-    testCompBeams();
-
-    testReadBeamInput();
-    testReadPointforceInput();
-    testReadDistribforceInput();
-    testReadInput();
-
-    testExample_Empty();
-    testExample_A();
-    testExample_B();
-    testExample_C();
-    testExample_6_2();
-    testExample_6_7();
-
-    testDoubleSameSolve();
-    testDoubleDiffSolve();
-    return 0;
+TEST_BEGIN(testDynamicArrayBulk)
+{
+    struct Ints {
+        int * items;
+        int count;
+        int capacity;
+    };
+
+    struct Ints I = {0};
+    ejtest_expect_bool(&R, DynamicArrayReserve(&I, 100), true);
+    ejtest_expect_bool(&R, I.capacity >= 100, true);
+    int * reserved = I.items;
+
+    int src[100];
+    for (int i = 0; i < 100; i++) src[i] = i;
+    ejtest_expect_bool(&R, DynamicArrayAppendMany(&I, src, 100), true);
+    ejtest_expect_int(&R, I.count, 100);
+    ejtest_expect_int(&R, I.items[99], 99);
+    // Reserved up front so no realloc was needed
+    ejtest_expect_bool(&R, I.items == reserved, true);
+
+    ejtest_expect_bool(&R, DynamicArrayTryAppend(&I, 100), true);
+    ejtest_expect_int(&R, I.items[100], 100);
+
+    ejtest_expect_bool(&R, DynamicArrayShrink(&I), true);
+    ejtest_expect_int(&R, I.capacity, 101);
+
+    DynamicArrayClear(&I);
+    ejtest_expect_int(&R, I.count, 0);
+    ejtest_expect_int(&R, I.capacity, 101);
+    ejtest_expect_bool(&R, DynamicArrayShrink(&I), true);
+    ejtest_expect_bool(&R, I.items == NULL, true);
+
+    // Growth starts again from nothing after a full shrink
+    DynamicArrayAppend(&I, 7);
+    ejtest_expect_int(&R, I.capacity, DEFAULT_DA_CAPACITY);
+    ejtest_expect_int(&R, I.items[0], 7);
+
+    free(I.items);
+} TEST_END();
+// Run with -h for the runner options (filter, parallel jobs, reports)
+static const EjtestCase tests[] = {
+    EJTEST_CASE(testFloatComparison),
+    EJTEST_CASE(testLinkedLists),
+    EJTEST_CASE(testLineFromPoints),
+    EJTEST_CASE(testPiecewisePolynomials),
+    EJTEST_CASE(testContinuousBeam),
+    EJTEST_CASE(testSupports),
+    EJTEST_CASE(testAppliedMoments),
+    EJTEST_CASE(testBiaxialBending),
+    EJTEST_CASE(testAxialAndTorsion),
+    EJTEST_CASE(testQuery),
+    EJTEST_CASE(testShiftArray),
+    EJTEST_CASE(testDynamicArrayRemoveShuffle),
+    EJTEST_CASE(testDynamicArrayBulk),
+    EJTEST_CASE(testSeperateSections),
+
+    EJTEST_CASE(testWallReactionForce),
+    EJTEST_CASE(testWallReactionMoment),
+    EJTEST_CASE(testCompBeams),
+
+    EJTEST_CASE(testReadBeamInput),
+    EJTEST_CASE(testReadPointforceInput),
+    EJTEST_CASE(testReadDistribforceInput),
+    EJTEST_CASE(testReadInput),
+
+    EJTEST_CASE(testExample_Empty),
+    EJTEST_CASE(testExample_A),
+    EJTEST_CASE(testExample_B),
+    EJTEST_CASE(testExample_C),
+    EJTEST_CASE(testExample_6_2),
+    EJTEST_CASE(testExample_6_7),
+
+    EJTEST_CASE(testDoubleSameSolve),
+    EJTEST_CASE(testDoubleDiffSolve),
+
+    EJTEST_CASE(testLoadCaseCombination),
+    EJTEST_CASE(testMovingLoadEnvelope),
+    EJTEST_CASE(testBeamCache),
+    EJTEST_CASE(testSolverContext),
+    EJTEST_CASE(testSortedEventsLarge),
+    EJTEST_CASE(testSortedForceContainers),
+    EJTEST_CASE(testHitIndex),
+    EJTEST_CASE(testPointForcesSamePlace),
+    EJTEST_CASE(testReferenceSolver),
+    EJTEST_CASE(testLibsomp),
+    EJTEST_CASE(testDaemonProtocol),
+};
+
+int main(int argc, char * argv[])
+{
+    return ejtest_main(argc, argv, tests, EJTEST_ARRAY_SIZE(tests));
 }
 TEST_BEGIN(testShiftArray)
 {
@@ -223,6 +336,1101 @@ TEST_BEGIN(testDoubleDiffSolve)
     ejtest_expect_float(&R, beam.wall_reaction_force, 2);
     ejtest_expect_float(&R, beam.wall_reaction_moment, -1*0.75-1*0.25);
 } TEST_END();
+TEST_BEGIN(testLoadCaseCombination)
+{
+    PointForce pfA[] = { { 0.25, 2 } };
+    DistributedForce dfA[] = { { 0.5, 1.0, {2, 0} } };
+    PointForce pfB[] = { { 0.6, -1 } };
+    DistributedForce dfB[] = { { 0, 0.75, {1, 0} } };
+
+    LoadCase cases[] = {
+        { pfA, ArrayCount(pfA), dfA, ArrayCount(dfA) },
+        { pfB, ArrayCount(pfB), dfB, ArrayCount(dfB) },
+    };
+    float factors[] = { 1.2, 1.6 };
+
+    LoadCaseSet set;
+    ejtest_expect_bool(&R, initLoadCaseSet(&set, 1.0, (BeamSupports){0}, cases, ArrayCount(cases)), true);
+
+    Beam combined = {0};
+    ejtest_expect_bool(&R, combineLoadCases(&set, factors, &combined), true);
+
+    // Same combination solved directly
+    PointForce pf[] = { { 0.25, 1.2*2 }, { 0.6, 1.6*-1 } };
+    DistributedForce df[] = { { 0.5, 1.0, {1.2*2, 0} }, { 0, 0.75, {1.6*1, 0} } };
+    Beam expected = { .length = 1.0, .sections_count = MAX_SECTIONS };
+    solveBeam(&expected, pf, ArrayCount(pf), df, ArrayCount(df));
+
+    ejtest_expect_float(&R, combined.wall_reaction_force, expected.wall_reaction_force);
+    ejtest_expect_float(&R, combined.wall_reaction_moment, expected.wall_reaction_moment);
+    ejtest_expect_struct(&R, combined, expected, comp_beams);
+    freeLoadCaseSet(&set);
+
+    // A propped cantilever: the end reactions are combined too and nothing
+    // is left over from what out held before
+    const BeamSupports propped = { SUPPORT_FIXED, SUPPORT_PIN };
+    ejtest_expect_bool(&R, initLoadCaseSet(&set, 1.0, propped, cases, ArrayCount(cases)), true);
+    combined = (Beam){ .end_reaction_force = 99, .end_reaction_moment = 99 };
+    ejtest_expect_bool(&R, combineLoadCases(&set, factors, &combined), true);
+    expected = (Beam){ .length = 1.0, .supports = propped, .sections_count = MAX_SECTIONS };
+    solveBeam(&expected, pf, ArrayCount(pf), df, ArrayCount(df));
+
+    ejtest_expect_int(&R, combined.supports.right, SUPPORT_PIN);
+    ejtest_expect_float(&R, combined.wall_reaction_force, expected.wall_reaction_force);
+    ejtest_expect_float(&R, combined.wall_reaction_moment, expected.wall_reaction_moment);
+    ejtest_expect_float(&R, combined.end_reaction_force, expected.end_reaction_force);
+    ejtest_expect_float(&R, combined.end_reaction_moment, expected.end_reaction_moment);
+    ejtest_expect_struct(&R, combined, expected, comp_beams);
+    freeLoadCaseSet(&set);
+} TEST_END();
+// Value of solved sections at x, uses the last section that starts before x
+float evalSectionsAt(Section sections[], int count, float x)
+{
+    int found = 0;
+    for (int i = 0; i < count; i++) if (sections[i].start <= x) found = i;
+    return evalPolynomial(x, sections[found].polynomial);
+}
+TEST_BEGIN(testMovingLoadEnvelope)
+{
+    const float length = 1.0;
+    PointForce train[] = { { 0, 2 }, { -0.3, 1 } };
+    const int positions = 14;
+
+    Envelope envelope;
+    ejtest_expect_bool(&R, initEnvelope(&envelope, length, 8), true);
+    ejtest_expect_bool(&R, sweepLoadTrain(length, train, ArrayCount(train), 0, 1.3, positions, 4, &envelope), true);
+
+    // Brute force, one solve per position
+    float shearMax[8], shearMin[8], momentMax[8], momentMin[8];
+    for (int s = 0; s < 8; s++) shearMax[s] = shearMin[s] = momentMax[s] = momentMin[s] = 0;
+
+    for (int p = 0; p < positions; p++)
+    {
+        PointForce on_beam[2];
+        int count = 0;
+        for (int i = 0; i < 2; i++)
+        {
+            float a = p*0.1 + train[i].distance;
+            if (a >= 0 && a <= length) on_beam[count++] = (PointForce){ a, train[i].force };
+        }
+
+        Beam beam = { .length = length, .sections_count = MAX_SECTIONS };
+        solveBeam(&beam, on_beam, count, NULL, 0);
+        for (int s = 0; s < 8; s++)
+        {
+            float shear = evalSectionsAt(beam.shears, beam.sections_count, envelope.stations[s]);
+            float moment = evalSectionsAt(beam.moments, beam.sections_count, envelope.stations[s]);
+            shearMax[s] = maxf(shearMax[s], shear);
+            shearMin[s] = minf(shearMin[s], shear);
+            momentMax[s] = maxf(momentMax[s], moment);
+            momentMin[s] = minf(momentMin[s], moment);
+        }
+    }
+
+    for (int s = 0; s < 8; s++)
+    {
+        ejtest_expect_float(&R, envelope.shearMax[s], shearMax[s]);
+        ejtest_expect_float(&R, envelope.shearMin[s], shearMin[s]);
+        ejtest_expect_float(&R, envelope.momentMax[s], momentMax[s]);
+        ejtest_expect_float(&R, envelope.momentMin[s], momentMin[s]);
+    }
+
+    freeEnvelope(&envelope);
+} TEST_END();
+TEST_BEGIN(testBeamCache)
+{
+    BeamCache cache;
+    ejtest_expect_bool(&R, initBeamCache(&cache, 2, 1024), true);
+
+    PointForce pfs[] = { { 0.5, 3 }, { 0.25, 2 } };
+    PointForce pfs_shuffled[] = { { 0.25, 2 }, { 0.5, 3 } };
+    DistributedForce dfs[] = { { 0.75, 1.0, {3, 0} }, { 0, 0.5, {1, 0} } };
+    DistributedForce dfs_shuffled[] = { { 0, 0.5, {1, 0} }, { 0.75, 1.0, {3, 0} } };
+
+    Beam first = { .length = 1.0 };
+    Beam second = { .length = 1.0 };
+    ejtest_expect_bool(&R, cachedSolveBeam(&cache, &first, pfs, 2, dfs, 2), true);
+    ejtest_expect_bool(&R, cachedSolveBeam(&cache, &second, pfs_shuffled, 2, dfs_shuffled, 2), true);
+    ejtest_expect_int(&R, cache.misses, 1);
+    ejtest_expect_int(&R, cache.hits, 1);
+    ejtest_expect_bool(&R, memcmp(&first, &second, sizeof(Beam)) == 0, true);
+    // Caller arrays are left alone
+    ejtest_expect_float(&R, pfs[0].distance, 0.5);
+
+    Beam expected = { .length = 1.0 };
+    solveBeam(&expected, pfs_shuffled, 2, dfs_shuffled, 2);
+    ejtest_expect_struct(&R, second, expected, comp_beams);
+
+    // Fill up the cache so the first entry is the least recently used
+    Beam other = { .length = 2.0 };
+    cachedSolveBeam(&cache, &other, pfs, 2, NULL, 0);
+    cachedSolveBeam(&cache, &other, pfs, 1, NULL, 0);
+    ejtest_expect_int(&R, cache.evictions, 1);
+    ejtest_expect_int(&R, cache.count, 2);
+
+    cachedSolveBeam(&cache, &first, pfs, 2, dfs, 2);
+    ejtest_expect_int(&R, cache.misses, 4);
+
+    // Same forces on other supports is another beam, spelling out the
+    // default is not
+    Beam simple = { .length = 1.0, .supports = { SUPPORT_PIN, SUPPORT_PIN } };
+    ejtest_expect_bool(&R, cachedSolveBeam(&cache, &simple, pfs, 2, dfs, 2), true);
+    ejtest_expect_int(&R, cache.misses, 5);
+    Beam cantilever = { .length = 1.0, .supports = { SUPPORT_FIXED, SUPPORT_FREE } };
+    cachedSolveBeam(&cache, &cantilever, pfs, 2, dfs, 2);
+    ejtest_expect_int(&R, cache.misses, 5);
+
+    freeBeamCache(&cache);
+} TEST_END();
+TEST_BEGIN(testSolverContext)
+{
+    SolverContext ctx;
+    initSolverContext(&ctx);
+
+    PointForce pfs[] = { { 0.0, 1 }, { 0.25, 2 }, { 0.5, 3 }, { 1.0, 4 } };
+    DistributedForce dfs[] = {
+        { 0, 0.5, {1,0} }, { 0.25, 0.75, {2,0} }, { 0.75, 1.0, {3,0} }, { 0.65, 0.95, {4,0} },
+    };
+
+    Beam expected = { .length = 1.0 };
+    solveBeam(&expected, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs));
+
+    Beam beam = { .length = 1.0 };
+    ejtest_expect_bool(&R, solveBeamCtx(&ctx, &beam, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs)), true);
+    ejtest_expect_struct(&R, beam, expected, comp_beams);
+
+    // Once warmed up a solve of the same size should not touch the heap
+    long heap_calls = solverContextHeapCalls(&ctx);
+    for (int i = 0; i < 100; i++)
+    {
+        solveBeamCtx(&ctx, &beam, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs));
+        solveBeamCtx(&ctx, &beam, pfs, 2, dfs, 2);
+    }
+    ejtest_expect_int(&R, solverContextHeapCalls(&ctx), heap_calls);
+
+    freeSolverContext(&ctx);
+} TEST_END();
+// Every thread solves the same random beams with its own libsomp solver
+#define LIBSOMP_TEST_CASES 300
+#define LIBSOMP_TEST_THREADS 4
+static float libsomp_test_moments[LIBSOMP_TEST_THREADS][LIBSOMP_TEST_CASES];
+static void * libsomp_test_thread(void * arg)
+{
+    int thread = *(int *) arg;
+    LibsompSolver * solver = libsomp_solver_new();
+    for (int i = 0; solver != NULL && i < LIBSOMP_TEST_CASES; i++)
+    {
+        uint64_t state = i+1;
+        RefCase c;
+        ref_generate_case(&state, &c);
+        LibsompStatus status = libsomp_solve(solver, c.length,
+                (LibsompPointForce *) c.pfs, c.pfCount, (LibsompDistributedForce *) c.dfs, c.dfCount);
+        libsomp_test_moments[thread][i] = (status == LIBSOMP_OK) ? libsomp_wall_reaction_moment(solver) : NAN;
+    }
+    libsomp_solver_free(solver);
+    return NULL;
+}
+TEST_BEGIN(testLibsomp)
+{
+    PointForce pfs[] = { { 0.0, 1 }, { 0.25, 2 }, { 0.5, 3 }, { 1.0, 4 } };
+    DistributedForce dfs[] = {
+        { 0, 0.5, {1,0} }, { 0.25, 0.75, {2,0} }, { 0.75, 1.0, {3,0} }, { 0.65, 0.95, {4,0} },
+    };
+    Beam expected = { .length = 1.0 };
+    solveBeam(&expected, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs));
+
+    LibsompSolver * solver = libsomp_solver_new();
+    ejtest_expect_int(&R, libsomp_sections_count(solver), 0);
+    ejtest_expect_int(&R, libsomp_solve(solver, 1.0, NULL, 1, NULL, 0), LIBSOMP_ERROR_ARGUMENT);
+
+    ejtest_expect_int(&R, libsomp_solve(solver, 1.0,
+                (LibsompPointForce *) pfs, ArrayCount(pfs), (LibsompDistributedForce *) dfs, ArrayCount(dfs)), LIBSOMP_OK);
+    ejtest_expect_float(&R, libsomp_wall_reaction_force(solver), expected.wall_reaction_force);
+    ejtest_expect_float(&R, libsomp_wall_reaction_moment(solver), expected.wall_reaction_moment);
+    ejtest_expect_int(&R, libsomp_sections_count(solver), expected.sections_count);
+    // Right of the point force at 0.5
+    ejtest_expect_float(&R, expected.raws[2].start, 0.5);
+    ejtest_expect_float(&R, libsomp_shear_at(solver, 0.5), evalPolynomial(0.5, expected.shears[2].polynomial));
+    ejtest_expect_float(&R, libsomp_moment_at(solver, 1.0), 0);
+
+    LibsompSection sections[MAX_SECTIONS];
+    ejtest_expect_int(&R, libsomp_get_sections(solver, LIBSOMP_SECTIONS_MOMENT, sections, 1), LIBSOMP_ERROR_ARGUMENT);
+    ejtest_expect_int(&R, libsomp_get_sections(solver, LIBSOMP_SECTIONS_MOMENT, sections, MAX_SECTIONS), LIBSOMP_OK);
+    ejtest_expect_bool(&R, memcmp(sections, expected.moments, expected.sections_count*sizeof(Section)) == 0, true);
+
+    // Too many sections for one beam
+    PointForce many[MAX_SECTIONS+1];
+    for (int i = 0; i < MAX_SECTIONS+1; i++) many[i] = (PointForce){ i/(float)(MAX_SECTIONS+1), 1 };
+    ejtest_expect_int(&R, libsomp_solve(solver, 1.0, (LibsompPointForce *) many, MAX_SECTIONS+1, NULL, 0),
+            LIBSOMP_ERROR_TOO_MANY_SECTIONS);
+    ejtest_expect_int(&R, libsomp_get_sections(solver, LIBSOMP_SECTIONS_LOAD, sections, MAX_SECTIONS), LIBSOMP_ERROR_NOT_SOLVED);
+
+    // Simply supported, half the load on each end
+    ejtest_expect_int(&R, libsomp_set_supports(solver, LIBSOMP_SUPPORT_FREE, LIBSOMP_SUPPORT_FREE), LIBSOMP_ERROR_ARGUMENT);
+    ejtest_expect_int(&R, libsomp_set_supports(solver, LIBSOMP_SUPPORT_PIN, LIBSOMP_SUPPORT_ROLLER), LIBSOMP_OK);
+    LibsompPointForce middle = { 0.5, 2 };
+    ejtest_expect_int(&R, libsomp_solve(solver, 1.0, &middle, 1, NULL, 0), LIBSOMP_OK);
+    ejtest_expect_float(&R, libsomp_end_reaction_force(solver), 1);
+    ejtest_expect_float(&R, libsomp_moment_at(solver, 0.5), 0.5);
+    libsomp_solver_free(solver);
+
+    // Solvers on different threads do not share anything
+    pthread_t threads[LIBSOMP_TEST_THREADS];
+    int ids[LIBSOMP_TEST_THREADS];
+    for (int t = 0; t < LIBSOMP_TEST_THREADS; t++)
+    {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, libsomp_test_thread, &ids[t]);
+    }
+    for (int t = 0; t < LIBSOMP_TEST_THREADS; t++) pthread_join(threads[t], NULL);
+
+    int mismatches = 0;
+    for (int i = 0; i < LIBSOMP_TEST_CASES; i++)
+    {
+        uint64_t state = i+1;
+        RefCase c;
+        ref_generate_case(&state, &c);
+        Beam beam = { .length = c.length };
+        solveBeam(&beam, c.pfs, c.pfCount, c.dfs, c.dfCount);
+        for (int t = 0; t < LIBSOMP_TEST_THREADS; t++) mismatches += libsomp_test_moments[t][i] != beam.wall_reaction_moment;
+    }
+    ejtest_expect_int(&R, mismatches, 0);
+} TEST_END();
+TEST_BEGIN(testPiecewisePolynomials)
+{
+    const float p[MAX_POLYNOMIAL_DEGREE] = { 1, -2, 0.5, 0.25 };
+    float xs[] = { -1, 0, 0.5, 2, 3 }, values[5];
+    poly_eval_many(p, xs, values, 5);
+    for (int i = 0; i < 5; i++)
+    {
+        float x = xs[i];
+        ejtest_expect_float(&R, values[i], 1 - 2*x + 0.5*x*x + 0.25*x*x*x);
+    }
+
+    // Integrating drops the x^3 term, differentiating gets the rest back
+    float integrated[MAX_POLYNOMIAL_DEGREE], back[MAX_POLYNOMIAL_DEGREE];
+    poly_integrate(integrated, p);
+    poly_differentiate(back, integrated);
+    for (int k = 0; k < MAX_POLYNOMIAL_DEGREE-1; k++) ejtest_expect_float(&R, back[k], p[k]);
+    ejtest_expect_float(&R, back[MAX_POLYNOMIAL_DEGREE-1], 0);
+    ejtest_expect_float(&R, poly_integral(p, 0, 2), 2 - 4 + 0.5*8/3);
+
+    float line[MAX_POLYNOMIAL_DEGREE];
+    poly_line(line, 1, 2, 3, 6);
+    ejtest_expect_float(&R, poly_eval(line, 2), 4);
+
+    // The moment diagram is the integral of the shear
+    PointForce pfs[] = { { 0.25, 2 }, { 0.5, 3 }, { 1.0, 4 } };
+    DistributedForce dfs[] = { { 0, 0.5, {1,0} }, { 0.25, 0.75, {2,1} } };
+    Beam beam = { .length = 1.0 };
+    solveBeam(&beam, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs));
+    Section derivative[MAX_SECTIONS];
+    pw_differentiate(derivative, beam.moments, beam.sections_count);
+    for (int i = 0; i < beam.sections_count; i++)
+    {
+        float x = (beam.moments[i].start + beam.moments[i].end)/2;
+        ejtest_expect_float(&R, poly_eval(derivative[i].polynomial, x), poly_eval(beam.shears[i].polynomial, x));
+    }
+    ejtest_expect_float(&R, pw_total(beam.raws, beam.sections_count), beam.wall_reaction_force);
+
+    float samples[11];
+    pw_sample(beam.shears, beam.sections_count, 0, 1, samples, 11);
+    for (int i = 0; i < 11; i++)
+    {
+        float x = i/10.0f;
+        int piece = pw_find(beam.shears, beam.sections_count, x);
+        // At a breakpoint the sample is the value left of it
+        if (piece > 0 && nearly_equal(beam.shears[piece].start, x)) piece--;
+        ejtest_expect_float(&R, samples[i], poly_eval(beam.shears[piece].polynomial, x));
+    }
+
+    // Cut to [0.3, 0.8] the load is what is in between
+    Section cut[MAX_SECTIONS];
+    int cutCount = pw_restrict(cut, MAX_SECTIONS, beam.raws, beam.sections_count, 0.3, 0.8);
+    ejtest_expect_float(&R, cut[0].start, 0.3);
+    ejtest_expect_float(&R, cut[cutCount-1].end, 0.8);
+    ejtest_expect_float(&R, pw_total(cut, cutCount), 3 + 0.2 + 2*0.45 + (0.5625 - 0.09)/2);
+    ejtest_expect_int(&R, pw_restrict(cut, 1, beam.raws, beam.sections_count, 0.3, 0.8), -1);
+
+    float a[] = { 0, 0.5, 1 }, b[] = { 0.25, 0.5 + EPSILON/4, 2 }, merged[5];
+    ejtest_expect_int(&R, pw_merge_breakpoints(merged, 5, a, 3, b, 3), 5);
+    ejtest_expect_float(&R, merged[1], 0.25);
+    ejtest_expect_float(&R, merged[4], 2);
+    ejtest_expect_int(&R, pw_merge_breakpoints(merged, 3, a, 3, b, 3), -1);
+} TEST_END();
+TEST_BEGIN(testContinuousBeam)
+{
+    // Two equal spans under the same uniform load: M = -wL^2/8 over the
+    // middle support, reactions 3wL/8, 10wL/8, 3wL/8
+    const float w = 2, L = 3;
+    DistributedForce udl[] = { { 0, L, {w,0} } };
+    Span spans[] = {
+        { L, NULL, 0, udl, 1 },
+        { L, NULL, 0, udl, 1 },
+    };
+    ContinuousBeam beam;
+    ejtest_expect_bool(&R, solveContinuousBeam(&beam, spans, 2, false, false), true);
+    ejtest_expect_float(&R, beam.supportMoments[0], 0);
+    ejtest_expect_float(&R, beam.supportMoments[1], -w*L*L/8);
+    ejtest_expect_float(&R, beam.reactions[0], 3*w*L/8);
+    ejtest_expect_float(&R, beam.reactions[1], 10*w*L/8);
+    ejtest_expect_float(&R, beam.reactions[2], 3*w*L/8);
+    ejtest_expect_float(&R, continuousMomentAt(&beam, L), -w*L*L/8);
+    // Largest sagging moment is 9wL^2/128 at 3L/8
+    ejtest_expect_float(&R, continuousMomentAt(&beam, 3*L/8), 9*w*L*L/128);
+    ejtest_expect_float(&R, continuousShearAt(&beam, 3*L/8), 0);
+    freeContinuousBeam(&beam);
+
+    // Fixed at both ends with a point force in the middle: PL/8 everywhere
+    PointForce middle[] = { { L/2, 4 } };
+    Span fixed[] = { { L, middle, 1, NULL, 0 } };
+    ejtest_expect_bool(&R, solveContinuousBeam(&beam, fixed, 1, true, true), true);
+    ejtest_expect_float(&R, beam.supportMoments[0], -4*L/8);
+    ejtest_expect_float(&R, beam.supportMoments[1], -4*L/8);
+    ejtest_expect_float(&R, continuousMomentAt(&beam, L/2), 4*L/8);
+    ejtest_expect_float(&R, beam.reactions[0], 2);
+    freeContinuousBeam(&beam);
+
+    // Many spans with a linear load: the reactions carry the whole load
+    enum { SPANS = 5000 };
+    static Span many[SPANS];
+    DistributedForce ramp[] = { { 0, 1.5, {1,2} } };
+    PointForce end[] = { { 1.5, 3 } };
+    double total = 0;
+    for (int i = 0; i < SPANS; i++)
+    {
+        many[i] = (Span){ 1.5, end, 1, ramp, 1 };
+        total += 1.5 + 1.5*1.5 + 3;
+    }
+    ejtest_expect_bool(&R, solveContinuousBeam(&beam, many, SPANS, false, true), true);
+    double reactions = 0;
+    for (int j = 0; j <= SPANS; j++) reactions += beam.reactions[j];
+    ejtest_expect_bool(&R, fabs(reactions - total) < 1e-4*total, true);
+    ejtest_expect_float(&R, beam.supportMoments[0], 0);
+    // Far from the ends every support looks the same
+    ejtest_expect_float(&R, beam.supportMoments[SPANS/2], beam.supportMoments[SPANS/2 + 1]);
+    freeContinuousBeam(&beam);
+
+    Span empty[] = { { 0, NULL, 0, NULL, 0 } };
+    ejtest_expect_bool(&R, solveContinuousBeam(&beam, empty, 1, false, false), false);
+} TEST_END();
+// Moment at x from the solved sections
+static float momentAt(const Beam * beam, float x)
+{
+    int i = pw_find(beam->moments, beam->sections_count, x);
+    if (i > 0 && beam->moments[i].end <= beam->moments[i].start) i--;
+    return poly_eval(beam->moments[i].polynomial, x);
+}
+TEST_BEGIN(testSupports)
+{
+    const float w = 3, L = 2;
+    DistributedForce udl[] = { { 0, L, {w,0} } };
+    Beam beam = { .length = L };
+
+    // Simply supported: wL^2/8 in the middle, nothing at the ends
+    beam.supports = (BeamSupports){ SUPPORT_PIN, SUPPORT_ROLLER };
+    ejtest_expect_bool(&R, solveBeam(&beam, NULL, 0, udl, 1), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, w*L/2);
+    ejtest_expect_float(&R, beam.end_reaction_force, w*L/2);
+    ejtest_expect_float(&R, momentAt(&beam, L/2), w*L*L/8);
+    ejtest_expect_float(&R, momentAt(&beam, L), 0);
+
+    // Without a length only the cantilever can be solved, the other
+    // supports share the load over it
+    PointForce tip[] = { { 0, 10 } };
+    Beam point = { .length = 0, .supports = { SUPPORT_PIN, SUPPORT_ROLLER } };
+    ejtest_expect_bool(&R, solveBeam(&point, tip, 1, NULL, 0), false);
+    point = (Beam){ .length = 0, .supports = { SUPPORT_FIXED, SUPPORT_FIXED } };
+    ejtest_expect_bool(&R, solveBeam(&point, tip, 1, NULL, 0), false);
+
+    // Propped cantilever: -wL^2/8 at the wall, 3wL/8 on the prop
+    beam.supports = (BeamSupports){ SUPPORT_FIXED, SUPPORT_PIN };
+    ejtest_expect_bool(&R, solveBeam(&beam, NULL, 0, udl, 1), true);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -w*L*L/8);
+    ejtest_expect_float(&R, beam.end_reaction_force, 3*w*L/8);
+    ejtest_expect_float(&R, momentAt(&beam, L), 0);
+
+    // The same turned around
+    beam.supports = (BeamSupports){ SUPPORT_ROLLER, SUPPORT_FIXED };
+    ejtest_expect_bool(&R, solveBeam(&beam, NULL, 0, udl, 1), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, 3*w*L/8);
+    ejtest_expect_float(&R, beam.end_reaction_moment, -w*L*L/8);
+
+    // Fixed at both ends: -wL^2/12 at the ends, wL^2/24 in the middle
+    beam.supports = (BeamSupports){ SUPPORT_FIXED, SUPPORT_FIXED };
+    ejtest_expect_bool(&R, solveBeam(&beam, NULL, 0, udl, 1), true);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -w*L*L/12);
+    ejtest_expect_float(&R, beam.end_reaction_moment, -w*L*L/12);
+    ejtest_expect_float(&R, momentAt(&beam, L/2), w*L*L/24);
+
+    // Fixed-fixed with a point force at a: M_A = -Pab^2/L^2
+    PointForce pf[] = { { 0.5, 4 } };
+    const float a = 0.5, b = L - a;
+    ejtest_expect_bool(&R, solveBeam(&beam, pf, 1, NULL, 0), true);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -4*a*b*b/(L*L));
+    ejtest_expect_float(&R, beam.end_reaction_moment, -4*a*a*b/(L*L));
+
+    // Cantilever from the other end
+    beam.supports = (BeamSupports){ SUPPORT_FREE, SUPPORT_FIXED };
+    ejtest_expect_bool(&R, solveBeam(&beam, pf, 1, NULL, 0), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, 0);
+    ejtest_expect_float(&R, beam.end_reaction_force, 4);
+    ejtest_expect_float(&R, beam.end_reaction_moment, -4*b);
+
+    // Nothing holds these
+    beam.supports = (BeamSupports){ SUPPORT_FREE, SUPPORT_FREE };
+    ejtest_expect_bool(&R, solveBeam(&beam, pf, 1, NULL, 0), false);
+    beam.supports = (BeamSupports){ SUPPORT_PIN, SUPPORT_FREE };
+    ejtest_expect_bool(&R, solveBeam(&beam, pf, 1, NULL, 0), false);
+
+    // The default is still the cantilever
+    Beam cantilever = { .length = L };
+    beam.supports = (BeamSupports){ SUPPORT_FIXED, SUPPORT_FREE };
+    ejtest_expect_bool(&R, solveBeam(&cantilever, pf, 1, udl, 1) && solveBeam(&beam, pf, 1, udl, 1), true);
+    ejtest_expect_bool(&R, comp_beams(&cantilever, &beam), true);
+} TEST_END();
+// Solves with loads, a fresh context every time
+static bool solveLoads(Beam * beam, BeamLoads loads)
+{
+    SolverContext ctx;
+    initSolverContext(&ctx);
+    bool solved = solveBeamLoads(&ctx, beam, &loads);
+    freeSolverContext(&ctx);
+    return solved;
+}
+TEST_BEGIN(testAppliedMoments)
+{
+    const float C = 2, m = 1.5, L = 2, a = 0.5;
+    PointForce pf[] = { { a, 4 } };
+    PointMoment pm[] = { { a, C } };
+    DistributedMoment dm[] = { { 0, L, {m} } };
+    Beam beam = { .length = L };
+
+    // Cantilever: the wall takes the moment, the beam is bent only up to it
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointMoments = pm, .pmCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, 0);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -C);
+    ejtest_expect_float(&R, momentAt(&beam, a/2), -C);
+    ejtest_expect_float(&R, momentAt(&beam, (a+L)/2), 0);
+
+    // On top of a point force in the same place it adds no section
+    Beam forceOnly = { .length = L };
+    ejtest_expect_bool(&R, solveBeam(&forceOnly, pf, 1, NULL, 0), true);
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointForces = pf, .pfCount = 1, .pointMoments = pm, .pmCount = 1 }), true);
+    ejtest_expect_int(&R, beam.sections_count, forceOnly.sections_count);
+    ejtest_expect_float(&R, beam.applied_moments[1].pointForce, C);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, forceOnly.wall_reaction_moment - C);
+    ejtest_expect_float(&R, momentAt(&beam, L), 0);
+
+    // Simply supported: the reactions are a couple, M jumps by C at a
+    beam.supports = (BeamSupports){ SUPPORT_PIN, SUPPORT_ROLLER };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointMoments = pm, .pmCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, -C/L);
+    ejtest_expect_float(&R, beam.end_reaction_force, C/L);
+    ejtest_expect_float(&R, momentAt(&beam, a/2), -C*(a/2)/L);
+    ejtest_expect_float(&R, momentAt(&beam, 1.5), C - C*1.5/L);
+    ejtest_expect_float(&R, beam.end_reaction_moment, 0);
+
+    // A uniform moment on a cantilever: M = -m(L - x)
+    beam.supports = (BeamSupports){0};
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .distributedMoments = dm, .dmCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -m*L);
+    ejtest_expect_float(&R, momentAt(&beam, a), -m*(L - a));
+
+    // Fixed at both ends the shear takes all of it and nothing bends
+    beam.supports = (BeamSupports){ SUPPORT_FIXED, SUPPORT_FIXED };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .distributedMoments = dm, .dmCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_force, -m);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, 0);
+    ejtest_expect_float(&R, momentAt(&beam, a), 0);
+    ejtest_expect_float(&R, beam.end_reaction_moment, 0);
+
+    // A moment at the free end only has the section that starts there
+    PointMoment atEnd[] = { { L, C } };
+    beam.supports = (BeamSupports){0};
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointMoments = atEnd, .pmCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -C);
+    ejtest_expect_float(&R, momentAt(&beam, L/2), -C);
+
+    // Moments where nothing else starts a section still split the forces
+    DistributedForce udl[] = { { 0, L, {3} } };
+    ejtest_expect_bool(&R, solveBeam(&forceOnly, NULL, 0, udl, 1), true);
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .distributedForces = udl, .dfCount = 1, .pointMoments = pm, .pmCount = 1 }), true);
+    ejtest_expect_int(&R, beam.sections_count, forceOnly.sections_count + 1);
+    ejtest_expect_float(&R, beam.wall_reaction_force, forceOnly.wall_reaction_force);
+    ejtest_expect_float(&R, momentAt(&beam, a/2), evalSectionsAt(forceOnly.moments, forceOnly.sections_count, a/2) - C);
+    ejtest_expect_float(&R, momentAt(&beam, 1.5), evalSectionsAt(forceOnly.moments, forceOnly.sections_count, 1.5));
+
+    // Read from the input format
+    char buffer[] = "#B\n2.0\n#PF\n#DF\n0 1 [3]\n#PM\n0.5 2\n#DM\n0 2 [1.5 1]\n\n";
+    PointForces pfs = {0};
+    DistributedForces dfs = {0};
+    PointMoments pms = {0};
+    DistributedMoments dms = {0};
+    FILE * file = fmemopen(buffer, sizeof(buffer), "r");
+    ejtest_expect_bool(&R, read_loads_cli(file, &beam, &pfs, &dfs, &pms, &dms), true);
+    fclose(file);
+    if (ejtest_expect_int(&R, pms.count, 1) && ejtest_expect_int(&R, dms.count, 1))
+    {
+        ejtest_expect_float(&R, pms.items[0].moment, 2);
+        ejtest_expect_float(&R, dms.items[0].end, 2);
+        ejtest_expect_float(&R, dms.items[0].polynomial[1], 1);
+    }
+    ejtest_expect_int(&R, dfs.count, 1);
+    file = fmemopen(buffer, sizeof(buffer), "r");
+    ejtest_expect_bool(&R, read_info_cli(file, &beam, &pfs, &dfs), false);
+    fclose(file);
+    free(pfs.items);
+    free(dfs.items);
+    free(pms.items);
+    free(dms.items);
+} TEST_END();
+// Value of a diagram at x, right of any jump there
+static float diagramAt(const Section sections[], int count, float x)
+{
+    return poly_eval(sections[pw_find(sections, count, x)].polynomial, x);
+}
+TEST_BEGIN(testAxialAndTorsion)
+{
+    const float L = 2, P = 3, Tq = 1.5, q = 2;
+    static Beam beam;
+
+    // Cantilever: the wall takes everything
+    PointForce tip[] = { { L, P } };
+    PointMoment twist[] = { { L/2, Tq } };
+    beam = (Beam){ .length = L };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialPointForces = tip, .apCount = 1,
+                .pointTorques = twist, .ptCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_axial, P);
+    ejtest_expect_float(&R, beam.wall_reaction_torque, Tq);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, L/4), P);
+    ejtest_expect_float(&R, diagramAt(beam.torques, beam.sections_count, L/4), Tq);
+    ejtest_expect_float(&R, diagramAt(beam.torques, beam.sections_count, 3*L/4), 0);
+    ejtest_expect_float(&R, beam.wall_reaction_force, 0);
+
+    // Held at both ends the diagram integrates to 0: N = qL/2 - qx
+    DistributedForce along[] = { { 0, L, {q} } };
+    beam = (Beam){ .length = L, .supports = { SUPPORT_PIN, SUPPORT_PIN } };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialDistributedForces = along, .adCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_axial, q*L/2);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, L/4), q*L/4);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, L), -q*L/2);
+
+    // A roller slides, the pin takes the axial force. Pin and roller both
+    // hold the twist
+    DistributedMoment spread[] = { { 0, L, {q} } };
+    PointForce middle[] = { { L/2, P } };
+    beam = (Beam){ .length = L, .supports = { SUPPORT_PIN, SUPPORT_ROLLER } };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialPointForces = middle, .apCount = 1,
+                .distributedTorques = spread, .dtCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_axial, P);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, 3*L/4), 0);
+    ejtest_expect_float(&R, beam.wall_reaction_torque, q*L/2);
+    beam = (Beam){ .length = L, .supports = { SUPPORT_ROLLER, SUPPORT_PIN } };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialPointForces = middle, .apCount = 1 }), true);
+    ejtest_expect_float(&R, beam.wall_reaction_axial, 0);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, 3*L/4), -P);
+
+    // Nothing holds it along the beam: only loads that balance solve
+    PointForce pair[] = { { L/4, P }, { 3*L/4, -P } };
+    beam = (Beam){ .length = L, .supports = { SUPPORT_ROLLER, SUPPORT_ROLLER } };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialPointForces = middle, .apCount = 1 }), false);
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .axialPointForces = pair, .apCount = 2 }), true);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, L/2), -P);
+    ejtest_expect_float(&R, diagramAt(beam.axials, beam.sections_count, 7*L/8), 0);
+
+    // Bending does not change, the axial loads only add breakpoints
+    PointForce down[] = { { 0.3, 2 } };
+    beam = (Beam){ .length = L, .supports = { SUPPORT_PIN, SUPPORT_ROLLER } };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointForces = down, .pfCount = 1,
+                .axialPointForces = middle, .apCount = 1 }), true);
+    ejtest_expect_int(&R, beam.sections_count, 3);
+    ejtest_expect_float(&R, beam.wall_reaction_force, 2*(L - 0.3)/L);
+    ejtest_expect_float(&R, momentAt(&beam, L/2), 2*0.3*(L - L/2)/L);
+
+    // Read from the input format
+    char buffer[] = "#B\n2.0\n#PF\n#DF\n#PA\n1 3\n#DA\n0 2 [2]\n#PT\n1 1.5\n#DT\n0 1 [1 1]\n\n";
+    PointForces pfs = {0}, pas = {0};
+    DistributedForces dfs = {0}, das = {0};
+    PointMoments pts = {0};
+    DistributedMoments dts = {0};
+    FILE * file = fmemopen(buffer, sizeof(buffer), "r");
+    CaseArrays arrays = { .pfs = &pfs, .dfs = &dfs, .pas = &pas, .das = &das, .pts = &pts, .dts = &dts };
+    ejtest_expect_bool(&R, read_case_cli(file, &beam, &arrays), true);
+    fclose(file);
+    ejtest_expect_int(&R, pas.count, 1);
+    ejtest_expect_int(&R, das.count, 1);
+    ejtest_expect_int(&R, pts.count, 1);
+    if (ejtest_expect_int(&R, dts.count, 1)) ejtest_expect_float(&R, dts.items[0].polynomial[1], 1);
+    file = fmemopen(buffer, sizeof(buffer), "r");
+    ejtest_expect_bool(&R, read_loads_cli(file, &beam, &pfs, &dfs, NULL, NULL), false);
+    fclose(file);
+    free(pfs.items);
+    free(dfs.items);
+    free(pas.items);
+    free(das.items);
+    free(pts.items);
+    free(dts.items);
+} TEST_END();
+TEST_BEGIN(testQuery)
+{
+    // Cantilever under a uniform load, point forces at 0.5 and at the free
+    // end and a point moment at 1: V = 7 - x, less 3 past 0.5
+    const float L = 2;
+    PointForce pfs[] = { { 0.5, 3 }, { L, 2 } };
+    DistributedForce udl[] = { { 0, L, {1} } };
+    PointMoment pm[] = { { 1, 1 } };
+    static Beam beam;
+    beam = (Beam){ .length = L };
+    ejtest_expect_bool(&R, solveLoads(&beam, (BeamLoads){ .pointForces = pfs, .pfCount = 2,
+                .distributedForces = udl, .dfCount = 1, .pointMoments = pm, .pmCount = 1 }), true);
+
+    QueryLimits v = query_beam_at(&beam, DIAGRAM_SHEAR, 0);
+    ejtest_expect_float(&R, v.left, 7);
+    ejtest_expect_float(&R, v.right, 7);
+    v = query_beam_at(&beam, DIAGRAM_SHEAR, 0.5);
+    ejtest_expect_float(&R, v.left, 6.5);
+    ejtest_expect_float(&R, v.right, 3.5);
+    v = query_beam_at(&beam, DIAGRAM_SHEAR, 1.25);
+    ejtest_expect_float(&R, v.left, 7 - 1.25 - 3);
+    ejtest_expect_float(&R, v.right, v.left);
+    v = query_beam_at(&beam, DIAGRAM_SHEAR, L);
+    ejtest_expect_float(&R, v.left, 2);
+    ejtest_expect_float(&R, v.right, 0);
+    v = query_beam_at(&beam, DIAGRAM_MOMENT, 1);
+    ejtest_expect_float(&R, v.right - v.left, 1);
+    ejtest_expect_float(&R, query_beam_at(&beam, DIAGRAM_MOMENT, L).left, 0);
+
+    // Sorted batches walk, everything else searches: both agree with single
+    // queries, breakpoints included
+    enum { STATIONS = 10001 };
+    static float xs[STATIONS], left[STATIONS], right[STATIONS];
+    for (int i = 0; i < STATIONS; i++) xs[i] = L*i/(STATIONS - 1);
+    xs[STATIONS/4] = 0.5;
+    int mismatches = 0;
+    for (int order = 0; order < 2; order++)
+    {
+        query_beam_sorted(&beam, DIAGRAM_SHEAR, xs, STATIONS, left, right);
+        for (int i = 0; i < STATIONS; i++)
+        {
+            QueryLimits single = query_beam_at(&beam, DIAGRAM_SHEAR, xs[i]);
+            mismatches += single.left != left[i] || single.right != right[i];
+        }
+        // Then backwards
+        for (int i = 0; i < STATIONS/2; i++)
+        {
+            float t = xs[i];
+            xs[i] = xs[STATIONS-1 - i];
+            xs[STATIONS-1 - i] = t;
+        }
+    }
+    ejtest_expect_int(&R, mismatches, 0);
+    query_beam_sorted(&beam, DIAGRAM_MOMENT, xs, STATIONS, NULL, right);
+    ejtest_expect_float(&R, right[0], beam.wall_reaction_moment);
+    ejtest_expect_float(&R, right[STATIONS-1], 0);
+
+    // Same through libsomp
+    LibsompSolver * solver = libsomp_solver_new();
+    ejtest_expect_int(&R, libsomp_version(), LIBSOMP_VERSION_MAJOR*1000 + 2);
+    ejtest_expect_int(&R, libsomp_sample(solver, LIBSOMP_SECTIONS_SHEAR, xs, 1, NULL, right), LIBSOMP_ERROR_NOT_SOLVED);
+    ejtest_expect_int(&R, libsomp_solve(solver, L, (LibsompPointForce *) pfs, 2, (LibsompDistributedForce *) udl, 1), LIBSOMP_OK);
+    float stations[] = { 0.25, 0.5, 1.5 }, before[3] = {0}, after[3] = {0};
+    ejtest_expect_int(&R, libsomp_sample(solver, LIBSOMP_SECTIONS_SHEAR, stations, 3, before, after), LIBSOMP_OK);
+    ejtest_expect_float(&R, after[0], libsomp_shear_at(solver, 0.25));
+    ejtest_expect_float(&R, before[1], 6.5);
+    ejtest_expect_float(&R, after[1], libsomp_shear_at(solver, 0.5));
+    ejtest_expect_float(&R, after[2], libsomp_shear_at(solver, 1.5));
+    // Close to the point force is not on it, no jump on either side
+    float near[] = { 0.5f - 3e-4f, 0.5f + 3e-4f };
+    ejtest_expect_int(&R, libsomp_sample(solver, LIBSOMP_SECTIONS_SHEAR, near, 2, before, after), LIBSOMP_OK);
+    ejtest_expect_float(&R, before[0], 7 - near[0]);
+    ejtest_expect_float(&R, after[0], before[0]);
+    ejtest_expect_float(&R, after[0], libsomp_shear_at(solver, near[0]));
+    ejtest_expect_float(&R, before[1], 7 - near[1] - 3);
+    ejtest_expect_float(&R, after[1], before[1]);
+    ejtest_expect_float(&R, after[1], libsomp_shear_at(solver, near[1]));
+    ejtest_expect_int(&R, libsomp_sample(solver, LIBSOMP_SECTIONS_LOAD, stations, 3, NULL, after), LIBSOMP_ERROR_ARGUMENT);
+    libsomp_solver_free(solver);
+} TEST_END();
+TEST_BEGIN(testBiaxialBending)
+{
+    // Both planes at once have to match two uniaxial solves
+    const float L = 4;
+    const BeamSupports pinned = { SUPPORT_PIN, SUPPORT_ROLLER };
+    BiaxialPointForce bpfs[] = { { 1, {3, 0} }, { 2.5, {0, 1} }, { L, {5, 2} } };
+    BiaxialDistributedForce bdfs[] = {
+        { 0.5, 3, { {2, 0}, {0, 0} } },
+        { 1, L, { {0, 0}, {0, 1} } },
+    };
+    PointForce ypfs[] = { { 1, 3 }, { L, 5 } }, zpfs[] = { { 2.5, 1 }, { L, 2 } };
+    DistributedForce ydfs[] = { { 0.5, 3, {2, 0} } }, zdfs[] = { { 1, L, {0, 1} } };
+
+    SolverContext ctx;
+    initSolverContext(&ctx);
+    static BiaxialBeam biaxial;
+    biaxial = (BiaxialBeam){ .length = L, .supports = pinned };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, bpfs, 3, bdfs, 2), true);
+    static Beam y, z;
+    y = (Beam){ .length = L, .supports = pinned };
+    z = (Beam){ .length = L, .supports = pinned };
+    ejtest_expect_bool(&R, solveBeamCtx(&ctx, &y, ypfs, 2, ydfs, 1), true);
+    ejtest_expect_bool(&R, solveBeamCtx(&ctx, &z, zpfs, 2, zdfs, 1), true);
+    ejtest_expect_float(&R, biaxial.wallReactionForce[LANE_Y], y.wall_reaction_force);
+    ejtest_expect_float(&R, biaxial.wallReactionForce[LANE_Z], z.wall_reaction_force);
+    ejtest_expect_float(&R, biaxial.endReactionForce[LANE_Y], y.end_reaction_force);
+    ejtest_expect_float(&R, biaxial.endReactionForce[LANE_Z], z.end_reaction_force);
+    // One set of sections over the events of both planes
+    ejtest_expect_int(&R, biaxial.sectionsCount, 6);
+    for (float x = 0; x <= L; x += 0.125)
+    {
+        float moments[BIAXIAL_LANES];
+        biaxialMomentsAt(&biaxial, x, moments);
+        ejtest_expect_float(&R, moments[LANE_Y], momentAt(&y, x));
+        ejtest_expect_float(&R, moments[LANE_Z], momentAt(&z, x));
+    }
+
+    // Cantilever with a sideways force at the tip, only the z plane bends
+    const float P = 2, b = 0.1, h = 0.2;
+    const BiaxialCrossSection rect = rectangularCrossSection(b, h);
+    ejtest_expect_float(&R, rect.Izz, b*h*h*h/12);
+    BiaxialPointForce tip[] = { { L, {0, P} } };
+    biaxial = (BiaxialBeam){ .length = L, .supports = { SUPPORT_FIXED, SUPPORT_FREE } };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, tip, 1, NULL, 0), true);
+    ejtest_expect_float(&R, biaxial.wallReactionForce[LANE_Z], P);
+    ejtest_expect_float(&R, biaxial.wallReactionMoment[LANE_Z], -P*L);
+    ejtest_expect_float(&R, biaxial.wallReactionMoment[LANE_Y], 0);
+    float moments[BIAXIAL_LANES], stresses[BIAXIAL_CORNERS];
+    biaxialMomentsAt(&biaxial, 0, moments);
+    cornerStresses(&rect, moments, stresses);
+    // Hogging in z: tension on the +z side
+    const float sigma = P*L*(b/2)/rect.Iyy;
+    ejtest_expect_float(&R, stresses[0] / sigma, 1);
+    ejtest_expect_float(&R, stresses[1] / sigma, -1);
+    ejtest_expect_float(&R, stresses[2] / sigma, -1);
+    ejtest_expect_float(&R, stresses[3] / sigma, 1);
+
+    // Simple beam, both planes loaded in the middle: the corners add up there
+    BiaxialPointForce middle[] = { { L/2, {4, 1} } };
+    biaxial = (BiaxialBeam){ .length = L, .supports = pinned };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, middle, 1, NULL, 0), true);
+    float where;
+    const float peak = biaxialPeakStress(&biaxial, &rect, 101, &where);
+    const float expected = 4*L/4*(h/2)/rect.Izz + 1*L/4*(b/2)/rect.Iyy;
+    ejtest_expect_float(&R, fabsf(peak) / expected, 1);
+    ejtest_expect_float(&R, where, L/2);
+
+    // Loads past the end are dropped, a free-free beam cannot be solved
+    BiaxialPointForce outside[] = { { L + 1, {1, 1} } };
+    biaxial = (BiaxialBeam){ .length = L, .supports = pinned };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, outside, 1, NULL, 0), true);
+    ejtest_expect_int(&R, biaxial.sectionsCount, 1);
+    ejtest_expect_float(&R, biaxial.wallReactionForce[LANE_Y], 0);
+    biaxial = (BiaxialBeam){ .length = L, .supports = { SUPPORT_FREE, SUPPORT_FREE } };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, middle, 1, NULL, 0), false);
+    // More events than sections
+    BiaxialPointForce crowded[MAX_SECTIONS + 1];
+    for (int i = 0; i < MAX_SECTIONS + 1; i++) crowded[i] = (BiaxialPointForce){ 0.1f*(i+1), {1, 0} };
+    biaxial = (BiaxialBeam){ .length = L, .supports = pinned };
+    ejtest_expect_bool(&R, solveBiaxialBeam(&ctx, &biaxial, crowded, MAX_SECTIONS + 1, NULL, 0), false);
+    freeSolverContext(&ctx);
+} TEST_END();
+TEST_BEGIN(testDaemonProtocol)
+{
+    PointForce pfs[] = { { 0.0, 1 }, { 0.25, 2 }, { 0.5, 3 }, { 1.0, 4 } };
+    DistributedForce dfs[] = { { 0, 0.5, {1,0} }, { 0.25, 0.75, {2,1} } };
+    Beam expected = { .length = 1.0 };
+    solveBeam(&expected, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs));
+
+    // Two pipelined requests, the second one cut short
+    SompBuffer requests = {0}, responses = {0};
+    ejtest_expect_bool(&R, somp_encode_request(&requests, 7, 1.0, (BeamSupports){0}, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs)), true);
+    ejtest_expect_bool(&R, somp_encode_request(&requests, 8, 1.0, (BeamSupports){0}, pfs, ArrayCount(pfs), dfs, ArrayCount(dfs)), true);
+    long first = somp_frame_size(requests.items, requests.count);
+    ejtest_expect_int(&R, first*2, requests.count);
+    ejtest_expect_int(&R, somp_frame_size(requests.items + first, first-1), 0);
+
+    SompSolveContext sc;
+    initSompSolveContext(&sc);
+    ejtest_expect_bool(&R, somp_handle_request(&sc, requests.items + sizeof(uint32_t), first - sizeof(uint32_t),
+                &responses, somp_now_ns()), true);
+
+    SompResponseHeader header = {0};
+    Beam beam = {0};
+    long frame = somp_frame_size(responses.items, responses.count);
+    ejtest_expect_int(&R, frame, responses.count);
+    if (ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), frame - sizeof(uint32_t), &header, &beam), true))
+    {
+        ejtest_expect_int(&R, header.id, 7);
+        ejtest_expect_int(&R, header.status, SOMP_STATUS_OK);
+        ejtest_expect_float(&R, beam.wall_reaction_force, expected.wall_reaction_force);
+        ejtest_expect_float(&R, beam.wall_reaction_moment, expected.wall_reaction_moment);
+        ejtest_expect_int(&R, beam.sections_count, expected.sections_count);
+        ejtest_expect_bool(&R, memcmp(beam.moments, expected.moments, expected.sections_count*sizeof(Section)) == 0, true);
+    }
+
+    // A payload that does not add up still gets an answer
+    responses.count = 0;
+    ejtest_expect_bool(&R, somp_handle_request(&sc, requests.items + sizeof(uint32_t), first - sizeof(uint32_t) - 1,
+                &responses, somp_now_ns()), true);
+    if (ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), responses.count - sizeof(uint32_t), &header, NULL), true))
+        ejtest_expect_int(&R, header.status, SOMP_STATUS_BAD_REQUEST);
+
+    // The supports go over the wire, the end reactions come back
+    PointForce middle[] = { { 2, 10 } };
+    requests.count = responses.count = 0;
+    ejtest_expect_bool(&R, somp_encode_request(&requests, 9, 4.0, (BeamSupports){ SUPPORT_PIN, SUPPORT_ROLLER },
+                middle, 1, NULL, 0), true);
+    ejtest_expect_bool(&R, somp_handle_request(&sc, requests.items + sizeof(uint32_t), requests.count - sizeof(uint32_t),
+                &responses, somp_now_ns()), true);
+    if (ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), responses.count - sizeof(uint32_t), &header, &beam), true))
+    {
+        ejtest_expect_int(&R, header.status, SOMP_STATUS_OK);
+        ejtest_expect_float(&R, beam.wall_reaction_force, 5);
+        ejtest_expect_float(&R, beam.wall_reaction_moment, 0);
+        ejtest_expect_float(&R, beam.end_reaction_force, 5);
+        ejtest_expect_float(&R, beam.end_reaction_moment, 0);
+    }
+    // Supports that do not hold the beam are a bad request
+    requests.count = responses.count = 0;
+    ejtest_expect_bool(&R, somp_encode_request(&requests, 10, 4.0, (BeamSupports){ SUPPORT_FREE, SUPPORT_FREE },
+                middle, 1, NULL, 0), true);
+    ejtest_expect_bool(&R, somp_handle_request(&sc, requests.items + sizeof(uint32_t), requests.count - sizeof(uint32_t),
+                &responses, somp_now_ns()), true);
+    if (ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), responses.count - sizeof(uint32_t), &header, NULL), true))
+        ejtest_expect_int(&R, header.status, SOMP_STATUS_BAD_REQUEST);
+
+    // Another version is told apart from a bad request, on both ends
+    requests.count = responses.count = 0;
+    ejtest_expect_bool(&R, somp_encode_request(&requests, 11, 4.0, (BeamSupports){0}, middle, 1, NULL, 0), true);
+    uint32_t other = SOMP_PROTOCOL_VERSION + 1;
+    memcpy(requests.items + sizeof(uint32_t) + offsetof(SompRequestHeader, version), &other, sizeof(other));
+    ejtest_expect_bool(&R, somp_handle_request(&sc, requests.items + sizeof(uint32_t), requests.count - sizeof(uint32_t),
+                &responses, somp_now_ns()), true);
+    if (ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), responses.count - sizeof(uint32_t), &header, NULL), true))
+        ejtest_expect_int(&R, header.status, SOMP_STATUS_BAD_VERSION);
+    memcpy(responses.items + sizeof(uint32_t) + offsetof(SompResponseHeader, version), &other, sizeof(other));
+    ejtest_expect_bool(&R, somp_decode_response(responses.items + sizeof(uint32_t), responses.count - sizeof(uint32_t), &header, NULL), false);
+    ejtest_expect_int(&R, header.version, other);
+
+    uint32_t huge = SOMP_MAX_FRAME + 1;
+    ejtest_expect_int(&R, somp_frame_size((unsigned char *) &huge, sizeof(huge)), -1);
+
+    freeSompSolveContext(&sc);
+    free(requests.items);
+    free(responses.items);
+} TEST_END();
+TEST_BEGIN(testSortedEventsLarge)
+{
+    // Big enough to go through the radix sort
+    enum { PF_COUNT = 100, DF_COUNT = 70, SECTIONS = 400 };
+    PointForce pfs[PF_COUNT], pfs_sorted[PF_COUNT];
+    DistributedForce dfs[DF_COUNT];
+    static Section sections[SECTIONS], expected[SECTIONS];
+
+    // Shuffle with a fixed step so the order is mixed up but repeatable
+    for (int i = 0; i < PF_COUNT; i++)
+    {
+        int k = (i*37) % PF_COUNT;
+        pfs[i] = (PointForce){ k/(float)PF_COUNT, k+1 };
+        pfs_sorted[k] = pfs[i];
+    }
+    for (int i = 0; i < DF_COUNT; i++)
+    {
+        int k = (i*29) % DF_COUNT;
+        dfs[i] = (DistributedForce){ k/(float)(2*DF_COUNT), 0.5 + k/(float)(3*DF_COUNT), {1+k, 0} };
+    }
+
+    int count = SECTIONS;
+    int expected_count = SECTIONS;
+    ejtest_expect_bool(&R, seperateBeamIntoSections(1.0, pfs, PF_COUNT, dfs, DF_COUNT, sections, &count), true);
+    ejtest_expect_bool(&R, seperateBeamIntoSections(1.0, pfs_sorted, PF_COUNT, dfs, DF_COUNT, expected, &expected_count), true);
+
+    // Caller's array is left in its original order
+    ejtest_expect_float(&R, pfs[1].distance, 37/(float)PF_COUNT);
+
+    if (ejtest_expect_int(&R, count, expected_count))
+    {
+        for (int i = 0; i < count; i++) ejtest_expect_struct(&R, sections[i], expected[i], comp_sections);
+    }
+
+    // Too many sections for the buffer should fail without writing past it
+    count = MAX_SECTIONS;
+    ejtest_expect_bool(&R, seperateBeamIntoSections(1.0, pfs, PF_COUNT, dfs, DF_COUNT, sections, &count), false);
+} TEST_END();
+TEST_BEGIN(testSortedForceContainers)
+{
+    SortedPointForces pfs = {0};
+
+    ForceHandle a = sorted_pf_insert(&pfs, (PointForce){ 0.5, 1 });
+    ForceHandle b = sorted_pf_insert(&pfs, (PointForce){ 0.25, 2 });
+    ForceHandle c = sorted_pf_insert(&pfs, (PointForce){ 0.75, 3 });
+    ejtest_expect_float(&R, pfs.forces.items[0].distance, 0.25);
+    ejtest_expect_float(&R, pfs.forces.items[1].distance, 0.5);
+    ejtest_expect_float(&R, pfs.forces.items[2].distance, 0.75);
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, a)->force, 1);
+
+    // Move the first force past the others, handles follow it
+    ejtest_expect_bool(&R, sorted_pf_modify(&pfs, b, (PointForce){ 0.9, 2 }), true);
+    ejtest_expect_float(&R, pfs.forces.items[2].distance, 0.9);
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, b)->distance, 0.9);
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, c)->distance, 0.75);
+    ejtest_expect_int(&R, pfs.handles.items[0], a);
+
+    ejtest_expect_bool(&R, sorted_pf_remove(&pfs, a), true);
+    ejtest_expect_bool(&R, sorted_pf_remove(&pfs, a), false);
+    ejtest_expect_bool(&R, sorted_pf_get(&pfs, a) == NULL, true);
+    ejtest_expect_int(&R, pfs.forces.count, 2);
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, c)->force, 3);
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, b)->force, 2);
+
+    // Enough inserts to realloc, handles still find their forces
+    for (int i = 0; i < 50; i++) sorted_pf_insert(&pfs, (PointForce){ (i*7 % 50)/50.0, i });
+    for (int i = 1; i < pfs.forces.count; i++)
+    {
+        ejtest_expect_bool(&R, pfs.forces.items[i-1].distance <= pfs.forces.items[i].distance, true);
+    }
+    ejtest_expect_float(&R, sorted_pf_get(&pfs, c)->distance, 0.75);
+
+    SortedDistrForces dfs = {0};
+    ForceHandle d = sorted_df_insert(&dfs, (DistributedForce){ 0.5, 1.0, {1, 0} });
+    ForceHandle e = sorted_df_insert(&dfs, (DistributedForce){ 0.0, 0.5, {2, 0} });
+    ejtest_expect_float(&R, dfs.forces.items[0].start, 0.0);
+    sorted_df_modify(&dfs, e, (DistributedForce){ 0.75, 1.0, {2, 0} });
+    ejtest_expect_float(&R, dfs.forces.items[0].start, 0.5);
+    ejtest_expect_float(&R, sorted_df_get(&dfs, d)->polynomial[0], 1);
+    ejtest_expect_float(&R, sorted_df_get(&dfs, e)->polynomial[0], 2);
+
+    sorted_pf_free(&pfs);
+    sorted_df_free(&dfs);
+} TEST_END();
+TEST_BEGIN(testPointForcesSamePlace)
+{
+    Beam beam = { .length = 3 };
+    PointForce pfs[] = { { 1, 27 }, { 1, 78 }, { 2, 5 } };
+
+    ejtest_expect_bool(&R, solveBeam(&beam, pfs, 3, NULL, 0), true);
+    // Both forces at x = 1 count, not only the last one read
+    ejtest_expect_float(&R, beam.wall_reaction_force, 110);
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -(27 + 78 + 2*5));
+    ejtest_expect_float(&R, beam.raws[1].pointForce, 105);
+} TEST_END();
+// ref_check_case with a made up bug, for the shrinker
+bool checkHeavyPointForces(SolverContext * ctx, const RefCase * c, RefResult * result)
+{
+    if (!ref_check_case(ctx, c, result)) return false;
+    for (int i = 0; i < c->pfCount; i++)
+    {
+        if (c->pfs[i].force <= 15) continue;
+        *result = (RefResult){ .failed = true, .what = "heavy point force", .x = c->pfs[i].distance };
+        return false;
+    }
+    return true;
+}
+TEST_BEGIN(testReferenceSolver)
+{
+    // The reference on its own: 2kN/m over [0, 3] needs 6kN and 9kNm at
+    // the wall, and nothing is left at the free end
+    RefCase c = { .length = 3, .dfCount = 1 };
+    c.dfs[0] = (DistributedForce){ 0, 3, { 2 } };
+    RefReactions r = ref_reactions(&c);
+    ejtest_expect_float(&R, r.reactionForce, 6);
+    ejtest_expect_float(&R, r.reactionMoment, -9);
+    ejtest_expect_float(&R, ref_shear(&c, r, 3), 0);
+    ejtest_expect_float(&R, ref_moment(&c, r, 3), 0);
+    ejtest_expect_float(&R, ref_moment(&c, r, 1.5), -2.25);
+
+    // A few thousand random beams, somp_diff.out runs millions
+    SolverContext ctx;
+    initSolverContext(&ctx);
+    int failed = 0;
+    for (uint64_t seed = 1; seed <= 5000; seed++)
+    {
+        uint64_t state = seed;
+        ref_generate_case(&state, &c);
+        RefResult result;
+        if (ref_check_case(&ctx, &c, &result)) continue;
+        if (failed++ == 0)
+        {
+            printf("Seed %llu: %s\n", (unsigned long long) seed, result.what);
+            ref_print_case(stdout, &c);
+        }
+    }
+    ejtest_expect_int(&R, failed, 0);
+
+    // Shrinking only touches beams that fail
+    c = (RefCase){ .length = 4, .pfCount = 3 };
+    c.pfs[0] = (PointForce){ 1.25, 10 };
+    c.pfs[1] = (PointForce){ 2.5, 20 };
+    c.pfs[2] = (PointForce){ 3.75, 30 };
+    RefResult result;
+    ejtest_expect_bool(&R, ref_check_case(&ctx, &c, &result), true);
+    ref_shrink_case(&ctx, &c);
+    ejtest_expect_int(&R, c.pfCount, 3);
+
+    // A solver that loses point forces over 15 is shrunk down to the one
+    // heavy force, with whole numbers
+    c = (RefCase){ .length = 4.3, .pfCount = 3, .dfCount = 1 };
+    c.pfs[0] = (PointForce){ 1.25, 10 };
+    c.pfs[1] = (PointForce){ 2.5, 20.4 };
+    c.pfs[2] = (PointForce){ 3.75, 30.2 };
+    c.dfs[0] = (DistributedForce){ 0.5, 2.2, { 1.5 } };
+    ejtest_expect_bool(&R, checkHeavyPointForces(&ctx, &c, &result), false);
+    ref_shrink_case_with(&ctx, &c, checkHeavyPointForces);
+    ejtest_expect_float(&R, c.length, 4);
+    ejtest_expect_int(&R, c.dfCount, 0);
+    if (ejtest_expect_int(&R, c.pfCount, 1))
+    {
+        ejtest_expect_float(&R, c.pfs[0].distance, 3);
+        ejtest_expect_float(&R, c.pfs[0].force, 20);
+    }
+    ejtest_expect_bool(&R, checkHeavyPointForces(&ctx, &c, &result), false);
+    ejtest_expect_bool(&R, strcmp(result.what, "heavy point force") == 0, true);
+
+    freeSolverContext(&ctx);
+} TEST_END();
+TEST_BEGIN(testHitIndex)
+{
+    SortedPointForces pfs = {0};
+    SortedDistrForces dfs = {0};
+    HitRect viewport = { 0, 0, 100, 100 };
+    HitIndex index = {0};
+
+    ejtest_expect_bool(&R, hit_index_stale(&index, &pfs, &dfs, 1, viewport), true);
+    hit_index_begin(&index, &pfs, &dfs, 1, viewport);
+    // Added out of order and one wide rect so the query has to look back
+    hit_index_add(&index, (HitRect){ 50, 0, 8, 40 }, HIT_POINT_FORCE, 0);
+    hit_index_add(&index, (HitRect){ 10, 0, 8, 40 }, HIT_DISTR_START, 1);
+    hit_index_add(&index, (HitRect){ 0, 60, 80, 10 }, HIT_DISTR_END, 2);
+    hit_index_add(&index, (HitRect){ 52, 0, 8, 40 }, HIT_POINT_FORCE, 3);
+    hit_index_build(&index);
+    ejtest_expect_bool(&R, hit_index_stale(&index, &pfs, &dfs, 1, viewport), false);
+
+    HitItem hit = hit_index_query(&index, 14, 20);
+    ejtest_expect_int(&R, hit.kind, HIT_DISTR_START);
+    ejtest_expect_int(&R, hit.handle, 1);
+
+    ejtest_expect_int(&R, hit_index_query(&index, 70, 65).handle, 2);
+    ejtest_expect_int(&R, hit_index_query(&index, 30, 20).kind, HIT_NONE);
+    ejtest_expect_int(&R, hit_index_query(&index, 30, 20).handle, NO_FORCE_HANDLE);
+
+    // Overlapping rects, the one centred closest to the mouse wins
+    ejtest_expect_int(&R, hit_index_query(&index, 53, 20).handle, 0);
+    ejtest_expect_int(&R, hit_index_query(&index, 57, 20).handle, 3);
+
+    // Any change to the forces or the viewport needs a rebuild
+    sorted_pf_insert(&pfs, (PointForce){ 0.5, 1 });
+    ejtest_expect_bool(&R, hit_index_stale(&index, &pfs, &dfs, 1, viewport), true);
+    hit_index_begin(&index, &pfs, &dfs, 1, viewport);
+    hit_index_build(&index);
+    ejtest_expect_bool(&R, hit_index_stale(&index, &pfs, &dfs, 1, viewport), false);
+    viewport.w = 200;
+    ejtest_expect_bool(&R, hit_index_stale(&index, &pfs, &dfs, 1, viewport), true);
+    ejtest_expect_int(&R, hit_index_query(&index, 53, 20).kind, HIT_NONE);
+
+    hit_index_free(&index);
+    sorted_pf_free(&pfs);
+    sorted_df_free(&dfs);
+} TEST_END();
 #define TEST_DIR_NAME "./tests"
 
 TEST_BEGIN(testDoubleSameSolve)
@@ -314,7 +1522,10 @@ void testExample_6_2()
             distrib_forces.items, distrib_forces.count);
 
     ejtest_expect_float(&R, beam.wall_reaction_force, 3.0);
-    ejtest_expect_float(&R, beam.wall_reaction_moment, -4.5);
+    // The triangular load (resultant 3) acts at its centroid x = 2, not at
+    // the middle of the beam, so the wall holds 3*2 = 6 and not 3*1.5
+    // (the free end only has zero moment with -6)
+    ejtest_expect_float(&R, beam.wall_reaction_moment, -6.0);
     ejtest_expect_struct(&R, beam.raws[0], expected_raw, comp_sections);
     ejtest_expect_struct(&R, beam.shears[0], expected_shear, comp_sections);
 
@@ -334,6 +1545,19 @@ void testReadBeamInput()
     
     ejtest_expect_float(&R, beam.length, expected_beam.length);
     ejtest_expect_int(&R, beam.sections_count, expected_beam.sections_count);
+    ejtest_expect_int(&R, beam.supports.left, SUPPORT_DEFAULT);
+
+    char supported[] = "2.5 pin fixed\n";
+    ejtest_expect_bool(&R, read_beam_info_cli(supported, &beam), true);
+    ejtest_expect_float(&R, beam.length, 2.5);
+    ejtest_expect_int(&R, beam.sections_count, MAX_SECTIONS);
+    ejtest_expect_int(&R, beam.supports.left, SUPPORT_PIN);
+    ejtest_expect_int(&R, beam.supports.right, SUPPORT_FIXED);
+
+    char one_support[] = "1.0 10 roller\n";
+    ejtest_expect_bool(&R, read_beam_info_cli(one_support, &beam), false);
+    char bad_support[] = "1.0 10 roller glue\n";
+    ejtest_expect_bool(&R, read_beam_info_cli(bad_support, &beam), false);
 
     ejtest_print_result("testReadBeamInput", R);
 }
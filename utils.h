@@ -12,19 +12,99 @@
 #define ArrayCount(array) (sizeof(array)/sizeof(array[0])) // NOTE: this only works in same scope as when the array was made
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #define DEFAULT_DA_CAPACITY 8
+
+// Dynamic arrays are any struct with items, count and capacity (count and
+// capacity are ints). Growth doubles the capacity so n appends cost O(log n)
+// reallocations, and a failed realloc leaves the array as it was
+
+// Make room for at least n items in total
+// Returns: false if the memory could not be allocated
+#define DynamicArrayReserve(da, n) \
+    da_reserve((void **) &(da)->items, &(da)->capacity, (n), sizeof((da)->items[0]))
+
+// Returns: false if the item could not be appended
+#define DynamicArrayTryAppend(da, item) \
+    (DynamicArrayReserve((da), (da)->count+1) \
+        ? ((da)->items[(da)->count++] = (item), true) \
+        : false)
+
+// Aborts when the item could not be appended, also with NDEBUG
 #define DynamicArrayAppend(da, item) \
     do { \
-        if ((da)->count >= (da)->capacity) \
+        if (!DynamicArrayTryAppend((da), (item))) \
         { \
-            if ((da)->capacity == 0) (da)->capacity = DEFAULT_DA_CAPACITY; \
-            else (da)->capacity *= 2; \
-            (da)->items = realloc((da)->items, (da)->capacity*sizeof((da)->items[0])); \
-            assert((da)->items != NULL); \
+            fprintf(stderr, "%s:%d: DynamicArrayAppend: out of memory\n", __FILE__, __LINE__); \
+            abort(); \
         } \
-        (da)->items[(da)->count] = item; \
-        (da)->count++; \
-    } while(0); 
+    } while(0);
+
+// Copies n items from src to the end of the array with a single memcpy
+// Returns: false if the memory could not be allocated
+#define DynamicArrayAppendMany(da, src, n) \
+    da_append_many((void **) &(da)->items, &(da)->count, &(da)->capacity, (src), (n), sizeof((da)->items[0]))
+
+// Gives back the capacity that is not used
+// Returns: false if the smaller block could not be allocated
+#define DynamicArrayShrink(da) \
+    da_shrink((void **) &(da)->items, (da)->count, &(da)->capacity, sizeof((da)->items[0]))
+
+// Empties the array but keeps the memory for the next fill
+#define DynamicArrayClear(da) do { (da)->count = 0; } while (0)
+
+static inline bool da_reserve(void ** items, int * capacity, int n, size_t item_size)
+{
+    if (n <= *capacity) return true;
+
+    int new_capacity = (*capacity == 0) ? DEFAULT_DA_CAPACITY : *capacity;
+    while (new_capacity < n)
+    {
+        if (new_capacity > INT_MAX/2) { new_capacity = n; break; }
+        new_capacity *= 2;
+    }
+
+    void * new_items = realloc(*items, (size_t) new_capacity*item_size);
+    if (new_items == NULL) return false;
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+static inline bool da_append_many(void ** items, int * count, int * capacity,
+        const void * src, int n, size_t item_size)
+{
+    if (n <= 0) return true;
+    if (*count > INT_MAX - n) return false;
+    if (!da_reserve(items, capacity, *count + n, item_size)) return false;
+
+    memcpy((char *) *items + (size_t) *count*item_size, src, (size_t) n*item_size);
+    *count += n;
+    return true;
+}
+
+static inline bool da_shrink(void ** items, int count, int * capacity, size_t item_size)
+{
+    if (count == *capacity) return true;
+    if (count == 0)
+    {
+        free(*items);
+        *items = NULL;
+        *capacity = 0;
+        return true;
+    }
+
+    void * new_items = realloc(*items, (size_t) count*item_size);
+    if (new_items == NULL) return false;
+    *items = new_items;
+    *capacity = count;
+    return true;
+}
 
 #define DynamicArrayRemoveShuffle(da, i) do { \
     assert((i) < (da)->count); \
@@ -42,11 +122,11 @@
 #define MIN(a, b) ((a) < (b)) ? (a) : (b)
 #define MAX(a, b) ((a) > (b)) ? (a) : (b)
 
-float minf(float a, float b)
+static inline float minf(float a, float b)
 {
     return (a < b) ? a : b;
 };
-float maxf(float a, float b)
+static inline float maxf(float a, float b)
 {
     return (a > b) ? a : b;
 };
@@ -59,6 +139,23 @@ struct LL_Node
 
 typedef struct LL_Node LL_Node;
 
+// Linear allocator, everything is freed at once with arena_reset. The buffer
+// only grows in arena_reserve so pointers handed out stay valid until reset
+typedef struct {
+    unsigned char * base;
+    size_t size;
+    size_t used;
+    long heap_calls; // number of times the buffer had to be (re)allocated
+} Arena;
+
+// Fixed size blocks carved out of an arena, released blocks are reused
+// before the arena is asked for more
+typedef struct {
+    Arena * arena;
+    size_t block_size;
+    void * free_list;
+} Pool;
+
 // Array operations
 int ArrayMax(int nums[], int n);
 float ArrayMaxf(float nums[], int n);
@@ -68,8 +165,19 @@ int nearly_equal(float a, float b);
 void printInt(const void * i);
 void line_from_points(float * m, float * c, float ax, float ay, float bx, float by);
 
+// Arena and pool operations
+bool arena_reserve(Arena * arena, size_t size);
+void * arena_alloc(Arena * arena, size_t size);
+void arena_reset(Arena * arena);
+void arena_free(Arena * arena);
+void pool_init(Pool * pool, Arena * arena, size_t block_size);
+void * pool_alloc(Pool * pool);
+void pool_release(Pool * pool, void * block);
+void pool_reset(Pool * pool);
+
 // Generic linked list operations
 void LL_push(LL_Node ** head, void * data);
+void LL_push_node(LL_Node ** head, LL_Node * node, void * data);
 LL_Node * LL_remove(LL_Node ** head, void * data);
 void LL_print(LL_Node * head, void (*printFunc)(const void *) );
 void LL_free(LL_Node * head);
@@ -132,10 +240,92 @@ void printInt(const void * i)
 }
 
 
+// Arena functions
+#define ARENA_ALIGNMENT 16
+#define arena_align(size) (((size) + ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1))
+
+// Makes sure the arena can hold size bytes, only call this when nothing is
+// allocated from the arena since growing it moves the buffer
+bool arena_reserve(Arena * arena, size_t size)
+{
+    assert(arena->used == 0);
+    if (size <= arena->size) return true;
+
+    size_t new_size = (arena->size == 0) ? 256 : arena->size;
+    while (new_size < size) new_size *= 2;
+
+    unsigned char * base = realloc(arena->base, new_size);
+    arena->heap_calls++;
+    if (base == NULL) return false;
+
+    arena->base = base;
+    arena->size = new_size;
+    return true;
+}
+
+// Returns NULL when the arena is full, it never grows here
+void * arena_alloc(Arena * arena, size_t size)
+{
+    size = arena_align(size);
+    if (arena->used + size > arena->size || arena->base == NULL) return NULL;
+
+    void * p = arena->base + arena->used;
+    arena->used += size;
+    return p;
+}
+
+void arena_reset(Arena * arena)
+{
+    arena->used = 0;
+}
+
+void arena_free(Arena * arena)
+{
+    free(arena->base);
+    *arena = (Arena){0};
+}
+
+void pool_init(Pool * pool, Arena * arena, size_t block_size)
+{
+    pool->arena = arena;
+    pool->block_size = (block_size < sizeof(void *)) ? sizeof(void *) : block_size;
+    pool->free_list = NULL;
+}
+
+void * pool_alloc(Pool * pool)
+{
+    if (pool->free_list != NULL)
+    {
+        void * block = pool->free_list;
+        pool->free_list = *(void **) block;
+        return block;
+    }
+    return arena_alloc(pool->arena, pool->block_size);
+}
+
+void pool_release(Pool * pool, void * block)
+{
+    if (block == NULL) return;
+    *(void **) block = pool->free_list;
+    pool->free_list = block;
+}
+
+// Call together with arena_reset of the backing arena
+void pool_reset(Pool * pool)
+{
+    pool->free_list = NULL;
+}
+
 // Linked list functions
 void LL_push(LL_Node ** head, void * data)
 {
 	LL_Node * node = malloc(sizeof(LL_Node));
+	LL_push_node(head, node, data);
+}
+
+// Same as LL_push but the caller provides the memory for the node
+void LL_push_node(LL_Node ** head, LL_Node * node, void * data)
+{
 	node->data = data;
 	node->next = NULL; 
 